@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Table-driven hex codec shared by the keyload plan, the key editor and the
+// benchmarks. Allocation-free: every call writes into a caller buffer.
+// Decoding accepts upper and lower case and skips whitespace (space, tab,
+// CR, LF) anywhere in the input; encoding produces upper case.
+
+enum HexStatus {
+    HEX_OK = 0,
+    HEX_BAD_CHAR,    // character that is neither a hex digit nor whitespace
+    HEX_ODD_DIGITS,  // digit count is not a whole number of bytes
+    HEX_TOO_LONG     // output buffer too small
+};
+
+// Decode len characters of hex into out. On HEX_OK outLen is the number of
+// bytes written; otherwise outLen is 0 and out may be partly written.
+HexStatus hexDecode(const char* hex, size_t len, uint8_t* out, size_t outMax, size_t& outLen);
+
+// Strip whitespace and upper-case hex digits into out (no terminator is
+// written). Same validation as hexDecode, so a canonical string always
+// decodes. outLen is the number of digits written.
+HexStatus hexCanonicalize(const char* hex, size_t len, char* out, size_t outMax, size_t& outLen);
+
+// Encode len bytes as 2 * len upper-case digits plus a NUL terminator.
+// Returns the number of digits written, or 0 if outMax < 2 * len + 1.
+size_t hexEncode(const uint8_t* data, size_t len, char* out, size_t outMax);
+
+const char* hexStatusName(HexStatus s);
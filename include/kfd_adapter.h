@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "kfd_three_wire.h"
+
+class Stream;
+
+// KFDtool adapter emulation: speaks the KFDtool adapter serial protocol on
+// a byte stream (the USB CDC port on the device, a pty on the host), so
+// desktop KFDtool and scripts can use this unit's 3WI line as their
+// hardware front end.
+//
+// Packets are [SOM] body [EOM], both 0x61, with 0x61 and 0x63 in the body
+// escaped as 0x63 0x62 and 0x63 0x64. The body is a command opcode and its
+// arguments; each command gets one response packet, and every byte the
+// line receives from the radio is broadcast as its own packet.
+//
+// Extension: CMD_SEND_BYTE may carry more than one byte; they are clocked
+// out back to back under a single RSP_SEND_BYTE.
+
+// Framing
+static constexpr uint8_t KFD_AP_SOM_EOM             = 0x61;
+static constexpr uint8_t KFD_AP_SOM_EOM_PLACEHOLDER = 0x62;
+static constexpr uint8_t KFD_AP_ESC                 = 0x63;
+static constexpr uint8_t KFD_AP_ESC_PLACEHOLDER     = 0x64;
+
+// Commands and their responses (response = command + 0x10)
+static constexpr uint8_t KFD_AP_CMD_READ          = 0x11;
+static constexpr uint8_t KFD_AP_CMD_WRITE_INFO    = 0x12;
+static constexpr uint8_t KFD_AP_CMD_ENTER_BSL     = 0x13;
+static constexpr uint8_t KFD_AP_CMD_RESET         = 0x14;
+static constexpr uint8_t KFD_AP_CMD_SELF_TEST     = 0x15;
+static constexpr uint8_t KFD_AP_CMD_SEND_KEY_SIG  = 0x16;
+static constexpr uint8_t KFD_AP_CMD_SEND_BYTE     = 0x17;
+static constexpr uint8_t KFD_AP_RSP_ERROR         = 0x20;
+static constexpr uint8_t KFD_AP_RSP_OFFSET        = 0x10;
+static constexpr uint8_t KFD_AP_BCST_RECEIVE_BYTE = 0x31;
+
+// CMD_READ items
+static constexpr uint8_t KFD_AP_READ_AP_VER    = 0x01;
+static constexpr uint8_t KFD_AP_READ_FW_VER    = 0x02;
+static constexpr uint8_t KFD_AP_READ_UNIQUE_ID = 0x03;
+static constexpr uint8_t KFD_AP_READ_MODEL_ID  = 0x04;
+static constexpr uint8_t KFD_AP_READ_HW_REV    = 0x05;
+static constexpr uint8_t KFD_AP_READ_SER_NUM   = 0x06;
+
+// RSP_ERROR codes
+static constexpr uint8_t KFD_AP_ERR_OTHER              = 0x00;
+static constexpr uint8_t KFD_AP_ERR_INVALID_CMD_LENGTH = 0x01;
+static constexpr uint8_t KFD_AP_ERR_INVALID_CMD_OPCODE = 0x02;
+static constexpr uint8_t KFD_AP_ERR_INVALID_READ_ITEM  = 0x03;
+
+static constexpr size_t KFD_AP_MAX_PACKET = 80;    // decoded body
+static constexpr size_t KFD_AP_TX_BUFFER  = 1024;  // encoded, flushed once per service()
+
+// USB CDC ignores the line rate; the value only matters behind a UART
+// bridge. The stream buffers are raised so bulk USB transfers land whole.
+static constexpr unsigned long KFD_AP_BAUD      = 921600;
+static constexpr size_t        KFD_AP_RX_BUFFER = 4096;
+
+class KfdToolAdapter {
+public:
+    KfdToolAdapter(Stream& io, KfdThreeWireTransport& line) : _io(io), _line(line) {}
+
+    // Drop any partial packet and put the line in its safe state.
+    void begin();
+
+    // Non-blocking: take what the host sent, run complete commands, then
+    // broadcast bytes received from the radio. Output goes out in one
+    // write per call. Returns false if there was nothing to do.
+    bool service();
+
+    uint32_t packetsIn() const      { return _packetsIn; }
+    uint32_t bytesToRadio() const   { return _bytesToRadio; }
+    uint32_t bytesFromRadio() const { return _bytesFromRadio; }
+    uint32_t badPackets() const     { return _badPackets; }
+
+private:
+    void rxByte(uint8_t b);
+    void handlePacket(const uint8_t* p, size_t len);
+    void handleRead(uint8_t item);
+    void sendPacket(const uint8_t* body, size_t len);
+    void sendError(uint8_t code);
+    void flush();
+
+    Stream&                _io;
+    KfdThreeWireTransport& _line;
+
+    uint8_t _rx[KFD_AP_MAX_PACKET];
+    size_t  _rxLen    = 0;
+    bool    _inPacket = false;
+    bool    _escape   = false;
+    bool    _overflow = false;
+
+    uint8_t _tx[KFD_AP_TX_BUFFER];
+    size_t  _txLen = 0;
+
+    uint32_t _packetsIn      = 0;
+    uint32_t _bytesToRadio   = 0;
+    uint32_t _bytesFromRadio = 0;
+    uint32_t _badPackets     = 0;
+};
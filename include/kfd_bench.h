@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "container_model.h"
+#include "kfd_radio_emulator.h"
+
+// End-to-end keyload benchmark: drives full KFDProtocol::beginKeyload()
+// sessions against a KfdRadioEmulator and reports throughput and latency.
+// Enable the boot-time run with -DKFD_BENCH_ON_BOOT=1.
+
+struct KfdBenchResult {
+    unsigned sessions;      // sessions completed successfully
+    unsigned failures;      // sessions that exhausted their attempts
+    unsigned retries;       // extra attempts after a failed session
+    unsigned frameRetries;  // single-frame retransmits inside sessions
+    size_t   keysLoaded;
+    float    keysPerSec;
+    uint32_t p50Us;
+    uint32_t p90Us;
+    uint32_t p99Us;
+    uint32_t maxUs;
+};
+
+// Synthetic container with keyCount random AES-256 keys, all selected.
+KeyContainer kfdBenchContainer(size_t keyCount, uint32_t seed);
+
+// Run `sessions` keyloads of kc through an emulator configured with cfg.
+// A failed session is restarted up to maxAttempts times.
+bool kfdRunBench(const KeyContainer& kc, const KfdEmulatorConfig& cfg,
+                 unsigned sessions, unsigned maxAttempts, KfdBenchResult& out);
+
+// Load kc into `ports` emulated radios at once through pinless KFDProtocol
+// ports serviced round-robin, as KfdPortScheduler does. Returns the wall
+// time until the last radio finished, or 0 if any session failed.
+uint32_t kfdRunParallelBench(const KeyContainer& kc, const KfdEmulatorConfig& cfg, size_t ports);
+void     kfdPrintParallelBench(const KeyContainer& kc, size_t ports, uint32_t elapsedUs);
+
+// Print a result block to Serial.
+void kfdPrintBench(const char* name, const KfdBenchResult& r);
+
+// Frame layer microbenchmark: CRC throughput plus encode and one-pass
+// parse cost for a typical AES-256 key frame. Prints to Serial.
+void kfdRunFrameBench(unsigned iterations);
+
+// Hex codec microbenchmark: table-driven hexDecode/hexEncode against the
+// per-character and snprintf("%02X") versions they replaced. Prints to Serial.
+void kfdRunHexBench(unsigned iterations);
+
+// Top-up load: two emulated radios already hold kc, then `changed` of its
+// keys are altered (one of them keeping its CRC-16) and loaded once as a
+// forced full reload and once as a delta load. Prints both times and checks
+// the radios end up identical.
+void kfdRunDeltaBench(const KeyContainer& kc, const KfdEmulatorConfig& cfg, size_t changed);
+
+// Clock negotiation against a radio limited to 130 kbps: a first session
+// that probes, a second that hits the rate cache, and a third on a radio
+// whose limit drops mid-session to 60 kbps. Prints to Serial.
+void kfdRunClockBench(const KeyContainer& kc);
+
+// Line trace overhead: the same emulated sessions with and without edge
+// capture, plus the measured cycles per recorded edge. Prints to Serial.
+void kfdRunTraceBench(const KeyContainer& kc, unsigned sessions);
+
+// DLI over UDP loopback: kc loaded through KfdDliTransport into a
+// KfdDliRadio stand-in answering after latencyUs, stop-and-wait (window 1)
+// and pipelined (window 8), then pipelined with dropPerMille datagrams
+// lost each way. Needs the network stack up. Prints to Serial.
+void kfdRunDliBench(const KeyContainer& kc, uint32_t latencyUs, uint16_t dropPerMille);
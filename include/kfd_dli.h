@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <netinet/in.h>
+
+#include "kfd_frame.h"
+#include "kfd_transport.h"
+
+// Data Link Independent keyloading: the KMM frames that would go over the
+// 3WI line are carried in UDP datagrams to the radio (or a key variable
+// loader proxy) over any IP link. Each datagram is
+//
+//   [version 0x01][seq BE16][encoded frame: SOF | LEN | payload | CRC]
+//
+// and the answer to a frame echoes its seq. Unanswered datagrams are
+// resent with the same seq after rtoUs; the far end answers duplicates
+// from its cache instead of acting on them twice.
+//
+// Uses the BSD socket API (lwIP on the ESP32, the host stack on Linux);
+// the network interface must be up before open().
+
+static constexpr uint8_t  KFD_DLI_VERSION      = 0x01;
+static constexpr size_t   KFD_DLI_HEADER       = 3;
+static constexpr size_t   KFD_DLI_MAX_DATAGRAM = KFD_DLI_HEADER + KFD_FRAME_MAX_PAYLOAD + KFD_FRAME_OVERHEAD;
+static constexpr uint16_t KFD_DLI_DEFAULT_PORT = 49644;
+static constexpr size_t   KFD_DLI_MAX_WINDOW   = 16;
+
+struct KfdDliConfig {
+    const char* host           = "127.0.0.1";
+    uint16_t    port           = KFD_DLI_DEFAULT_PORT;
+    uint8_t     window         = 4;      // key frames in flight, 1..KFD_DLI_MAX_WINDOW
+    uint32_t    rtoUs          = 20000;  // retransmission timeout
+    uint8_t     maxRetransmits = 4;      // then the frame is reported RX_LOST
+};
+
+class KfdDliTransport : public KfdTransport {
+public:
+    explicit KfdDliTransport(const KfdDliConfig& cfg = KfdDliConfig()) : _cfg(cfg) {}
+    ~KfdDliTransport() override { close(); }
+
+    // Takes effect at the next open().
+    void                configure(const KfdDliConfig& cfg) { _cfg = cfg; }
+    const KfdDliConfig& config() const { return _cfg; }
+
+    void     open() override;
+    void     close() override;
+    void     send(const uint8_t* frame, size_t len, uint16_t tag) override;
+    RxStatus receive(uint8_t* buf, size_t maxLen, size_t& outLen, uint16_t& tag) override;
+    void     discard() override;
+    void     service() override;
+    size_t   window() const override;
+    bool     reliable() const override { return true; }
+
+    bool isOpen() const { return _sock >= 0; }
+
+    // Since the last open().
+    uint32_t datagramsSent() const { return _sent; }
+    uint32_t retransmits() const   { return _retransmits; }
+    uint32_t duplicates() const    { return _duplicates; }  // answers to nothing pending
+
+private:
+    // A datagram awaiting its answer, kept whole for retransmission.
+    struct Pending {
+        bool     used;
+        uint16_t seq;
+        uint16_t tag;
+        uint8_t  tries;
+        uint32_t sentAtUs;
+        size_t   len;
+        uint8_t  data[KFD_DLI_MAX_DATAGRAM];
+    };
+
+    void transmit(const Pending& p);
+
+    KfdDliConfig _cfg;
+    int          _sock = -1;
+    sockaddr_in  _peer;
+    uint16_t     _nextSeq = 0;
+
+    Pending  _pending[KFD_DLI_MAX_WINDOW] = {};
+    uint16_t _lost[KFD_DLI_MAX_WINDOW];  // tags given up on, reported by receive()
+    size_t   _lostCount = 0;
+
+    uint32_t _sent        = 0;
+    uint32_t _retransmits = 0;
+    uint32_t _duplicates  = 0;
+};
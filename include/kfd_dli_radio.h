@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <netinet/in.h>
+
+#include "kfd_dli.h"
+#include "kfd_radio_emulator.h"
+
+// Stand-in radio for DLI: a UDP endpoint in front of a KfdRadioEmulator,
+// so KfdDliTransport can be exercised on loopback or across the LAN
+// without a DLI-capable radio. Frames go to the emulator in arrival order
+// and its answers go back with the seq they answer. Retransmitted
+// datagrams are answered from a cache of recent answers rather than
+// applied again.
+//
+// Single-threaded: call service() as often as the KFD side steps.
+class KfdDliRadio {
+public:
+    ~KfdDliRadio() { end(); }
+
+    // Bind to the UDP port on all interfaces. dropPerMille discards that
+    // share of datagrams in each direction, to exercise retransmission.
+    bool begin(const KfdEmulatorConfig& cfg, uint16_t port = KFD_DLI_DEFAULT_PORT,
+               uint16_t dropPerMille = 0);
+    void end();
+
+    // Take in waiting datagrams and send the answers that are due.
+    void service();
+
+    KfdRadioEmulator& emulator() { return _emu; }
+
+    uint32_t dropped() const            { return _dropped; }
+    uint32_t duplicatesAnswered() const { return _dupAnswered; }
+
+private:
+    static constexpr size_t CACHE_SIZE = 32;
+
+    struct Answer {
+        uint16_t seq;
+        size_t   len;
+        uint8_t  data[KFD_DLI_MAX_DATAGRAM];
+    };
+
+    bool          drop();
+    const Answer* cached(uint16_t seq) const;
+    void          reply(const uint8_t* d, size_t len);
+
+    KfdRadioEmulator _emu;
+    int              _sock = -1;
+    sockaddr_in      _peer;
+    bool             _havePeer = false;
+    uint16_t         _dropPerMille = 0;
+    uint32_t         _rng = 1;
+
+    // Seqs of the frames the emulator still owes an answer, oldest first.
+    uint16_t _owed[KFD_EMULATOR_MAX_QUEUED];
+    size_t   _owedCount = 0;
+
+    Answer _cache[CACHE_SIZE];
+    size_t _cacheNext  = 0;
+    size_t _cacheCount = 0;
+
+    uint32_t _dropped     = 0;
+    uint32_t _dupAnswered = 0;
+};
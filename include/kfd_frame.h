@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Frame integrity layer shared by the KFD and the emulated radio.
+//
+//   SOF | LEN (BE16) | payload[LEN] | CRC (BE16)
+//
+// CRC is CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over LEN and payload,
+// computed from a 256-entry table generated at compile time.
+
+static constexpr uint8_t  KFD_FRAME_SOF         = 0x7E;
+static constexpr size_t   KFD_FRAME_OVERHEAD    = 5;
+static constexpr size_t   KFD_FRAME_MAX_PAYLOAD = 64;
+static constexpr uint16_t KFD_CRC_INIT          = 0xFFFF;
+
+// Incremental CRC: feed the previous value back in to continue.
+uint16_t kfdCrc16(const uint8_t* data, size_t len, uint16_t crc = KFD_CRC_INIT);
+uint16_t kfdCrc16Byte(uint16_t crc, uint8_t b);
+
+// Encode payload into out. Returns encoded length, or 0 if it does not fit.
+size_t kfdFrameEncode(const uint8_t* payload, size_t len, uint8_t* out, size_t outMax);
+
+// Byte-at-a-time frame validator. Bytes are pushed as they come off the
+// receive ring; the CRC is accumulated on the fly, so a frame is validated
+// in a single pass with no second walk over the buffer.
+class KfdFrameParser {
+public:
+    enum Status {
+        NEED_MORE = 0,
+        FRAME_OK,
+        CRC_ERROR,
+        LENGTH_ERROR
+    };
+
+    void   reset();
+    Status push(uint8_t b);
+
+    const uint8_t* payload() const { return _payload; }
+    size_t         payloadLen() const { return _len; }
+
+private:
+    enum Stage { WAIT_SOF, LEN_HI, LEN_LO, PAYLOAD, CRC_HI, CRC_LO };
+
+    Stage    _stage = WAIT_SOF;
+    uint16_t _len   = 0;
+    uint16_t _pos   = 0;
+    uint16_t _crc   = KFD_CRC_INIT;
+    uint16_t _rxCrc = 0;
+    uint8_t  _payload[KFD_FRAME_MAX_PAYLOAD];
+};
+
+// Fixed-size byte ring between the line receiver and the frame parser.
+template <size_t N>
+class KfdByteRing {
+public:
+    bool push(uint8_t b) {
+        size_t next = (_head + 1) % N;
+        if (next == _tail) return false;
+        _buf[_head] = b;
+        _head = next;
+        return true;
+    }
+    bool pop(uint8_t& b) {
+        if (_tail == _head) return false;
+        b = _buf[_tail];
+        _tail = (_tail + 1) % N;
+        return true;
+    }
+    bool empty() const { return _head == _tail; }
+    void clear() { _head = _tail = 0; }
+
+private:
+    uint8_t _buf[N];
+    size_t  _head = 0;
+    size_t  _tail = 0;
+};
+
+// Known-answer and round-trip checks; cheap enough to run at every begin().
+bool kfdFrameSelfTest();
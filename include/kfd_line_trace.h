@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+class Print;
+
+// Edge capture for the 3WI lines. Every level change the engine drives on
+// DATA, CLK or EN is stored with the CPU cycle counter into a preallocated
+// ring; the oldest edges are overwritten, so the ring always holds the
+// most recent traffic (e.g. the frame a radio just rejected). Recording is
+// O(1) with no allocation or I/O, and its own cost is measured, so capture
+// can be left on in the field. Export is VCD, decoded on the host by
+// tools/kfd_vcd_decode.py.
+
+// Ring size in edges (power of two). One byte frame is about 17 edges.
+#ifndef KFD_TRACE_EDGES
+#define KFD_TRACE_EDGES 8192
+#endif
+
+enum KfdLine : uint8_t {
+    KFD_LINE_DATA = 0,
+    KFD_LINE_CLK,
+    KFD_LINE_EN,
+    KFD_LINE_COUNT
+};
+
+class KfdLineTrace {
+public:
+    // The trace attached to port 0 by KfdPortScheduler.
+    static KfdLineTrace& instance();
+
+    void setEnabled(bool on) { _enabled.store(on, std::memory_order_relaxed); }
+    bool enabled() const     { return _enabled.load(std::memory_order_relaxed); }
+
+    // Drop all captured edges; levels are assumed low again.
+    void clear();
+
+    // Engine side: note the level driven on `line`. Only changes are
+    // stored. Owning (protocol) thread only.
+    void record(KfdLine line, bool level);
+
+    size_t   edgeCount() const { return _count < KFD_TRACE_EDGES ? _count : KFD_TRACE_EDGES; }
+    uint32_t overwritten() const { return _count > KFD_TRACE_EDGES ? _count - KFD_TRACE_EDGES : 0; }
+
+    // Mean cycles spent inside record() per stored edge.
+    uint32_t cyclesPerEdge() const { return _count ? (uint32_t)(_overheadCycles / _count) : 0; }
+
+    // Write the capture as a Value Change Dump (1 ns timescale). Call from
+    // the owning thread, or with capture disabled.
+    void writeVcd(Print& out) const;
+
+    // writeVcd() to a file on the SD card (KFD_USE_SD builds only).
+    bool saveVcd(const char* path) const;
+
+private:
+    KfdLineTrace() = default;
+
+    std::atomic<bool> _enabled{false};
+    uint8_t           _levels = 0;   // current DATA/CLK/EN bits
+    uint32_t          _count  = 0;   // edges ever stored since clear()
+    uint64_t          _overheadCycles = 0;
+
+    uint32_t _cycles[KFD_TRACE_EDGES];
+    uint8_t  _state[KFD_TRACE_EDGES];  // line levels after the edge
+};
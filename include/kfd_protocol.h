@@ -1,23 +1,154 @@
 #pragma once
 
+#include <atomic>
 #include <stddef.h>
 #include <stdint.h>
+#include <vector>
 
 #include "container_model.h"
+#include "kfd_frame.h"
+#include "kfd_session_plan.h"
+#include "kfd_telemetry.h"
+#include "kfd_three_wire.h"
+#include "kfd_transport.h"
 
 // High-level P25 keyload protocol wrapper using UI-level KeyContainer.
-// Low-level 3-wire details live in kfd_protocol.cpp.
+// This is the KMM layer; frames travel over a KfdTransport, by default the
+// port's own 3WI line (kfd_three_wire.cpp).
+
+// Acknowledged delivery tuning. A frame that times out, fails CRC or gets a
+// transient NAK is retransmitted on its own (the rest of the session is
+// kept) after an exponential backoff of backoffBaseUs << attempt.
+struct KfdDeliveryConfig {
+    uint32_t frameTimeoutUs = 100000;
+    uint8_t  maxRetries     = 3;
+    uint32_t backoffBaseUs  = 2000;
+    uint32_t backoffMaxUs   = 50000;
+
+    // Clock negotiation: probe a radio not in the rate cache with
+    // probeExchanges READY exchanges per rate (false: fixed default rate).
+    bool     negotiateRate  = true;
+    uint8_t  probeExchanges = 4;
+    uint32_t probeTimeoutUs = 20000;
+};
+
+// Line errors (timeouts or CRC failures) within the last 16 frames that
+// step the clock down one rate mid-session.
+static constexpr int KFD_RATE_STEPDOWN_ERRORS = 2;
+
+// Most key frames in flight at once on a windowed transport.
+static constexpr size_t KFD_MAX_WINDOW = 16;
 
 class KFDProtocol {
 public:
-    // Initialise GPIO / timers / whatever hardware is used for 3WI/TWI.
+    // One instance per 3WI port. The device's ports are owned by
+    // KfdPortScheduler; the benchmark constructs its own pinless ports.
+    explicit KFDProtocol(const KfdPins& pins = KFD_DEFAULT_PINS) : _line(pins) {}
+
+    // Rewire the port's 3WI line; call before begin().
+    void setPins(const KfdPins& pins) { _line.setPins(pins); }
+
+    // Initialise the 3WI line and run the frame layer self-test.
     bool begin();
 
-    // Drive background state machine (call from loop() if you want).
+    // Run sessions over another transport (begun by its owner), e.g. DLI
+    // over UDP; nullptr returns to the 3WI line. Only while idle.
+    bool attachTransport(KfdTransport* transport);
+
+    // Drive the state machine until it has to wait for the radio (an
+    // acknowledgement or a retry backoff) or the session ends. Never
+    // blocks on the line, so several ports can be serviced in turn.
     void loop();
 
-    // Start a keyload session from the given UI container.
-    bool beginKeyload(const KeyContainer& kc);
+    // Start a keyload session from the given UI container. The session is
+    // compiled into a KfdSessionPlan first; returns false (and leaves the
+    // line untouched) if the plan is rejected. A delta load reads the
+    // radio's inventory after READY and skips keys it already holds;
+    // KFD_LOAD_FULL forces every selected key to be sent.
+    bool beginKeyload(const KeyContainer& kc, KfdLoadMode mode = KFD_LOAD_DELTA);
+
+    // Why the last session failed.
+    enum Failure {
+        FAIL_NONE = 0,
+        FAIL_TIMEOUT,       // no answer within frameTimeoutUs, retries exhausted
+        FAIL_INTEGRITY,     // answer failed CRC/length check, retries exhausted
+        FAIL_BAD_RESPONSE,  // answer opcode does not match the plan
+        FAIL_NAK,           // radio NAKed; see lastNakStatus()
+        FAIL_ABORTED        // stopped by abort()
+    };
+
+    void                     setDeliveryConfig(const KfdDeliveryConfig& cfg) { _delivery = cfg; }
+    const KfdDeliveryConfig& deliveryConfig() const { return _delivery; }
+
+    Failure lastFailure() const    { return _lastFailure; }
+    uint8_t lastNakStatus() const  { return _lastNakStatus; }
+    int     lastFailedKey() const  { return _lastFailedKey; }
+
+    // 3WI clock of the current (or last) session (0 on other transports),
+    // and the bit rate of a KFD_CLOCK_HALF_US index.
+    uint32_t        clockRateBps() const { return usingLine() ? rateBps(_rateIdx) : 0; }
+    static uint32_t rateBps(size_t idx) { return 500000u / KFD_CLOCK_HALF_US[idx]; }
+
+    // Radio ID reported in the last READY answer (0 if none).
+    uint32_t radioId() const { return _radioId; }
+
+    // Negotiated rates are remembered per radio ID for all ports.
+    static void clearRateCache();
+
+    // Human-readable text for lastFailure()/lastNakStatus().
+    const char*        failureText() const;
+    static const char* nakStatusName(uint8_t status);
+
+    // Result of the most recent plan compilation.
+    KfdSessionPlan::Result lastPlanResult() const { return _lastPlanResult; }
+
+    // Stop the running session and put the line in its safe state (EN, CLK
+    // and DATA low). Frames are clocked out whole within one state machine
+    // step, so no partial frame is ever left on the wire. Owning thread
+    // only; returns false if nothing was running.
+    bool abort();
+
+    // Any thread. abort() is performed before the next state machine step,
+    // i.e. within one frame time of the call once loop() runs.
+    void requestAbort();
+
+    // Owning thread. Perform a requested abort now, outside loop(); true
+    // if one was pending.
+    bool abortIfRequested();
+
+    // Key indices (into the container) the radio acknowledged in the
+    // current or last session, in load order.
+    const std::vector<uint16_t>& committedKeys() const { return _committedKeys; }
+
+    // Keys clocked out on a transport with no receiver (the GPIO 3WI line):
+    // sent, but nothing could acknowledge them, so they are never counted
+    // as committed.
+    const std::vector<uint16_t>& unverifiedKeys() const { return _unverifiedKeys; }
+
+    // Keys that were sent but unacknowledged when the last session was
+    // aborted: the radio may or may not have stored them. Only a windowed
+    // transport can leave more than one.
+    const std::vector<uint16_t>& inDoubtKeys() const { return _inDoubtKeys; }
+    int inDoubtKey() const { return _inDoubtKeys.empty() ? -1 : _inDoubtKeys.front(); }
+
+    // requestAbort() -> safe line state, for the last abort.
+    uint32_t abortLatencyUs() const { return _abortLatencyUs; }
+
+    bool busy() const          { return _state != IDLE; }
+    bool lastSessionOk() const { return _lastSessionOk; }
+
+    // Telemetry for the current (or most recent) session.
+    const KfdSessionTelemetry& telemetry() const { return _telemetry; }
+
+    // Received frames rejected by the CRC/length check since begin().
+    uint32_t crcErrors() const { return _crcErrors; }
+
+    // Route 3WI frames to an emulated radio instead of the GPIO line
+    // (nullptr detaches). Used by the keyload benchmark.
+    void attachEmulator(KfdRadioEmulator* emu) { _line.attachEmulator(emu); }
+
+    // Record every level the 3WI line drives into trace (nullptr detaches).
+    void attachTrace(KfdLineTrace* trace) { _line.attachTrace(trace); }
 
 private:
     // Internal state machine
@@ -26,23 +157,97 @@ private:
         SESSION_START,
         SENDING_KEYS,
         SESSION_END,
+        AWAIT_ACK, // _currentFrame sent, waiting for the radio's answer
+        BACKOFF,   // waiting to retransmit _currentFrame
+        PIPELINE,  // windowed transport: key frames in flight in _window
+        PROBE,     // clock negotiation: send READY_REQ at _probeIdx
+        PROBE_WAIT,
         ERROR
     };
 
-    State        _state         = IDLE;
-    KeyContainer _activeContainer;
-    size_t       _currentKeyIndex = 0;
+    enum FrameResult {
+        FRAME_PENDING = 0,
+        FRAME_ACKED,
+        FRAME_TIMEOUT,
+        FRAME_INTEGRITY,
+        FRAME_BAD_RESPONSE,
+        FRAME_NAK,
+        FRAME_MORE  // inventory page taken, next page requested
+    };
+
+    // One key frame awaiting its answer (or a retransmit) in PIPELINE.
+    struct InFlight {
+        uint16_t frame;
+        uint8_t  attempt;
+        bool     waiting;    // sent; false while backing off for a retransmit
+        bool     nacked;     // last failure was a NAK: not stored by the radio
+        uint32_t sentAtUs;   // or retransmit time while backing off
+        uint32_t sendUs;
+    };
+
+    KfdThreeWireTransport _line;
+    KfdTransport*         _transport = &_line;
+
+    State          _state         = IDLE;
+    KeyContainer   _activeContainer;
+    KfdSessionPlan _plan;
+    size_t         _currentFrame  = 0;
+
+    KfdDeliveryConfig _delivery;
+    uint8_t           _attempt       = 0;
+    uint32_t          _retryAtUs     = 0;
+    State             _resumeState   = IDLE;  // phase that sent _currentFrame
+    uint32_t          _sentAtUs      = 0;
+    uint32_t          _sendUs        = 0;
+    uint32_t          _inventoryAtUs = 0;
+
+    size_t            _rateIdx       = KFD_CLOCK_DEFAULT;
+    uint32_t          _radioId       = 0;
+    uint16_t          _errHistory    = 0;  // last 16 frames, 1 = line error
+    size_t            _probeIdx      = 0;
+    size_t            _probeBest     = 0;
+    uint8_t           _probePasses   = 0;
+    uint32_t          _probeAtUs     = 0;
+    State             _afterProbe    = IDLE;
+    Failure           _lastFailure   = FAIL_NONE;
+    uint8_t           _lastNakStatus = KFD_STATUS_PERFORMED;
+    int               _lastFailedKey = -1;
+
+    InFlight _window[KFD_MAX_WINDOW];
+    size_t   _inFlight  = 0;
+    bool     _pipeMoved = false;
+
+    std::vector<uint16_t> _committedKeys;
+    std::vector<uint16_t> _unverifiedKeys;
+    std::vector<uint16_t> _inDoubtKeys;
+    std::atomic<bool>     _abortRequested{false};
+    std::atomic<uint32_t> _abortRequestedUs{0};  // written by requestAbort()'s thread
+    uint32_t              _abortLatencyUs    = 0;
+
+    KfdSessionPlan::Result _lastPlanResult = KfdSessionPlan::OK;
+    bool                   _lastSessionOk  = false;
+    uint32_t               _crcErrors      = 0;
 
-    // Low-level 3-wire primitives (DATA, CLK, EN)
-    void twiSetData(bool level);
-    void twiSetClock(bool level);
-    void twiSetEnable(bool level);
-    bool twiGetData();
+    KfdSessionTelemetry _telemetry      = {};
+    uint32_t            _sessionCounter = 0;
 
-    void sendBit(bool bit);
-    void sendByte(uint8_t value);
-    void sendFrame(const uint8_t* data, size_t len);
-    bool recvFrame(uint8_t* buf, size_t maxLen, size_t& outLen);
+    bool        usingLine() const { return _transport == &_line; }
+    void        sendCurrentFrame();
+    FrameResult pollAck();
+    void        handleAck(FrameResult r);
+    FrameResult handleInventory(const uint8_t* rsp, size_t len);
+    State       phaseFor(size_t idx) const;
+    size_t      nextFrame(size_t idx) const;
+    void        setRate(size_t idx);
+    bool        startClock();
+    void        probeResult(bool ok);
+    void        noteLineResult(bool error);
+    FrameResult checkAnswer(size_t idx, const uint8_t* rsp, size_t rspLen);
+    bool        recordFailure(size_t idx, FrameResult r, uint8_t attempt);
+    uint32_t    backoffUs(uint8_t attempt) const;
+    void        pipelineSend(InFlight& slot);
+    void        pipelineAnswer(InFlight& slot, FrameResult r);
+    void        pipelineStep();
 
     void stateMachine();
 };
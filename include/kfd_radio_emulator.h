@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "kfd_frame.h"
+
+// Emulated P25 radio sitting on the far end of a simulated 3WI line.
+// It speaks the same CRC-framed messages KfdSessionPlan produces, holds a
+// key inventory (readable with INVENTORY_CMD) and can inject latency, NAKs
+// and bit errors. No Arduino
+// dependencies: time is passed in by the caller so it can run anywhere.
+
+struct KfdEmulatorConfig {
+    uint32_t responseLatencyUs   = 200;  // fixed turnaround per frame
+    uint32_t latencyJitterUs     = 0;    // uniform random extra turnaround
+    uint16_t nakPerMille         = 0;    // chance a key frame is NAKed
+    uint32_t bitErrorsPerMillion = 0;    // per bit, both directions
+    uint32_t seed                = 1;
+    bool     inventorySupported  = true;  // false: NAK INVENTORY_CMD like older radios
+    uint32_t radioId             = 0x00100001;  // sent with READY; 0 = anonymous
+
+    // Answers held at once. A 3WI radio has one: a new frame replaces an
+    // answer not yet clocked out. Datagram links queue one per frame in
+    // flight, up to KFD_EMULATOR_MAX_QUEUED; the oldest is dropped when full.
+    uint8_t responseQueueDepth = 1;
+
+    // Fastest 3WI clock the radio follows (0 = any). Frames clocked faster
+    // see overspeedErrorsPerMillion extra bit errors in both directions.
+    // After degradeAfterFrames frames (0 = never) the limit drops to
+    // degradedMaxBitRate, e.g. a long cable warming up.
+    uint32_t maxBitRate                = 0;
+    uint32_t overspeedErrorsPerMillion = 20000;
+    uint32_t degradeAfterFrames        = 0;
+    uint32_t degradedMaxBitRate        = 0;
+};
+
+static constexpr size_t KFD_EMULATOR_MAX_QUEUED = 16;
+
+struct KfdEmulatedKey {
+    uint16_t keyId;
+    uint8_t  algId;
+    uint8_t  length;
+    uint8_t  data[32];
+};
+
+class KfdRadioEmulator {
+public:
+    void configure(const KfdEmulatorConfig& cfg);
+    void reset();  // clear inventory, pending responses and counters
+
+    // KFD -> radio. The encoded frame is copied, optionally corrupted,
+    // CRC-checked and answered once the configured latency has elapsed.
+    // Bit errors are applied to the encoded response as well.
+    void onFrame(const uint8_t* data, size_t len, uint32_t nowUs);
+
+    // Clock rate the KFD is driving the line at, for the overspeed model.
+    void setLineRate(uint32_t bps) { _lineRate = bps; }
+
+    // Radio -> KFD. Returns the oldest encoded response frame, or false if
+    // it is not due yet at nowUs.
+    bool   takeResponse(uint8_t* buf, size_t maxLen, size_t& outLen, uint32_t nowUs);
+    bool   responsePending() const { return _rspCount > 0; }
+    size_t responseCount() const   { return _rspCount; }
+
+    // Responses produced so far; onFrame() answered iff this moved.
+    uint32_t responsesQueued() const { return _responsesQueued; }
+
+    const std::vector<KfdEmulatedKey>& inventory() const { return _inventory; }
+
+    uint32_t framesReceived() const { return _framesReceived; }
+    uint32_t naksSent() const       { return _naksSent; }
+    uint32_t bitsFlipped() const    { return _bitsFlipped; }
+    uint32_t crcRejects() const     { return _crcRejects; }
+
+private:
+    void     corrupt(uint8_t* data, size_t len);
+    uint32_t bitErrorsPerMillion() const;
+    void     respond(const uint8_t* data, size_t len, uint32_t nowUs);
+    void     storeKey(const uint8_t* frame, size_t len);
+    void     respondInventory(uint16_t startId, uint32_t nowUs);
+    uint32_t nextRandom();
+
+    KfdEmulatorConfig           _cfg;
+    std::vector<KfdEmulatedKey> _inventory;
+    uint32_t                    _rng = 1;
+    uint32_t                    _lineRate = 0;
+
+    struct Response {
+        uint8_t  wire[KFD_FRAME_MAX_PAYLOAD + KFD_FRAME_OVERHEAD];  // encoded frame
+        size_t   len;
+        uint32_t readyUs;
+    };
+    Response _rsp[KFD_EMULATOR_MAX_QUEUED];  // FIFO ring
+    size_t   _rspHead  = 0;
+    size_t   _rspCount = 0;
+    uint32_t _responsesQueued = 0;
+
+    uint32_t _framesReceived = 0;
+    uint32_t _naksSent       = 0;
+    uint32_t _bitsFlipped    = 0;
+    uint32_t _crcRejects     = 0;
+};
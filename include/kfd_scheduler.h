@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "container_model.h"
+#include "kfd_protocol.h"
+
+// Number of 3WI ports wired on this board; override with -DKFD_PORT_COUNT=n.
+#ifndef KFD_PORT_COUNT
+#define KFD_PORT_COUNT 1
+#endif
+
+static constexpr size_t KFD_MAX_PORTS = 4;
+static_assert(KFD_PORT_COUNT >= 1 && KFD_PORT_COUNT <= KFD_MAX_PORTS,
+              "KFD_PORT_COUNT must be between 1 and KFD_MAX_PORTS");
+
+// Owns the device's 3WI ports and interleaves their keyload sessions. Each
+// port runs its own KFDProtocol; service() gives every busy port a turn in
+// round-robin order, so while one radio is turning an acknowledgement
+// around the others are being clocked.
+class KfdPortScheduler {
+public:
+    static KfdPortScheduler& instance();
+
+    // begin() every port. Returns false if any port failed its self-test.
+    bool begin();
+
+    // Start the same container on every idle port. Returns the number of
+    // ports that accepted the session (0 if the plan was rejected).
+    size_t beginKeyload(const KeyContainer& kc, KfdLoadMode mode = KFD_LOAD_DELTA);
+
+    // One scheduling pass over all ports (call from the UI timer / loop).
+    void service();
+
+    bool busy() const;
+
+    // Any thread. Ask every port to abort(); see KFDProtocol::requestAbort().
+    void requestAbort();
+
+    // Owning thread. Carry out requested aborts without a full service()
+    // pass, e.g. while waiting on the UI.
+    void serviceAborts();
+
+    // Aggregate progress over the ports that took part in the last start.
+    uint8_t progressPercent() const;
+
+    // Ports that took part in the last start, and how many of them have
+    // finished OK / are still running.
+    size_t sessionCount() const { return _started; }
+    size_t okCount() const;
+    size_t activeCount() const { return _active; }
+
+    size_t       portCount() const { return KFD_PORT_COUNT; }
+    KFDProtocol& port(size_t i)    { return _ports[i]; }
+    const KFDProtocol& port(size_t i) const { return _ports[i]; }
+
+    // True if port i took part in the last beginKeyload().
+    bool inSession(size_t i) const { return (_sessionMask >> i) & 1u; }
+
+private:
+    KfdPortScheduler();
+
+    KFDProtocol _ports[KFD_MAX_PORTS];
+    size_t      _next        = 0;  // round-robin start
+    size_t      _started     = 0;
+    size_t      _active      = 0;
+    uint32_t    _sessionMask = 0;
+};
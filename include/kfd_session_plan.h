@@ -0,0 +1,136 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "container_model.h"
+
+// -----------------------------------------------------------------------------
+// 3WI opcodes (as used by KFDtool's ThreeWireProtocol)
+// -----------------------------------------------------------------------------
+static constexpr uint8_t KFD_OPCODE_READY_REQ          = 0xC0;
+static constexpr uint8_t KFD_OPCODE_TRANSFER_DONE      = 0xC1;
+static constexpr uint8_t KFD_OPCODE_KMM                = 0xC2;
+static constexpr uint8_t KFD_OPCODE_READY_GENERAL_MODE = 0xD0;
+static constexpr uint8_t KFD_OPCODE_DISCONNECT_ACK     = 0x90;
+static constexpr uint8_t KFD_OPCODE_DISCONNECT         = 0x92;
+
+// Radio answers a key frame with KMM, a message ID and a status byte.
+static constexpr uint8_t KFD_KMM_REKEY_ACK = 0x1D;
+static constexpr uint8_t KFD_KMM_NAK       = 0x16;
+
+// Key inventory: KMM, INVENTORY_CMD, first key ID (BE16) asks for the keys
+// the radio holds from that ID up. The answer is KMM, INVENTORY_RSP, flags,
+// count, then count entries of key ID (BE16), algorithm ID and key digest
+// (KfdSessionPlan::keyDigest()), in ascending key ID order.
+// KFD_INVENTORY_MORE means another page follows from the last listed ID + 1.
+static constexpr uint8_t KFD_KMM_INVENTORY_CMD = 0x0D;
+static constexpr uint8_t KFD_KMM_INVENTORY_RSP = 0x0E;
+static constexpr uint8_t KFD_INVENTORY_MORE    = 0x01;
+static constexpr size_t  KFD_KEY_DIGEST_BYTES      = 8;
+static constexpr size_t  KFD_INVENTORY_ENTRY_BYTES = 3 + KFD_KEY_DIGEST_BYTES;
+static constexpr size_t  KFD_INVENTORY_MAX_ENTRIES = 5;  // fits one 64-byte payload
+
+// NAK status codes (P25 OTAR / KMM status field).
+static constexpr uint8_t KFD_STATUS_PERFORMED      = 0x00;
+static constexpr uint8_t KFD_STATUS_NOT_PERFORMED  = 0x01;
+static constexpr uint8_t KFD_STATUS_NO_ITEM        = 0x02;
+static constexpr uint8_t KFD_STATUS_INVALID_MSG_ID = 0x03;
+static constexpr uint8_t KFD_STATUS_INVALID_MAC    = 0x04;
+static constexpr uint8_t KFD_STATUS_OUT_OF_MEMORY  = 0x05;
+static constexpr uint8_t KFD_STATUS_DECRYPT_FAILED = 0x06;
+static constexpr uint8_t KFD_STATUS_INVALID_MSG_NO = 0x07;
+static constexpr uint8_t KFD_STATUS_INVALID_KEY_ID = 0x08;
+static constexpr uint8_t KFD_STATUS_INVALID_ALG_ID = 0x09;
+static constexpr uint8_t KFD_STATUS_INVALID_MFID   = 0x0A;
+static constexpr uint8_t KFD_STATUS_MODULE_FAILURE = 0x0B;
+static constexpr uint8_t KFD_STATUS_MI_ALL_ZEROS   = 0x0C;
+static constexpr uint8_t KFD_STATUS_KEYFAIL        = 0x0D;
+
+// Largest key we accept (AES-256).
+static constexpr size_t KFD_MAX_KEY_BYTES = 32;
+
+// DELTA asks the radio for its inventory first and sends only the keys it
+// is missing or holds with different material; FULL sends every key.
+enum KfdLoadMode : uint8_t {
+    KFD_LOAD_DELTA = 0,
+    KFD_LOAD_FULL
+};
+
+// One frame of a compiled session: where its bytes live inside the plan
+// buffer and which response opcode the radio must answer with.
+struct KfdPlanFrame {
+    uint32_t offset;            // into the plan's contiguous byte buffer
+    uint16_t length;            // encoded length including SOF/LEN/CRC
+    int16_t  keyIndex;          // source KeySlot index, -1 for control frames
+    uint8_t  expectedResponse;  // opcode the radio acknowledges with
+    uint8_t  algId;             // key frames: algorithm ID
+    uint8_t  digest[KFD_KEY_DIGEST_BYTES];  // key frames: KfdSessionPlan::keyDigest()
+    bool     inventory;         // INVENTORY_CMD; resent once per page
+    bool     skip;              // key the radio already holds
+};
+
+// Complete keyload session compiled up front by KFDProtocol::beginKeyload().
+// All selection, hex decoding and validation happens in compile(), so the
+// line engine only has to stream frames and check acknowledgements.
+class KfdSessionPlan {
+public:
+    enum Result {
+        OK = 0,
+        NO_KEYS,        // nothing selected / container empty
+        BAD_HEX,        // key hex is odd-length or has non-hex characters
+        BAD_KEY_LENGTH, // decoded length does not match the algorithm
+        TOO_MANY_KEYS
+    };
+
+    // Build the plan from a UI container. On failure the plan is left empty
+    // and errorKeyIndex() names the offending key (or -1).
+    Result compile(const KeyContainer& kc, KfdLoadMode mode = KFD_LOAD_DELTA);
+    void   clear();
+
+    // Delta loads: point the inventory frame at the next page.
+    void setInventoryStart(uint16_t keyId);
+
+    // Mark every planned key that one inventory page shows the radio already
+    // holds (same key ID, algorithm and digest) to be skipped. entries is
+    // the raw entry list of an INVENTORY_RSP. Returns the keys newly marked.
+    size_t applyInventory(const uint8_t* entries, size_t count);
+
+    size_t              frameCount() const { return frames_.size(); }
+    const KfdPlanFrame& frame(size_t i) const { return frames_[i]; }
+    const uint8_t*      frameData(size_t i) const { return bytes_.data() + frames_[i].offset; }
+
+    size_t keyCount() const     { return keyCount_; }
+    size_t skippedCount() const { return skipped_; }
+    size_t totalBytes() const { return bytes_.size(); }
+    int    errorKeyIndex() const { return errorKeyIndex_; }
+
+    static const char* resultName(Result r);
+
+    // P25 algorithm ID for a UI algorithm name (0x80 = unknown/clear).
+    static uint8_t algorithmId(const std::string& algo);
+
+    // Key length in bytes an algorithm ID requires, or 0 if any length is
+    // accepted.
+    static size_t expectedKeyLength(uint8_t algId);
+
+    // Fingerprint the radio reports per key in its inventory: SHA-256 over
+    // the algorithm ID and key bytes, truncated to KFD_KEY_DIGEST_BYTES.
+    // Never leaves the device otherwise.
+    static void keyDigest(uint8_t algId, const uint8_t* key, size_t len, uint8_t* out);
+
+private:
+    void appendFrame(const uint8_t* payload, size_t len, int16_t keyIndex, uint8_t expectedResponse);
+    void appendControl(uint8_t opcode, uint8_t expectedResponse);
+    void appendKey(uint16_t keyIndex, uint8_t algId, const uint8_t* key, size_t keyLen);
+    void appendInventory();
+
+    std::vector<uint8_t>      bytes_;
+    std::vector<KfdPlanFrame> frames_;
+    std::vector<int16_t>      keyFrame_;  // frame index by key index, -1 if not planned
+    int                       inventoryFrame_ = -1;
+    size_t                    keyCount_       = 0;
+    size_t                    skipped_        = 0;
+    int                       errorKeyIndex_  = -1;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+// Single-producer single-consumer ring. Lock-free: the producer only
+// writes _head, the consumer only writes _tail, and the acquire/release
+// pair on those indices publishes the slot contents. One instance carries
+// commands UI -> protocol task, another carries events back.
+template <typename T, size_t N>
+class KfdSpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "KfdSpscQueue size must be a power of two");
+
+public:
+    // Producer side.
+    bool push(const T& v) {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        const size_t tail = _tail.load(std::memory_order_acquire);
+        if (head - tail == N) return false;
+        _buf[head & (N - 1)] = v;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Free slots as seen by the producer.
+    size_t space() const {
+        return N - (_head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire));
+    }
+
+    // Consumer side.
+    bool pop(T& out) {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        const size_t head = _head.load(std::memory_order_acquire);
+        if (head == tail) return false;
+        out = _buf[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    static constexpr size_t capacity() { return N; }
+
+private:
+    T                   _buf[N];
+    std::atomic<size_t> _head{0};
+    std::atomic<size_t> _tail{0};
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "container_model.h"
+#include "kfd_scheduler.h"
+#include "kfd_spsc_queue.h"
+#include "kfd_telemetry.h"
+
+// FreeRTOS placement of the protocol task. The Arduino loop (LVGL, touch,
+// console) runs on core 1, so the line gets core 0 to itself.
+#ifndef KFD_TASK_CORE
+#define KFD_TASK_CORE 0
+#endif
+#ifndef KFD_TASK_PRIORITY
+#define KFD_TASK_PRIORITY 5
+#endif
+#ifndef KFD_TASK_STACK
+#define KFD_TASK_STACK 6144
+#endif
+
+// UI -> protocol task.
+struct KfdCommand {
+    enum Type : uint8_t {
+        START_KEYLOAD = 0,  // container is heap-owned; the task deletes it
+        PRINT_STATS,
+        TRACE_ON,           // clear and start port 0 line capture
+        TRACE_OFF,
+        TRACE_DUMP,         // VCD to Serial
+        TRACE_SAVE          // VCD to SD
+    };
+    Type          type;
+    KfdLoadMode   mode;       // START_KEYLOAD
+    KeyContainer* container;
+    uint32_t      abortEpoch; // START_KEYLOAD: requestAbort() count when queued
+};
+
+// Protocol task -> UI. Every event carries a snapshot of the port's
+// telemetry so the UI never reads protocol state across cores.
+struct KfdEvent {
+    enum Type : uint8_t {
+        STARTED = 0,   // session accepted on `ports` ports
+        REJECTED,      // plan rejected (planResult), ports busy (planResult OK),
+                       // or aborted while still queued (aborted)
+        PROGRESS,      // port's percentage changed
+        PORT_DONE,     // port finished; see ok / failure
+        SESSION_DONE   // all ports of the session finished
+    };
+    Type        type;
+    uint8_t     port;
+    uint8_t     percent;     // PROGRESS/PORT_DONE: port; SESSION_DONE: aggregate
+    bool        ok;
+    uint8_t     planResult;  // KfdSessionPlan::Result, REJECTED only
+    uint8_t     ports;       // STARTED/SESSION_DONE: ports in the session
+    uint8_t     portMask;    // STARTED: bit i set if port i takes part
+    bool        aborted;     // PORT_DONE/SESSION_DONE/REJECTED: stopped by abort
+    uint16_t    committed;   // PORT_DONE/SESSION_DONE: keys the radio acked
+    uint16_t    unverified;  // PORT_DONE/SESSION_DONE: keys sent on a line with no receiver
+    int16_t     inDoubtKey;  // PORT_DONE/SESSION_DONE: see KFDProtocol::inDoubtKey()
+    uint8_t     inDoubt;     // PORT_DONE/SESSION_DONE: keys in doubt, more than 1 if pipelined
+    uint8_t     okPorts;     // SESSION_DONE
+    const char* failure;     // static text, PORT_DONE/SESSION_DONE on failure
+    KfdSessionTelemetry telemetry;
+};
+
+// Owns the FreeRTOS task that services KfdPortScheduler. Commands and
+// events cross cores only through the two SPSC queues below, so rendering
+// and touch handling never run on the line's core or hold it up.
+class KfdProtocolTask {
+public:
+    static KfdProtocolTask& instance();
+
+    // Create the pinned task. Call once, after the scheduler's begin().
+    bool start();
+
+    // UI thread. Copies kc; false if the command queue is full.
+    bool requestKeyload(const KeyContainer& kc, KfdLoadMode mode = KFD_LOAD_DELTA);
+    bool requestStats();
+
+    // UI/console thread. Line trace control, carried out by the task so
+    // capture and export never race.
+    bool requestTrace(KfdCommand::Type type);
+
+    // UI thread. Abort every running port; completion arrives as the usual
+    // PORT_DONE/SESSION_DONE events with `aborted` set. A keyload still in
+    // the command queue is dropped and answered with REJECTED, `aborted`.
+    void requestAbort();
+
+    // UI thread. Pops the next event, false if none.
+    bool pollEvent(KfdEvent& ev) { return _events.pop(ev); }
+
+    // UI thread, before start(). The task gets a notification
+    // (xTaskNotifyGive) after every event, so it can block instead of
+    // polling pollEvent().
+    void setEventWaiter(void* task) { _waiter = task; }
+
+private:
+    KfdProtocolTask() = default;
+
+    static void taskEntry(void* arg);
+    void run();
+    void handleCommand(const KfdCommand& cmd);
+    void publishProgress();
+    void post(const KfdEvent& ev);
+    void postBestEffort(const KfdEvent& ev);
+    bool sendCommand(const KfdCommand& cmd);
+
+    KfdSpscQueue<KfdCommand, 8> _commands;
+    KfdSpscQueue<KfdEvent, 16>  _events;
+    void*                       _handle = nullptr;  // TaskHandle_t
+    void*                       _waiter = nullptr;  // TaskHandle_t, see setEventWaiter()
+    std::atomic<uint32_t>       _abortEpoch{0};     // bumped by requestAbort()
+
+    // Task-side bookkeeping for change detection.
+    uint8_t _lastPercent[KFD_MAX_PORTS] = {};
+    bool    _wasBusy[KFD_MAX_PORTS]     = {};
+    bool    _sessionOpen                = false;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-session keyload telemetry. Fixed size, no allocation: one instance
+// lives inside KFDProtocol and is overwritten at every beginKeyload().
+// All times are microseconds from micros().
+struct KfdSessionTelemetry {
+    uint32_t sessionId;
+
+    uint32_t startUs;        // SESSION_START entered
+    uint32_t firstKeyUs;     // SESSION_START -> first key acknowledged
+    uint32_t totalUs;        // SESSION_START -> SESSION_END / ERROR
+
+    uint32_t keysPlanned;    // to be sent; delta loads drop current keys
+    uint32_t keysAcked;
+    uint32_t keysUnverified; // clocked out on a line with no receiver: sent, never acknowledged
+    uint32_t keysSkipped;    // delta loads: already current in the radio
+    uint32_t inventoryUs;    // delta loads: time spent reading the inventory
+    uint32_t framesTx;
+    uint32_t bytesTx;        // on the wire, framing included
+    uint32_t bytesRx;
+
+    uint32_t retries;        // single-frame retransmits
+    uint32_t naks;
+    uint32_t timeouts;
+    uint32_t crcErrors;
+
+    // Per-key phase timing: time to clock a key frame out, and time from
+    // the end of the frame to its acknowledgement.
+    uint32_t keySendUsMin, keySendUsMax, keySendUsTotal;
+    uint32_t keyAckUsMin,  keyAckUsMax,  keyAckUsTotal;
+
+    uint32_t bitRateBps;     // effective: wire bits / total duration
+    uint32_t clockBps;       // 3WI line clock in use at the end
+    uint32_t probeUs;        // clock negotiation time (0: cached or fixed)
+    uint32_t rateStepDowns;  // mid-session clock reductions on line errors
+
+    bool     active;
+    bool     ok;
+
+    void reset(uint32_t id, uint32_t keys, uint32_t nowUs);
+    void recordFrame(size_t txBytes, size_t rxBytes);
+    void recordKey(uint32_t sendUs, uint32_t ackUs);
+    void recordUnverifiedKey(uint32_t sendUs);
+    void finish(bool success, uint32_t nowUs);
+
+    uint8_t progressPercent() const;
+
+    // Short multi-line summary for the keyload screen.
+    void format(char* buf, size_t len) const;
+
+    // Full dump to Serial (console command "kfd stats").
+    void print() const;
+};
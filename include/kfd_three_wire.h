@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "kfd_frame.h"
+#include "kfd_transport.h"
+
+class KfdLineTrace;
+class KfdRadioEmulator;
+
+// GPIO lines of one 3WI port. A negative data pin means the port has no
+// line of its own (emulated radio only); the twi* primitives are no-ops.
+struct KfdPins {
+    int data;
+    int clk;
+    int en;
+};
+
+static constexpr KfdPins KFD_DEFAULT_PINS = { 21, 22, 23 };
+static constexpr KfdPins KFD_NO_PINS      = { -1, -1, -1 };
+
+// FT6336U interrupt output (active low), GPIO 7 on this board. Shared
+// here so the 3WI port table can be checked against it.
+#ifndef TOUCH_PIN_INT
+#define TOUCH_PIN_INT 7
+#endif
+
+// 3WI clock rates, slowest first, as the half bit period in microseconds.
+// READY_REQ always goes out at the first (safe) rate; the rest of the
+// session runs at the negotiated one.
+static constexpr uint8_t KFD_CLOCK_HALF_US[]  = { 50, 25, 16, 10, 8, 5, 4, 3, 2, 1 };
+static constexpr size_t  KFD_CLOCK_RATE_COUNT = sizeof(KFD_CLOCK_HALF_US);
+static constexpr size_t  KFD_CLOCK_DEFAULT    = 5;  // 5 us: the original fixed timing
+
+// Bit-banged three-wire interface (DATA, CLK, EN). Stop-and-wait: the tag
+// of an answer is that of the last frame sent. The GPIO receive path is
+// still a stub; with an emulator attached, frames go to it as to a radio
+// at the far end of the line.
+class KfdThreeWireTransport : public KfdTransport {
+public:
+    explicit KfdThreeWireTransport(const KfdPins& pins = KFD_DEFAULT_PINS) : _pins(pins) {}
+
+    // Rewire the port; call before begin().
+    void           setPins(const KfdPins& pins) { _pins = pins; }
+    const KfdPins& pins() const { return _pins; }
+
+    // Configure the GPIOs and drive all three lines low.
+    void begin();
+
+    // KFD_CLOCK_HALF_US index to clock at.
+    void     setClockRate(size_t idx);
+    uint32_t clockRateBps() const { return 500000u / KFD_CLOCK_HALF_US[_rateIdx]; }
+
+    void attachEmulator(KfdRadioEmulator* emu) { _emulator = emu; }
+    void attachTrace(KfdLineTrace* trace)     { _trace = trace; }
+
+    void     open() override;
+    void     close() override;
+    void     send(const uint8_t* frame, size_t len, uint16_t tag) override;
+    RxStatus receive(uint8_t* buf, size_t maxLen, size_t& outLen, uint16_t& tag) override;
+    void     discard() override;
+    bool     hasReceiver() const override { return _emulator != nullptr; }
+
+    // Byte-level access for the KFDtool adapter (kfd_adapter.h): bytes
+    // are clocked out as given, and received line bytes are taken one at
+    // a time. An attached emulator gets the written bytes reassembled
+    // into frames, as it would off the wire.
+    void writeBytes(const uint8_t* data, size_t len);
+    bool readByte(uint8_t& b);
+
+private:
+    // Low-level 3-wire primitives (DATA, CLK, EN)
+    void twiSetData(bool level);
+    void twiSetClock(bool level);
+    void twiSetEnable(bool level);
+    bool twiGetData();
+
+    void sendBit(bool bit);
+    void sendByte(uint8_t value);
+    void pumpEmulator();
+
+    KfdPins           _pins;
+    size_t            _rateIdx  = KFD_CLOCK_DEFAULT;
+    uint8_t           _halfUs   = 0;  // bit delay actually spent; 0 on pinless ports
+    uint16_t          _lastTag  = 0;
+    KfdRadioEmulator* _emulator = nullptr;
+    KfdLineTrace*     _trace    = nullptr;
+
+    // Receive path: line bytes -> ring -> one-pass CRC-validating parser.
+    KfdByteRing<128> _rxRing;
+    KfdFrameParser   _rxParser;
+
+    // writeBytes() towards an emulator: the frame being assembled.
+    uint8_t        _txRaw[KFD_FRAME_MAX_PAYLOAD + KFD_FRAME_OVERHEAD];
+    size_t         _txRawLen = 0;
+    KfdFrameParser _txParser;
+};
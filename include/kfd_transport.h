@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Link under the KMM layer. KFDProtocol compiles every message into an
+// encoded frame (SOF | LEN | payload | CRC, see kfd_frame.h) and hands it
+// to a transport tagged with its plan index; the transport returns the
+// radio's answers, CRC-checked, carrying the tag of the frame they answer.
+//
+//   KfdThreeWireTransport  bit-banged 3WI line (kfd_three_wire.h)
+//   KfdDliTransport        P25 DLI over UDP (kfd_dli.h)
+//
+// All calls are non-blocking and come from the thread running the port.
+class KfdTransport {
+public:
+    enum RxStatus : uint8_t {
+        RX_NONE = 0,  // nothing (yet)
+        RX_FRAME,     // valid answer in buf
+        RX_CORRUPT,   // an answer failed the CRC/length check
+        RX_LOST       // reliable transports: gave up on a frame
+    };
+
+    virtual ~KfdTransport() {}
+
+    // Session boundaries. close() must leave the link in its safe state
+    // and forget anything still in flight; it is also the abort path.
+    virtual void open()  = 0;
+    virtual void close() = 0;
+
+    // Send one encoded frame.
+    virtual void send(const uint8_t* frame, size_t len, uint16_t tag) = 0;
+
+    // Next answer, if any. tag names the frame it answers (or was lost).
+    virtual RxStatus receive(uint8_t* buf, size_t maxLen, size_t& outLen, uint16_t& tag) = 0;
+
+    // Drop received bytes and anything awaiting an answer.
+    virtual void discard() = 0;
+
+    // Timers (retransmission); called on every state machine step.
+    virtual void service() {}
+
+    // Frames that may await an answer at once. Above 1, KFDProtocol
+    // pipelines key frames.
+    virtual size_t window() const { return 1; }
+
+    // True if the transport retransmits on its own and reports RX_LOST;
+    // the KMM layer then applies no answer timeout of its own.
+    virtual bool reliable() const { return false; }
+
+    // False while the receive path is a stub: silence counts as an answer.
+    virtual bool hasReceiver() const { return true; }
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Deferred binary logging. A KLOG* call stores a 24-byte entry (timestamp,
+// format pointer, module, level, up to four integer arguments) in a RAM
+// ring. No formatting and no Serial traffic happen on the calling path.
+// klogService() formats pending entries to Serial from the main loop, and
+// "klog dump" (klogDump()) writes the raw ring for tools/klog_decode.py.
+//
+// Format strings must be literals and take integer arguments only
+// (%d %u %x %X %c and widths), at most four.
+//
+// Levels are filtered per module at compile time: a call above the
+// module's KLOG_LEVEL_<MODULE> compiles to nothing, literal included.
+
+#define KLOG_NONE    0
+#define KLOG_ERROR   1
+#define KLOG_WARN    2
+#define KLOG_INFO    3
+#define KLOG_DEBUG   4
+#define KLOG_VERBOSE 5
+
+#ifndef KLOG_LEVEL_KFD
+#define KLOG_LEVEL_KFD KLOG_INFO
+#endif
+#ifndef KLOG_LEVEL_MODEL
+#define KLOG_LEVEL_MODEL KLOG_INFO
+#endif
+#ifndef KLOG_LEVEL_UI
+#define KLOG_LEVEL_UI KLOG_INFO
+#endif
+#ifndef KLOG_LEVEL_TOUCH
+#define KLOG_LEVEL_TOUCH KLOG_WARN
+#endif
+
+// Ring size in entries (power of two).
+#ifndef KLOG_RING_ENTRIES
+#define KLOG_RING_ENTRIES 512
+#endif
+
+enum KlogModule : uint8_t {
+    KLOG_MOD_KFD = 0,
+    KLOG_MOD_MODEL,
+    KLOG_MOD_UI,
+    KLOG_MOD_TOUCH,
+    KLOG_MOD_COUNT
+};
+
+void klogRecord(uint8_t module, uint8_t level, const char* fmt, const uint32_t* args, uint8_t argc);
+
+inline void klogWrite(uint8_t module, uint8_t level, const char* fmt) {
+    klogRecord(module, level, fmt, nullptr, 0);
+}
+
+template <typename... A>
+inline void klogWrite(uint8_t module, uint8_t level, const char* fmt, A... a) {
+    static_assert(sizeof...(A) <= 4, "KLOG takes at most four arguments");
+    const uint32_t args[] = { (uint32_t)a... };
+    klogRecord(module, level, fmt, args, (uint8_t)sizeof...(A));
+}
+
+#define KLOG(mod, lvl, ...)                                             \
+    do {                                                                \
+        if (KLOG_LEVEL_##mod >= (lvl)) klogWrite(KLOG_MOD_##mod, (lvl), __VA_ARGS__); \
+    } while (0)
+
+#define KLOGE(mod, ...) KLOG(mod, KLOG_ERROR,   __VA_ARGS__)
+#define KLOGW(mod, ...) KLOG(mod, KLOG_WARN,    __VA_ARGS__)
+#define KLOGI(mod, ...) KLOG(mod, KLOG_INFO,    __VA_ARGS__)
+#define KLOGD(mod, ...) KLOG(mod, KLOG_DEBUG,   __VA_ARGS__)
+#define KLOGV(mod, ...) KLOG(mod, KLOG_VERBOSE, __VA_ARGS__)
+
+// Format up to maxEntries pending entries to Serial (if echo is on).
+// Call from loop(); the per-call budget bounds its cost. Returns true if
+// entries are still pending, i.e. the caller should come back soon.
+bool klogService(size_t maxEntries = 8);
+
+// Runtime switch for klogService()'s text echo; entries are recorded
+// either way.
+void klogSetEcho(bool on);
+
+// Write the whole ring as "KLOG ..." hex lines for tools/klog_decode.py.
+// Non-destructive.
+void klogDump();
+
+// Entries overwritten before klogService() reached them.
+uint32_t klogDropped();
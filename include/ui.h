@@ -6,6 +6,12 @@ extern "C" {
 
 void ui_init(void);
 
+// Apply pending keyload events from the protocol task (call from loop()).
+void ui_poll_kfd_events(void);
+
+// True from a keyload's STARTED event until its SESSION_DONE.
+bool ui_keyload_running(void);
+
 #ifdef __cplusplus
 }
 #endif
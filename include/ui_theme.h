@@ -0,0 +1,34 @@
+#pragma once
+
+#include <lvgl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Shared styles for the console look. Each style is initialized once and
+// attached to objects by reference, so styling a widget costs one entry
+// in its style list instead of a private copy of every property. Local
+// lv_obj_set_style_*() calls made afterwards still override these.
+
+// Initialize the shared styles. Call once, before any screen is built.
+void ui_theme_init(void);
+
+// Black background; drops the default theme's screen styles.
+void ui_theme_screen(lv_obj_t* scr);
+
+// Dark, cyan-outlined container for lists and forms.
+void ui_theme_panel(lv_obj_t* obj);
+
+// Flat cyan-outlined button, lighter while pressed.
+void ui_theme_tile_button(lv_obj_t* btn);
+
+// Borderless strip along the top or bottom edge of a screen.
+void ui_theme_bar(lv_obj_t* bar);
+
+// Screen title in a bar: cyan, 20 px.
+void ui_theme_title(lv_obj_t* label);
+
+#ifdef __cplusplus
+}
+#endif
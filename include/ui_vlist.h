@@ -0,0 +1,53 @@
+#pragma once
+
+#include <lvgl.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Virtual list: a scrollable panel with a fixed pool of row buttons,
+// enough to cover the visible height plus one row above and below. Rows
+// are rebound to item indices as the list scrolls, so the object count,
+// LVGL heap use and build time stay the same for 5 items or 5000.
+//
+// Items are all one height and are drawn from a callback; the list owns
+// no item data. Rows are LVGL list buttons (icon + label), so they pick
+// up the same theme styles as lv_list_add_btn() rows.
+
+// Writes the text of item `index` into buf (NUL-terminated).
+typedef void (*ui_vlist_text_cb_t)(size_t index, char* buf, size_t len);
+
+// Called when the row showing item `index` is clicked.
+typedef void (*ui_vlist_click_cb_t)(size_t index);
+
+// Styles the list panel itself. Runs before the rows exist, so styles it
+// adds are not re-applied through the whole row pool.
+typedef void (*ui_vlist_style_cb_t)(lv_obj_t* list);
+
+// Longest row text, including the NUL.
+#define UI_VLIST_TEXT_MAX 96
+
+// Create an empty list of the given size. `row_h` and `row_gap` fix the
+// item pitch; `icon` (an LV_SYMBOL_* string or NULL) is shown on every row.
+// `style_cb` may be NULL.
+lv_obj_t* ui_vlist_create(lv_obj_t* parent, lv_coord_t w, lv_coord_t h,
+                          lv_coord_t row_h, lv_coord_t row_gap, const char* icon,
+                          ui_vlist_style_cb_t style_cb,
+                          ui_vlist_text_cb_t text_cb, ui_vlist_click_cb_t click_cb);
+
+// Set the item count and redraw every visible row. The scroll position is
+// kept where it still fits.
+void ui_vlist_set_count(lv_obj_t* list, size_t count);
+size_t ui_vlist_get_count(lv_obj_t* list);
+
+// Redraw one item, if a row currently shows it.
+void ui_vlist_refresh_item(lv_obj_t* list, size_t index);
+
+// Number of row objects in the pool (fixed at create time).
+size_t ui_vlist_pool_size(lv_obj_t* list);
+
+#ifdef __cplusplus
+}
+#endif
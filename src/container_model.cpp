@@ -4,11 +4,17 @@
 #include <FS.h>
 #include <LittleFS.h>
 
+#include "klog.h"
+
 using std::string;
 
 // Single file used for all container data
 static const char* KFD_CONTAINER_FILE = "/containers.dat";
 
+// Autosave: wait for edits to settle, and space writes out.
+static const uint32_t MIN_SETTLE_MS   = 1000;
+static const uint32_t MIN_INTERVAL_MS = 3000;
+
 ContainerModel& ContainerModel::instance() {
     static ContainerModel inst;
     return inst;
@@ -43,22 +49,22 @@ void ContainerModel::loadDefaults() {
     KeySlot k1;
     k1.label    = "TG 1 - PATROL";
     k1.algo     = "AES256";
-    k1.hex      = "00112233445566778899AABBCCDDEEFF";
+    k1.hex      = "00112233445566778899AABBCCDDEEFF00112233445566778899AABBCCDDEEFF";
     k1.selected = true;
     c1.keys.push_back(k1);
 
     KeySlot k2;
     k2.label    = "TG 2 - TAC";
     k2.algo     = "AES256";
-    k2.hex      = "0123456789ABCDEF0123456789ABCDEF";
+    k2.hex      = "0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF";
     k2.selected = false;
     c1.keys.push_back(k2);
 
     containers_.push_back(c1);
     active_index_ = 0;
+    notify(ModelEventType::Reloaded);
 
-    Serial.printf("[ContainerModel] Defaults loaded (%u containers)\n",
-                  (unsigned)containers_.size());
+    KLOGI(MODEL, "Defaults loaded (%u containers)", (unsigned)containers_.size());
 
     dirty_ = true;
     last_change_ms_ = millis();
@@ -72,7 +78,7 @@ bool ContainerModel::ensureStorage() {
     if (storageReady_) return true;
 
     if (!LittleFS.begin(true)) { // formatOnFail = true
-        Serial.println("[ContainerModel] LittleFS.begin() failed");
+        KLOGE(MODEL, "LittleFS.begin() failed");
         return false;
     }
 
@@ -95,12 +101,12 @@ bool ContainerModel::ensureStorage() {
 
 bool ContainerModel::loadFromSPIFFS() {
     if (!ensureStorage()) {
-        Serial.println("[ContainerModel] loadFromSPIFFS(): storage not ready");
+        KLOGE(MODEL, "loadFromSPIFFS(): storage not ready");
         return false;
     }
 
     if (!LittleFS.exists(KFD_CONTAINER_FILE)) {
-        Serial.println("[ContainerModel] no containers file; using defaults");
+        KLOGI(MODEL, "no containers file; using defaults");
         loadDefaults();
         saveToSPIFFS();
         return true;
@@ -108,7 +114,7 @@ bool ContainerModel::loadFromSPIFFS() {
 
     File f = LittleFS.open(KFD_CONTAINER_FILE, FILE_READ);
     if (!f) {
-        Serial.println("[ContainerModel] open for read failed; using defaults");
+        KLOGW(MODEL, "open for read failed; using defaults");
         loadDefaults();
         return false;
     }
@@ -117,7 +123,7 @@ bool ContainerModel::loadFromSPIFFS() {
     String line = f.readStringUntil('\n');
     line.trim();
     if (!line.startsWith("KFDv1")) {
-        Serial.println("[ContainerModel] invalid header signature; using defaults");
+        KLOGW(MODEL, "invalid header signature; using defaults");
         f.close();
         loadDefaults();
         saveToSPIFFS();
@@ -202,7 +208,7 @@ bool ContainerModel::loadFromSPIFFS() {
     f.close();
 
     if (containers_.empty()) {
-        Serial.println("[ContainerModel] parsed zero containers; using defaults");
+        KLOGW(MODEL, "parsed zero containers; using defaults");
         loadDefaults();
         saveToSPIFFS();
         return true;
@@ -214,8 +220,8 @@ bool ContainerModel::loadFromSPIFFS() {
         active_index_ = activeIdx;
     }
 
-    Serial.printf("[ContainerModel] Loaded %u containers from LittleFS (active=%d, declared=%d)\n",
-                  (unsigned)containers_.size(), active_index_, declaredCount);
+    KLOGI(MODEL, "Loaded %u containers from LittleFS (active=%d, declared=%d)",
+          (unsigned)containers_.size(), active_index_, declaredCount);
 
     dirty_ = false;
     last_save_ms_ = millis();
@@ -224,13 +230,13 @@ bool ContainerModel::loadFromSPIFFS() {
 
 bool ContainerModel::saveToSPIFFS() {
     if (!ensureStorage()) {
-        Serial.println("[ContainerModel] saveToSPIFFS(): storage not ready");
+        KLOGE(MODEL, "saveToSPIFFS(): storage not ready");
         return false;
     }
 
     File f = LittleFS.open(KFD_CONTAINER_FILE, FILE_WRITE);
     if (!f) {
-        Serial.println("[ContainerModel] open for write failed");
+        KLOGE(MODEL, "open for write failed");
         return false;
     }
 
@@ -258,8 +264,7 @@ bool ContainerModel::saveToSPIFFS() {
     }
 
     f.close();
-    Serial.printf("[ContainerModel] Saved %u containers to LittleFS (active=%d)\n",
-                  (unsigned)containers_.size(), activeIdx);
+    KLOGI(MODEL, "Saved %u containers to LittleFS (active=%d)", (unsigned)containers_.size(), activeIdx);
     return true;
 }
 
@@ -269,73 +274,69 @@ bool ContainerModel::saveToSPIFFS() {
 
 bool ContainerModel::load() {
     if (!ensureStorage()) {
-        Serial.println("[ContainerModel] Storage not ready, using defaults in RAM");
+        KLOGW(MODEL, "Storage not ready, using defaults in RAM");
         loadDefaults();
         return false;
     }
 
-    if (!loadFromSPIFFS()) {
-        return false;
-    }
-
-    return true;
+    // A failed load may still have replaced the list (or reloaded defaults).
+    const bool ok = loadFromSPIFFS();
+    notify(ModelEventType::Reloaded);
+    return ok;
 }
 
 bool ContainerModel::save() {
     dirty_ = true;
     last_change_ms_ = millis();
-    Serial.printf("[ContainerModel] save() -> mark dirty (count=%u)\n",
-                  (unsigned)containers_.size());
+    KLOGD(MODEL, "save() -> mark dirty (count=%u)", (unsigned)containers_.size());
     return true;
 }
 
 bool ContainerModel::saveNow() {
     if (!ensureStorage()) {
-        Serial.println("[ContainerModel] saveNow(): storage not ready");
+        KLOGE(MODEL, "saveNow(): storage not ready");
         return false;
     }
     if (!saveToSPIFFS()) {
-        Serial.printf("[ContainerModel] saveNow() failed; RAM-only state (%u containers)\n",
-                      (unsigned)containers_.size());
+        KLOGW(MODEL, "saveNow() failed; RAM-only state (%u containers)", (unsigned)containers_.size());
         return false;
     }
 
     dirty_ = false;
     last_save_ms_ = millis();
-    Serial.printf("[ContainerModel] saveNow() OK (%u containers)\n",
-                  (unsigned)containers_.size());
+    KLOGI(MODEL, "saveNow() OK (%u containers)", (unsigned)containers_.size());
     return true;
 }
 
 bool ContainerModel::factoryReset() {
-    Serial.println("[ContainerModel] FACTORY RESET requested");
+    KLOGI(MODEL, "FACTORY RESET requested");
 
     if (!ensureStorage()) {
-        Serial.println("[ContainerModel] factoryReset(): storage not ready");
+        KLOGE(MODEL, "factoryReset(): storage not ready");
         return false;
     }
 
     if (!LittleFS.format()) {
-        Serial.println("[ContainerModel] factoryReset(): LittleFS.format() failed");
+        KLOGE(MODEL, "factoryReset(): LittleFS.format() failed");
         return false;
     }
 
     storageReady_ = false;
     if (!ensureStorage()) {
-        Serial.println("[ContainerModel] factoryReset(): remount after format failed");
+        KLOGE(MODEL, "factoryReset(): remount after format failed");
         return false;
     }
 
     loadDefaults();
     if (!saveToSPIFFS()) {
-        Serial.println("[ContainerModel] factoryReset(): save defaults failed");
+        KLOGE(MODEL, "factoryReset(): save defaults failed");
         return false;
     }
 
     dirty_ = false;
     last_save_ms_ = millis();
 
-    Serial.println("[ContainerModel] FACTORY RESET complete (defaults written)");
+    KLOGI(MODEL, "FACTORY RESET complete (defaults written)");
     return true;
 }
 
@@ -343,15 +344,25 @@ void ContainerModel::service() {
     if (!dirty_) return;
 
     uint32_t now = millis();
-    const uint32_t MIN_SETTLE_MS   = 1000;
-    const uint32_t MIN_INTERVAL_MS = 3000;
-
     if (now - last_change_ms_ < MIN_SETTLE_MS) return;
     if (now - last_save_ms_   < MIN_INTERVAL_MS) return;
 
     (void)saveNow();
 }
 
+// Lets the main loop sleep right up to the next save attempt.
+uint32_t ContainerModel::msUntilService() const {
+    if (!dirty_) return UINT32_MAX;
+
+    uint32_t now     = millis();
+    uint32_t settled = now - last_change_ms_;
+    uint32_t spaced  = now - last_save_ms_;
+    uint32_t wait    = 0;
+    if (settled < MIN_SETTLE_MS)   wait = MIN_SETTLE_MS - settled;
+    if (spaced  < MIN_INTERVAL_MS && MIN_INTERVAL_MS - spaced > wait) wait = MIN_INTERVAL_MS - spaced;
+    return wait;
+}
+
 // ----- CRUD -----
 
 size_t ContainerModel::getCount() const {
@@ -392,6 +403,9 @@ bool ContainerModel::setActiveIndex(int idx) {
     if (idx < 0 || idx >= (int)containers_.size()) {
         return false;
     }
+    if (active_index_ != idx) {
+        notify(ModelEventType::ActiveChanged, idx);
+    }
     active_index_ = idx;
     save();
     return true;
@@ -406,27 +420,38 @@ const KeyContainer* ContainerModel::getActive() const {
 
 int ContainerModel::addContainer(const KeyContainer& c) {
     containers_.push_back(c);
+    const int idx = (int)containers_.size() - 1;
+    notify(ModelEventType::ContainerAdded, idx);
     if (active_index_ < 0) {
         active_index_ = 0;
+        notify(ModelEventType::ActiveChanged, 0);
     }
     save();
-    return (int)containers_.size() - 1;
+    return idx;
 }
 
 bool ContainerModel::updateContainer(size_t idx, const KeyContainer& c) {
     if (idx >= containers_.size()) return false;
     containers_[idx] = c;
+    notify(ModelEventType::ContainerUpdated, (int)idx);
     return save();
 }
 
 bool ContainerModel::deleteContainer(size_t idx) {
     if (idx >= containers_.size()) return false;
     containers_.erase(containers_.begin() + idx);
+    notify(ModelEventType::ContainerRemoved, (int)idx);
+
+    const int was_active = active_index_;
     if (containers_.empty()) {
         active_index_ = -1;
     } else if (active_index_ >= (int)containers_.size()) {
         active_index_ = (int)containers_.size() - 1;
     }
+    // At or after the removed slot, the active index now names another container.
+    if (was_active >= (int)idx) {
+        notify(ModelEventType::ActiveChanged, active_index_);
+    }
     return save();
 }
 
@@ -439,7 +464,9 @@ bool ContainerModel::moveContainer(size_t fromIdx, size_t toIdx) {
     auto tmp = containers_[fromIdx];
     containers_.erase(containers_.begin() + fromIdx);
     containers_.insert(containers_.begin() + toIdx, tmp);
+    notify(ModelEventType::ContainerMoved, (int)fromIdx, (int)toIdx);
 
+    // The active container stays active; only its index follows it.
     if (active_index_ == (int)fromIdx) {
         active_index_ = (int)toIdx;
     } else if (active_index_ > (int)fromIdx && active_index_ <= (int)toIdx) {
@@ -454,6 +481,7 @@ bool ContainerModel::moveContainer(size_t fromIdx, size_t toIdx) {
 bool ContainerModel::addKey(size_t containerIdx, const KeySlot& slot) {
     if (containerIdx >= containers_.size()) return false;
     containers_[containerIdx].keys.push_back(slot);
+    notify(ModelEventType::KeyAdded, (int)containerIdx, (int)containers_[containerIdx].keys.size() - 1);
     return save();
 }
 
@@ -462,6 +490,7 @@ bool ContainerModel::updateKey(size_t containerIdx, size_t keyIdx, const KeySlot
     auto& kc = containers_[containerIdx];
     if (keyIdx >= kc.keys.size()) return false;
     kc.keys[keyIdx] = slot;
+    notify(ModelEventType::KeyUpdated, (int)containerIdx, (int)keyIdx);
     return save();
 }
 
@@ -470,5 +499,62 @@ bool ContainerModel::removeKey(size_t containerIdx, size_t keyIdx) {
     auto& kc = containers_[containerIdx];
     if (keyIdx >= kc.keys.size()) return false;
     kc.keys.erase(kc.keys.begin() + keyIdx);
+    notify(ModelEventType::KeyRemoved, (int)containerIdx, (int)keyIdx);
     return save();
 }
+
+// ----- change events -----
+
+// A queued Reloaded makes observers re-read everything when it is
+// dispatched, so nothing queued before or after it adds anything.
+void ContainerModel::notify(ModelEventType type, int container, int key) {
+    const ModelEvent ev = { type, (int16_t)container, (int16_t)key };
+
+    if (type == ModelEventType::Reloaded) pending_.clear();
+
+    if (!pending_.empty()) {
+        const ModelEvent& last = pending_.back();
+        if (last.type == ModelEventType::Reloaded) return;
+        // The same update twice in a row (e.g. a key saved again) is one
+        // change. Adds, removes and moves are not: each shifts indices.
+        const bool idempotent = ev.type == ModelEventType::ContainerUpdated ||
+                                ev.type == ModelEventType::KeyUpdated ||
+                                ev.type == ModelEventType::ActiveChanged;
+        if (idempotent && last.type == ev.type && last.container == ev.container && last.key == ev.key) return;
+    }
+
+    if (pending_.size() >= MAX_PENDING_EVENTS) {
+        KLOGD(MODEL, "events: %u queued, collapsing to reload", (unsigned)pending_.size());
+        pending_.clear();
+        pending_.push_back({ ModelEventType::Reloaded, -1, -1 });
+        return;
+    }
+    pending_.push_back(ev);
+}
+
+bool ContainerModel::addObserver(ModelObserverFn fn, void* ctx) {
+    if (!fn) return false;
+    for (const auto& o : observers_) {
+        if (o.fn == fn && o.ctx == ctx) return false;
+    }
+    observers_.push_back({ fn, ctx });
+    return true;
+}
+
+void ContainerModel::removeObserver(ModelObserverFn fn, void* ctx) {
+    for (auto it = observers_.begin(); it != observers_.end(); ++it) {
+        if (it->fn == fn && it->ctx == ctx) {
+            observers_.erase(it);
+            return;
+        }
+    }
+}
+
+void ContainerModel::dispatchEvents() {
+    if (pending_.empty()) return;
+
+    // Observers may mutate the model; those changes go out next time.
+    dispatching_.swap(pending_);
+    for (const auto& o : observers_) o.fn(dispatching_.data(), dispatching_.size(), o.ctx);
+    dispatching_.clear();
+}
@@ -33,6 +33,29 @@ struct KeyContainer {
     }
 };
 
+// What changed in the model. Indices are as they are right after the
+// change; -1 where a field does not apply.
+enum class ModelEventType : uint8_t {
+    ContainerAdded,    // container
+    ContainerRemoved,  // container (the index it had)
+    ContainerMoved,    // container = from, key = to
+    ContainerUpdated,  // container (its own fields, not its keys)
+    KeyAdded,          // container, key
+    KeyUpdated,        // container, key
+    KeyRemoved,        // container, key (the index it had)
+    ActiveChanged,     // container = new active index
+    Reloaded,          // list replaced, or too many changes to list: re-read it all
+};
+
+struct ModelEvent {
+    ModelEventType type;
+    int16_t        container;
+    int16_t        key;
+};
+
+// Gets every change since the last dispatch, oldest first.
+typedef void (*ModelObserverFn)(const ModelEvent* events, size_t count, void* ctx);
+
 class ContainerModel {
 public:
     static ContainerModel& instance();
@@ -44,6 +67,7 @@ public:
     bool factoryReset();
     void loadDefaults();
     void service();   // periodic deferred autosave
+    uint32_t msUntilService() const;  // until service() would save; UINT32_MAX if clean
 
     // ----- basic access -----
     size_t              getCount() const;
@@ -74,6 +98,16 @@ public:
     bool updateKey(size_t containerIdx, size_t keyIdx, const KeySlot& slot);
     bool removeKey(size_t containerIdx, size_t keyIdx);
 
+    // ----- change events -----
+    // Mutations queue ModelEvents; dispatchEvents() hands the queue to each
+    // observer as one batch. The main loop dispatches once per pass, before
+    // LVGL draws, so a burst of edits reaches the screens as a single patch.
+    // Changes made through getMutable() queue nothing.
+    bool addObserver(ModelObserverFn fn, void* ctx);
+    void removeObserver(ModelObserverFn fn, void* ctx);
+    void dispatchEvents();
+    bool eventsPending() const { return !pending_.empty(); }
+
 private:
     ContainerModel();
     ContainerModel(const ContainerModel&) = delete;
@@ -83,8 +117,21 @@ private:
     bool loadFromSPIFFS();  // internal helpers, use LittleFS underneath
     bool saveToSPIFFS();
 
+    // More than this per dispatch collapse into a single Reloaded.
+    static constexpr size_t MAX_PENDING_EVENTS = 32;
+
+    void notify(ModelEventType type, int container = -1, int key = -1);
+
+    struct Observer {
+        ModelObserverFn fn;
+        void*           ctx;
+    };
+
     std::vector<KeyContainer> containers_;
     int                       active_index_;
+    std::vector<ModelEvent>   pending_;
+    std::vector<ModelEvent>   dispatching_;  // batch being delivered; keeps its capacity
+    std::vector<Observer>     observers_;
 
     bool     storageReady_;
     bool     dirty_;
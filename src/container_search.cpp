@@ -0,0 +1,326 @@
+#include "container_search.h"
+
+#include <algorithm>
+#include <iterator>
+#include <string.h>
+
+#include "klog.h"
+
+// Posting layout: kind (2 bits) | gram (24 bits) | slot (16 bits).
+static constexpr uint64_t KIND_TRIGRAM = 1;
+static constexpr uint64_t KIND_PREFIX  = 2;
+
+static constexpr size_t MAX_QUERY = 64;
+
+constexpr uint16_t ContainerSearch::NO_SLOT;
+
+static inline uint8_t fold(uint8_t c) {
+    return (c >= 'A' && c <= 'Z') ? (uint8_t)(c + ('a' - 'A')) : c;
+}
+
+// Letters, digits, and any UTF-8 byte: the bytes a word is made of.
+static inline bool isWordByte(uint8_t c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+static inline uint64_t gramKey(uint64_t kind, uint32_t gram) {
+    return (kind << 24 | gram) << 16;
+}
+
+static inline uint32_t trigram(const uint8_t* p) {
+    return (uint32_t)fold(p[0]) << 16 | (uint32_t)fold(p[1]) << 8 | fold(p[2]);
+}
+
+// One- and two-character prefixes never collide: the second byte of a
+// two-character gram is non-zero.
+static inline uint32_t prefixGram(const uint8_t* p, size_t len) {
+    return len == 1 ? fold(p[0]) : ((uint32_t)fold(p[0]) << 8 | fold(p[1]));
+}
+
+// Case-insensitive substring test; `term` is already lower case.
+static bool icontains(const std::string& s, const char* term, size_t len) {
+    if (len > s.size()) return false;
+    const uint8_t* p = (const uint8_t*)s.data();
+    for (size_t i = 0; i + len <= s.size(); ++i) {
+        size_t j = 0;
+        while (j < len && fold(p[i + j]) == (uint8_t)term[j]) ++j;
+        if (j == len) return true;
+    }
+    return false;
+}
+
+static bool containerContains(const KeyContainer& kc, const char* term, size_t len) {
+    if (icontains(kc.label, term, len) || icontains(kc.agency, term, len) || icontains(kc.band, term, len))
+        return true;
+    for (const auto& ks : kc.keys) {
+        if (icontains(ks.label, term, len)) return true;
+    }
+    return false;
+}
+
+// Range of postings for one gram.
+static void gramRange(const std::vector<uint64_t>& postings, uint64_t key,
+                      std::vector<uint64_t>::const_iterator& lo,
+                      std::vector<uint64_t>::const_iterator& hi) {
+    lo = std::lower_bound(postings.begin(), postings.end(), key);
+    hi = std::lower_bound(lo, postings.end(), key + 0x10000);
+}
+
+ContainerSearch& ContainerSearch::instance() {
+    static ContainerSearch inst;
+    return inst;
+}
+
+void ContainerSearch::begin() {
+    rebuild();
+    ContainerModel::instance().addObserver(onModelEvents, this);
+}
+
+// -------------------------------------------------------
+// Indexing
+// -------------------------------------------------------
+
+void ContainerSearch::addPostings(uint16_t slot, const KeyContainer& kc, std::vector<uint64_t>& out) const {
+    const size_t first = out.size();
+
+    auto addField = [&](const std::string& s) {
+        const uint8_t* p = (const uint8_t*)s.data();
+        const size_t   n = s.size();
+        for (size_t i = 0; i < n; ++i) {
+            if (i + 3 <= n) out.push_back(gramKey(KIND_TRIGRAM, trigram(p + i)) | slot);
+            if (!isWordByte(p[i]) || (i > 0 && isWordByte(p[i - 1]))) continue;
+            out.push_back(gramKey(KIND_PREFIX, prefixGram(p + i, 1)) | slot);
+            if (i + 1 < n && isWordByte(p[i + 1]))
+                out.push_back(gramKey(KIND_PREFIX, prefixGram(p + i, 2)) | slot);
+        }
+    };
+
+    addField(kc.label);
+    addField(kc.agency);
+    addField(kc.band);
+    for (const auto& ks : kc.keys) addField(ks.label);
+
+    std::sort(out.begin() + first, out.end());
+    out.erase(std::unique(out.begin() + first, out.end()), out.end());
+}
+
+void ContainerSearch::rebuild() {
+    ContainerModel& model = ContainerModel::instance();
+    const size_t    count = model.getCount();
+
+    slot_of_.resize(count);
+    index_of_.resize(count);
+    free_.clear();
+    postings_.clear();
+    for (size_t i = 0; i < count; ++i) {
+        slot_of_[i] = index_of_[i] = (uint16_t)i;
+        addPostings((uint16_t)i, model.get(i), postings_);
+    }
+    std::sort(postings_.begin(), postings_.end());
+    generation_++;
+
+    KLOGI(MODEL, "search: indexed %u containers, %u postings", (unsigned)count,
+          (unsigned)postings_.size());
+}
+
+uint16_t ContainerSearch::allocSlot() {
+    if (!free_.empty()) {
+        const uint16_t s = free_.back();
+        free_.pop_back();
+        return s;
+    }
+    index_of_.push_back(NO_SLOT);
+    return (uint16_t)(index_of_.size() - 1);
+}
+
+void ContainerSearch::renumber() {
+    std::fill(index_of_.begin(), index_of_.end(), NO_SLOT);
+    for (size_t i = 0; i < slot_of_.size(); ++i) index_of_[slot_of_[i]] = (uint16_t)i;
+}
+
+// Drop every posting of `slots`, then add fresh ones for those still in
+// use: one pass over the array and one merge, however many slots changed.
+void ContainerSearch::reindex(const std::vector<uint16_t>& slots) {
+    std::vector<bool> drop(index_of_.size(), false);
+    for (uint16_t s : slots) drop[s] = true;
+
+    postings_.erase(std::remove_if(postings_.begin(), postings_.end(),
+                                   [&](uint64_t p) { return drop[(uint16_t)p]; }),
+                    postings_.end());
+
+    ContainerModel&       model = ContainerModel::instance();
+    std::vector<uint64_t> fresh;
+    for (uint16_t s : slots) {
+        if (index_of_[s] != NO_SLOT) addPostings(s, model.get(index_of_[s]), fresh);
+    }
+    std::sort(fresh.begin(), fresh.end());
+
+    const size_t mid = postings_.size();
+    postings_.insert(postings_.end(), fresh.begin(), fresh.end());
+    std::inplace_merge(postings_.begin(), postings_.begin() + mid, postings_.end());
+}
+
+void ContainerSearch::onModelEvents(const ModelEvent* events, size_t count, void* ctx) {
+    static_cast<ContainerSearch*>(ctx)->apply(events, count);
+}
+
+// Structural events are replayed on slot_of_ in order; content is read
+// from the model only at the end, once slot_of_ matches it again.
+void ContainerSearch::apply(const ModelEvent* events, size_t count) {
+    std::vector<uint16_t> dirty;
+    bool                  changed = false;
+
+    for (size_t i = 0; i < count; ++i) {
+        const ModelEvent& e = events[i];
+        const size_t      c = (size_t)e.container;
+
+        switch (e.type) {
+            case ModelEventType::Reloaded:
+                rebuild();
+                return;
+
+            case ModelEventType::ContainerAdded: {
+                if (e.container < 0 || c > slot_of_.size()) { rebuild(); return; }
+                const uint16_t s = allocSlot();
+                slot_of_.insert(slot_of_.begin() + c, s);
+                dirty.push_back(s);
+                break;
+            }
+
+            case ModelEventType::ContainerRemoved:
+                if (e.container < 0 || c >= slot_of_.size()) { rebuild(); return; }
+                dirty.push_back(slot_of_[c]);  // drops its postings
+                free_.push_back(slot_of_[c]);
+                slot_of_.erase(slot_of_.begin() + c);
+                break;
+
+            case ModelEventType::ContainerMoved: {
+                const size_t to = (size_t)e.key;
+                if (e.container < 0 || e.key < 0 || c >= slot_of_.size() || to >= slot_of_.size()) {
+                    rebuild();
+                    return;
+                }
+                const uint16_t s = slot_of_[c];
+                slot_of_.erase(slot_of_.begin() + c);
+                slot_of_.insert(slot_of_.begin() + to, s);
+                changed = true;
+                break;
+            }
+
+            case ModelEventType::ContainerUpdated:
+            case ModelEventType::KeyAdded:
+            case ModelEventType::KeyUpdated:
+            case ModelEventType::KeyRemoved:
+                if (e.container >= 0 && c < slot_of_.size()) dirty.push_back(slot_of_[c]);
+                break;
+
+            case ModelEventType::ActiveChanged:
+                break;
+        }
+    }
+
+    if (slot_of_.size() != ContainerModel::instance().getCount()) {
+        rebuild();
+        return;
+    }
+    renumber();
+
+    if (!dirty.empty()) {
+        std::sort(dirty.begin(), dirty.end());
+        dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+        reindex(dirty);
+        changed = true;
+    }
+    if (changed) generation_++;
+}
+
+// -------------------------------------------------------
+// Queries
+// -------------------------------------------------------
+
+void ContainerSearch::findTerm(const char* term, size_t len, std::vector<uint16_t>& out) const {
+    out.clear();
+    ContainerModel& model = ContainerModel::instance();
+    const uint8_t*  t     = (const uint8_t*)term;
+
+    std::vector<uint64_t>::const_iterator lo, hi;
+
+    if (len <= 2 && isWordByte(t[0]) && (len == 1 || isWordByte(t[1]))) {
+        gramRange(postings_, gramKey(KIND_PREFIX, prefixGram(t, len)), lo, hi);
+        for (auto it = lo; it != hi; ++it) out.push_back((uint16_t)*it);
+        return;
+    }
+
+    if (len <= 2) {
+        // Punctuation is not indexed as a word start; short terms with it
+        // are rare enough to check directly.
+        for (size_t i = 0; i < slot_of_.size(); ++i) {
+            if (containerContains(model.get(i), term, len)) out.push_back(slot_of_[i]);
+        }
+        std::sort(out.begin(), out.end());
+        return;
+    }
+
+    // Candidates come from the term's rarest trigram.
+    auto best_lo = postings_.end(), best_hi = postings_.end();
+    size_t best = SIZE_MAX;
+    for (size_t i = 0; i + 3 <= len; ++i) {
+        gramRange(postings_, gramKey(KIND_TRIGRAM, trigram(t + i)), lo, hi);
+        const size_t n = (size_t)(hi - lo);
+        if (n == 0) return;
+        if (n < best) {
+            best    = n;
+            best_lo = lo;
+            best_hi = hi;
+        }
+    }
+
+    for (auto it = best_lo; it != best_hi; ++it) {
+        const uint16_t s   = (uint16_t)*it;
+        const uint16_t idx = index_of_[s];
+        if (idx != NO_SLOT && containerContains(model.get(idx), term, len)) out.push_back(s);
+    }
+}
+
+size_t ContainerSearch::find(const char* query, std::vector<uint16_t>& out, size_t limit) const {
+    out.clear();
+
+    char   q[MAX_QUERY + 1];
+    size_t qlen = 0;
+    for (const char* p = query ? query : ""; *p && qlen < MAX_QUERY; ++p) q[qlen++] = (char)fold((uint8_t)*p);
+    q[qlen] = '\0';
+
+    std::vector<uint16_t> acc, term_slots, both;
+    bool                  any_term = false;
+
+    for (size_t i = 0; i < qlen;) {
+        while (i < qlen && q[i] == ' ') ++i;
+        size_t j = i;
+        while (j < qlen && q[j] != ' ') ++j;
+        if (j == i) break;
+
+        findTerm(q + i, j - i, any_term ? term_slots : acc);
+        if (any_term) {
+            both.clear();
+            std::set_intersection(acc.begin(), acc.end(), term_slots.begin(), term_slots.end(),
+                                  std::back_inserter(both));
+            acc.swap(both);
+        }
+        any_term = true;
+        if (acc.empty()) return 0;
+        i = j;
+    }
+
+    if (!any_term) {
+        const size_t count = slot_of_.size();
+        for (size_t i = 0; i < count && i < limit; ++i) out.push_back((uint16_t)i);
+        return count;
+    }
+
+    out.reserve(acc.size());
+    for (uint16_t s : acc) out.push_back(index_of_[s]);
+    std::sort(out.begin(), out.end());
+    const size_t total = out.size();
+    if (out.size() > limit) out.resize(limit);
+    return total;
+}
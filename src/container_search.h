@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "container_model.h"
+
+// Type-ahead search over the container library: labels, agencies, bands
+// and key labels. Kept current from ContainerModel's change events, so a
+// keystroke only looks the query up; nothing is rescanned.
+//
+// A query is split into terms on spaces; a container matches if it
+// matches every term, ignoring ASCII case:
+//   - a term of one or two characters matches the start of a word
+//     (word-prefix index: "fd" finds "Plantation FD");
+//   - a longer term matches anywhere (trigram index narrows the
+//     candidates, a substring check of those confirms).
+//
+// All postings live in one sorted array of (gram, slot) pairs: 8 bytes
+// each, one allocation, which the heap places in PSRAM once it grows.
+// A slot is a container's document id. Slots survive moves and removals
+// of other containers, so those renumber without reindexing.
+class ContainerSearch {
+public:
+    static ContainerSearch& instance();
+
+    // Index the current model and follow its events from here on. Call
+    // before the UI observes the model, so results are current when the
+    // UI's observer runs.
+    void begin();
+
+    // Model indices of the containers matching `query`, ascending, at most
+    // `limit` of them. Returns the number of matches, which may exceed
+    // `limit`. An empty query matches everything.
+    size_t find(const char* query, std::vector<uint16_t>& out, size_t limit = SIZE_MAX) const;
+
+    // Bumped whenever a change may alter some query's results.
+    uint32_t generation() const { return generation_; }
+
+    size_t postingCount() const { return postings_.size(); }
+
+private:
+    ContainerSearch() = default;
+    ContainerSearch(const ContainerSearch&) = delete;
+    ContainerSearch& operator=(const ContainerSearch&) = delete;
+
+    static constexpr uint16_t NO_SLOT = 0xFFFF;
+
+    static void onModelEvents(const ModelEvent* events, size_t count, void* ctx);
+    void apply(const ModelEvent* events, size_t count);
+
+    void     rebuild();
+    uint16_t allocSlot();
+    void     renumber();  // index_of_ from slot_of_
+    void     addPostings(uint16_t slot, const KeyContainer& kc, std::vector<uint64_t>& out) const;
+    void     reindex(const std::vector<uint16_t>& slots);  // sorted, unique
+
+    // Slots matching one lower-case term, ascending.
+    void findTerm(const char* term, size_t len, std::vector<uint16_t>& out) const;
+
+    std::vector<uint64_t> postings_;  // (kind, gram, slot), sorted
+    std::vector<uint16_t> slot_of_;   // model index -> slot
+    std::vector<uint16_t> index_of_;  // slot -> model index, NO_SLOT if free
+    std::vector<uint16_t> free_;
+
+    uint32_t generation_ = 0;
+};
@@ -0,0 +1,125 @@
+#include "hex_codec.h"
+
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+// Compile-time tables (C++11 constexpr, same scheme as the CRC table)
+// -----------------------------------------------------------------------------
+
+static constexpr uint8_t HEX_SKIP    = 0x10;  // whitespace
+static constexpr uint8_t HEX_INVALID = 0xFF;
+
+static constexpr uint8_t hexValue(size_t c) {
+  return (c >= '0' && c <= '9') ? (uint8_t)(c - '0')
+       : (c >= 'A' && c <= 'F') ? (uint8_t)(c - 'A' + 10)
+       : (c >= 'a' && c <= 'f') ? (uint8_t)(c - 'a' + 10)
+       : (c == ' ' || c == '\t' || c == '\r' || c == '\n') ? HEX_SKIP
+       : HEX_INVALID;
+}
+
+static constexpr char hexDigit(size_t nibble) {
+  return (char)(nibble < 10 ? '0' + nibble : 'A' + (nibble - 10));
+}
+
+// Two digits per byte: pair index i covers byte i / 2, high nibble first.
+static constexpr char hexPairChar(size_t i) {
+  return hexDigit((i & 1) ? ((i >> 1) & 0x0F) : (i >> 5));
+}
+
+template <size_t... I> struct HexIndex {};
+template <size_t N, size_t... I> struct MakeHexIndex : MakeHexIndex<N - 1, N - 1, I...> {};
+template <size_t... I> struct MakeHexIndex<0, I...> { typedef HexIndex<I...> type; };
+
+struct HexDecodeTable {
+  uint8_t v[256];
+};
+
+struct HexEncodeTable {
+  char v[512];
+};
+
+template <size_t... I>
+static constexpr HexDecodeTable makeDecodeTable(HexIndex<I...>) {
+  return HexDecodeTable{ { hexValue(I)... } };
+}
+
+template <size_t... I>
+static constexpr HexEncodeTable makeEncodeTable(HexIndex<I...>) {
+  return HexEncodeTable{ { hexPairChar(I)... } };
+}
+
+static constexpr HexDecodeTable HEX_DECODE = makeDecodeTable(MakeHexIndex<256>::type());
+static constexpr HexEncodeTable HEX_ENCODE = makeEncodeTable(MakeHexIndex<512>::type());
+
+static_assert(HEX_DECODE.v['7'] == 7 && HEX_DECODE.v['c'] == 12 && HEX_DECODE.v['F'] == 15,
+              "hex decode table generation broken");
+static_assert(HEX_DECODE.v[' '] == HEX_SKIP && HEX_DECODE.v['G'] == HEX_INVALID,
+              "hex decode table generation broken");
+static_assert(HEX_ENCODE.v[2 * 0xA5] == 'A' && HEX_ENCODE.v[2 * 0xA5 + 1] == '5',
+              "hex encode table generation broken");
+
+// -----------------------------------------------------------------------------
+// Codec
+// -----------------------------------------------------------------------------
+
+HexStatus hexDecode(const char* hex, size_t len, uint8_t* out, size_t outMax, size_t& outLen) {
+  outLen = 0;
+  size_t  n    = 0;
+  uint8_t hi   = 0;
+  bool    half = false;
+
+  for (size_t i = 0; i < len; ++i) {
+    const uint8_t v = HEX_DECODE.v[(uint8_t)hex[i]];
+    if (v == HEX_SKIP) continue;
+    if (v == HEX_INVALID) return HEX_BAD_CHAR;
+
+    if (!half) {
+      hi   = (uint8_t)(v << 4);
+      half = true;
+      continue;
+    }
+    if (n == outMax) return HEX_TOO_LONG;
+    out[n++] = (uint8_t)(hi | v);
+    half     = false;
+  }
+
+  if (half) return HEX_ODD_DIGITS;
+  outLen = n;
+  return HEX_OK;
+}
+
+HexStatus hexCanonicalize(const char* hex, size_t len, char* out, size_t outMax, size_t& outLen) {
+  outLen = 0;
+  size_t n = 0;
+
+  for (size_t i = 0; i < len; ++i) {
+    const uint8_t v = HEX_DECODE.v[(uint8_t)hex[i]];
+    if (v == HEX_SKIP) continue;
+    if (v == HEX_INVALID) return HEX_BAD_CHAR;
+    if (n == outMax) return HEX_TOO_LONG;
+    out[n++] = hexDigit(v);
+  }
+
+  if (n & 1) return HEX_ODD_DIGITS;
+  outLen = n;
+  return HEX_OK;
+}
+
+size_t hexEncode(const uint8_t* data, size_t len, char* out, size_t outMax) {
+  if (outMax < 2 * len + 1) return 0;
+  for (size_t i = 0; i < len; ++i) {
+    memcpy(out + 2 * i, &HEX_ENCODE.v[2 * data[i]], 2);
+  }
+  out[2 * len] = '\0';
+  return 2 * len;
+}
+
+const char* hexStatusName(HexStatus s) {
+  switch (s) {
+    case HEX_OK:         return "OK";
+    case HEX_BAD_CHAR:   return "INVALID HEX CHARACTER";
+    case HEX_ODD_DIGITS: return "HEX LENGTH MUST BE EVEN";
+    case HEX_TOO_LONG:   return "HEX TOO LONG";
+  }
+  return "UNKNOWN";
+}
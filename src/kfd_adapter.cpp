@@ -0,0 +1,209 @@
+#include "kfd_adapter.h"
+
+#include <Arduino.h>
+
+#include "kfd_frame.h"
+#include "klog.h"
+
+// Identity reported to the host. The model is a KFD100, the one the
+// desktop application knows; the IDs come from the factory MAC.
+static constexpr uint8_t KFD_AP_VERSION[3] = { 2, 0, 0 };
+static constexpr uint8_t KFD_AP_FW_VER[3]  = { 1, 0, 0 };
+static constexpr uint8_t KFD_AP_MODEL_ID   = 0x01;
+static constexpr uint8_t KFD_AP_HW_REV[2]  = { 2, 0 };
+
+// -----------------------------------------------------------------------------
+// Stream side
+// -----------------------------------------------------------------------------
+
+void KfdToolAdapter::begin() {
+  _rxLen    = 0;
+  _inPacket = false;
+  _escape   = false;
+  _overflow = false;
+  _txLen    = 0;
+  _line.close();
+}
+
+bool KfdToolAdapter::service() {
+  // Drain in blocks: the CDC driver hands over whole USB transfers.
+  uint8_t in[256];
+  int     avail;
+  while ((avail = _io.available()) > 0) {
+    const size_t n = _io.readBytes(in, (size_t)avail < sizeof(in) ? (size_t)avail : sizeof(in));
+    if (n == 0) break;
+    for (size_t i = 0; i < n; ++i) rxByte(in[i]);
+  }
+
+  uint8_t b;
+  while (_line.readByte(b)) {
+    const uint8_t bcst[3] = { KFD_AP_BCST_RECEIVE_BYTE, 0x00, b };
+    sendPacket(bcst, sizeof(bcst));
+    _bytesFromRadio++;
+  }
+
+  if (_txLen == 0) return false;
+  flush();
+  return true;
+}
+
+// SOM and EOM are the same byte: a 0x61 ends a packet with a body and
+// (re)starts an empty one, so a lost EOM costs one packet, not the link.
+void KfdToolAdapter::rxByte(uint8_t b) {
+  if (b == KFD_AP_SOM_EOM) {
+    if (_inPacket && _rxLen > 0) {
+      if (_overflow || _escape) {
+        _badPackets++;
+        sendError(KFD_AP_ERR_INVALID_CMD_LENGTH);
+      } else {
+        _packetsIn++;
+        handlePacket(_rx, _rxLen);
+      }
+      _inPacket = false;
+    } else {
+      _inPacket = true;
+    }
+    _rxLen    = 0;
+    _escape   = false;
+    _overflow = false;
+    return;
+  }
+  if (!_inPacket) return;  // noise between packets
+
+  if (_escape) {
+    _escape = false;
+    if (b == KFD_AP_SOM_EOM_PLACEHOLDER) b = KFD_AP_SOM_EOM;
+    else if (b == KFD_AP_ESC_PLACEHOLDER) b = KFD_AP_ESC;
+    else _overflow = true;  // invalid escape: reject the packet
+  } else if (b == KFD_AP_ESC) {
+    _escape = true;
+    return;
+  }
+
+  if (_rxLen < sizeof(_rx)) _rx[_rxLen++] = b;
+  else _overflow = true;
+}
+
+void KfdToolAdapter::sendPacket(const uint8_t* body, size_t len) {
+  // Worst case every byte is escaped; flush first if that may not fit.
+  if (_txLen + 2 * len + 2 > sizeof(_tx)) flush();
+
+  _tx[_txLen++] = KFD_AP_SOM_EOM;
+  for (size_t i = 0; i < len; ++i) {
+    if (body[i] == KFD_AP_SOM_EOM) {
+      _tx[_txLen++] = KFD_AP_ESC;
+      _tx[_txLen++] = KFD_AP_SOM_EOM_PLACEHOLDER;
+    } else if (body[i] == KFD_AP_ESC) {
+      _tx[_txLen++] = KFD_AP_ESC;
+      _tx[_txLen++] = KFD_AP_ESC_PLACEHOLDER;
+    } else {
+      _tx[_txLen++] = body[i];
+    }
+  }
+  _tx[_txLen++] = KFD_AP_SOM_EOM;
+}
+
+void KfdToolAdapter::sendError(uint8_t code) {
+  const uint8_t rsp[2] = { KFD_AP_RSP_ERROR, code };
+  sendPacket(rsp, sizeof(rsp));
+}
+
+void KfdToolAdapter::flush() {
+  if (_txLen == 0) return;
+  _io.write(_tx, _txLen);
+  _txLen = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Commands
+// -----------------------------------------------------------------------------
+
+void KfdToolAdapter::handlePacket(const uint8_t* p, size_t len) {
+  const uint8_t rsp = (uint8_t)(p[0] + KFD_AP_RSP_OFFSET);
+
+  switch (p[0]) {
+    case KFD_AP_CMD_READ:
+      if (len != 2) break;
+      handleRead(p[1]);
+      return;
+
+    case KFD_AP_CMD_RESET:
+      if (len != 1) break;
+      _line.close();
+      sendPacket(&rsp, 1);
+      return;
+
+    case KFD_AP_CMD_SELF_TEST: {
+      if (len != 1) break;
+      const uint8_t res[2] = { rsp, (uint8_t)(kfdFrameSelfTest() ? 0x00 : 0x01) };
+      sendPacket(res, sizeof(res));
+      return;
+    }
+
+    // Start of a 3WI session on this line: EN is raised and the radio
+    // listens (the key signature of this interface).
+    case KFD_AP_CMD_SEND_KEY_SIG:
+      if (len != 2) break;
+      _line.discard();
+      _line.open();
+      sendPacket(&rsp, 1);
+      return;
+
+    case KFD_AP_CMD_SEND_BYTE:
+      if (len < 3) break;
+      _line.writeBytes(p + 2, len - 2);
+      _bytesToRadio += len - 2;
+      sendPacket(&rsp, 1);
+      return;
+
+    case KFD_AP_CMD_WRITE_INFO:
+    case KFD_AP_CMD_ENTER_BSL:
+    default:
+      KLOGW(KFD, "adapter: unsupported command %02X", p[0]);
+      sendError(KFD_AP_ERR_INVALID_CMD_OPCODE);
+      return;
+  }
+
+  KLOGW(KFD, "adapter: command %02X with bad length %u", p[0], (unsigned)len);
+  sendError(KFD_AP_ERR_INVALID_CMD_LENGTH);
+}
+
+void KfdToolAdapter::handleRead(uint8_t item) {
+  uint8_t rsp[2 + 8] = { (uint8_t)(KFD_AP_CMD_READ + KFD_AP_RSP_OFFSET), item };
+  size_t  len = 2;
+
+  const uint64_t mac = ESP.getEfuseMac();
+  switch (item) {
+    case KFD_AP_READ_AP_VER:
+      memcpy(rsp + len, KFD_AP_VERSION, sizeof(KFD_AP_VERSION));
+      len += sizeof(KFD_AP_VERSION);
+      break;
+    case KFD_AP_READ_FW_VER:
+      memcpy(rsp + len, KFD_AP_FW_VER, sizeof(KFD_AP_FW_VER));
+      len += sizeof(KFD_AP_FW_VER);
+      break;
+    case KFD_AP_READ_UNIQUE_ID:
+      // Length-prefixed: the 48-bit factory MAC.
+      rsp[len++] = 6;
+      for (int i = 5; i >= 0; --i) rsp[len++] = (uint8_t)(mac >> (8 * i));
+      break;
+    case KFD_AP_READ_MODEL_ID:
+      rsp[len++] = KFD_AP_MODEL_ID;
+      break;
+    case KFD_AP_READ_HW_REV:
+      memcpy(rsp + len, KFD_AP_HW_REV, sizeof(KFD_AP_HW_REV));
+      len += sizeof(KFD_AP_HW_REV);
+      break;
+    case KFD_AP_READ_SER_NUM: {
+      // Six ASCII digits from the low MAC bits.
+      uint32_t sn = (uint32_t)(mac & 0xFFFFFF) % 1000000u;
+      for (int i = 5; i >= 0; --i, sn /= 10) rsp[len + i] = (uint8_t)('0' + sn % 10);
+      len += 6;
+      break;
+    }
+    default:
+      sendError(KFD_AP_ERR_INVALID_READ_ITEM);
+      return;
+  }
+  sendPacket(rsp, len);
+}
@@ -0,0 +1,482 @@
+#include "kfd_bench.h"
+
+#include <Arduino.h>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "hex_codec.h"
+#include "kfd_dli.h"
+#include "kfd_dli_radio.h"
+#include "kfd_frame.h"
+#include "kfd_line_trace.h"
+#include "kfd_protocol.h"
+#include "kfd_scheduler.h"
+
+KeyContainer kfdBenchContainer(size_t keyCount, uint32_t seed) {
+  KeyContainer kc;
+  kc.label  = "BENCH";
+  kc.agency = "BENCH";
+  kc.band   = "700/800";
+  kc.algo   = "AES256";
+  kc.locked = false;
+
+  uint32_t x = seed ? seed : 1;
+  for (size_t i = 0; i < keyCount; ++i) {
+    KeySlot k;
+    k.label    = "BENCH " + std::to_string(i + 1);
+    k.algo     = "AES256";
+    k.selected = true;
+    uint8_t key[32];
+    for (size_t n = 0; n < sizeof(key); ++n) {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      key[n] = (uint8_t)x;
+    }
+    char hex[2 * sizeof(key) + 1];
+    hexEncode(key, sizeof(key), hex, sizeof(hex));
+    k.hex = hex;
+    kc.keys.push_back(k);
+  }
+  return kc;
+}
+
+static uint32_t percentile(const std::vector<uint32_t>& sorted, unsigned pct) {
+  if (sorted.empty()) return 0;
+  size_t idx = (sorted.size() * pct) / 100;
+  if (idx >= sorted.size()) idx = sorted.size() - 1;
+  return sorted[idx];
+}
+
+bool kfdRunBench(const KeyContainer& kc, const KfdEmulatorConfig& cfg,
+                 unsigned sessions, unsigned maxAttempts, KfdBenchResult& out) {
+  out = KfdBenchResult();
+
+  KfdRadioEmulator radio;
+  radio.configure(cfg);
+
+  KFDProtocol::clearRateCache();
+  KFDProtocol proto(KFD_NO_PINS);
+  proto.begin();
+  proto.attachEmulator(&radio);
+
+  std::vector<uint32_t> latencies;
+  latencies.reserve(sessions);
+
+  uint32_t totalUs = 0;
+  for (unsigned s = 0; s < sessions; ++s) {
+    radio.reset();
+    uint32_t start = micros();
+    bool     ok    = false;
+
+    for (unsigned attempt = 0; attempt < maxAttempts && !ok; ++attempt) {
+      if (attempt > 0) out.retries++;
+      if (!proto.beginKeyload(kc)) {
+        proto.attachEmulator(nullptr);
+        return false;  // plan rejected; retrying will not help
+      }
+      while (proto.busy()) proto.loop();
+      ok = proto.lastSessionOk();
+      out.frameRetries += proto.telemetry().retries;
+    }
+
+    uint32_t elapsed = micros() - start;
+    totalUs += elapsed;
+
+    if (!ok) {
+      out.failures++;
+      continue;
+    }
+    out.sessions++;
+    out.keysLoaded += radio.inventory().size();
+    latencies.push_back(elapsed);
+  }
+
+  proto.attachEmulator(nullptr);
+
+  std::sort(latencies.begin(), latencies.end());
+  out.p50Us      = percentile(latencies, 50);
+  out.p90Us      = percentile(latencies, 90);
+  out.p99Us      = percentile(latencies, 99);
+  out.maxUs      = latencies.empty() ? 0 : latencies.back();
+  out.keysPerSec = totalUs ? (float)out.keysLoaded * 1e6f / (float)totalUs : 0.0f;
+  return true;
+}
+
+uint32_t kfdRunParallelBench(const KeyContainer& kc, const KfdEmulatorConfig& cfg, size_t ports) {
+  if (ports == 0 || ports > KFD_MAX_PORTS) return 0;
+
+  KfdRadioEmulator radios[KFD_MAX_PORTS];
+  KFDProtocol      protos[KFD_MAX_PORTS];
+
+  for (size_t i = 0; i < ports; ++i) {
+    KfdEmulatorConfig c = cfg;
+    c.seed = cfg.seed + (uint32_t)i;
+    radios[i].configure(c);
+    protos[i].setPins(KFD_NO_PINS);
+    protos[i].begin();
+    protos[i].attachEmulator(&radios[i]);
+  }
+
+  uint32_t start = micros();
+  for (size_t i = 0; i < ports; ++i) {
+    if (!protos[i].beginKeyload(kc)) return 0;
+  }
+
+  bool busy = true;
+  while (busy) {
+    busy = false;
+    for (size_t i = 0; i < ports; ++i) {
+      if (!protos[i].busy()) continue;
+      protos[i].loop();
+      busy = true;
+    }
+  }
+  uint32_t elapsed = micros() - start;
+
+  for (size_t i = 0; i < ports; ++i) {
+    if (!protos[i].lastSessionOk() || radios[i].inventory().size() != protos[i].telemetry().keysPlanned) return 0;
+  }
+  return elapsed;
+}
+
+void kfdPrintParallelBench(const KeyContainer& kc, size_t ports, uint32_t elapsedUs) {
+  if (elapsedUs == 0) {
+    Serial.printf("[BENCH] parallel x%u: FAILED\n", (unsigned)ports);
+    return;
+  }
+  const float keys = (float)(kc.keys.size() * ports);
+  Serial.printf("[BENCH] parallel x%u: %u us, %.1f keys/s total\n",
+                (unsigned)ports, (unsigned)elapsedUs, keys * 1e6f / (float)elapsedUs);
+}
+
+void kfdPrintBench(const char* name, const KfdBenchResult& r) {
+  Serial.printf("[BENCH] %s: %u ok, %u failed, %u session retries, %u frame retries\n",
+                name, r.sessions, r.failures, r.retries, r.frameRetries);
+  Serial.printf("[BENCH] %s: %u keys, %.1f keys/s\n",
+                name, (unsigned)r.keysLoaded, r.keysPerSec);
+  Serial.printf("[BENCH] %s: session us p50=%u p90=%u p99=%u max=%u\n",
+                name, (unsigned)r.p50Us, (unsigned)r.p90Us,
+                (unsigned)r.p99Us, (unsigned)r.maxUs);
+}
+
+void kfdRunFrameBench(unsigned iterations) {
+  if (iterations == 0) return;
+
+  Serial.printf("[BENCH] frame self-test: %s\n", kfdFrameSelfTest() ? "PASS" : "FAIL");
+
+  static uint8_t block[1024];
+  for (size_t i = 0; i < sizeof(block); ++i) block[i] = (uint8_t)(i * 131 + 7);
+
+  volatile uint16_t sink = 0;
+  uint32_t t0 = micros();
+  for (unsigned i = 0; i < iterations; ++i) sink ^= kfdCrc16(block, sizeof(block));
+  uint32_t crcUs = micros() - t0;
+
+  // Typical AES-256 key payload: KMM header + 32 key bytes.
+  uint8_t payload[37];
+  for (size_t i = 0; i < sizeof(payload); ++i) payload[i] = block[i];
+  uint8_t frame[sizeof(payload) + KFD_FRAME_OVERHEAD];
+
+  t0 = micros();
+  for (unsigned i = 0; i < iterations; ++i) {
+    payload[5] = (uint8_t)i;
+    sink ^= (uint16_t)kfdFrameEncode(payload, sizeof(payload), frame, sizeof(frame));
+  }
+  uint32_t encUs = micros() - t0;
+
+  KfdFrameParser parser;
+  unsigned       ok = 0;
+  t0 = micros();
+  for (unsigned i = 0; i < iterations; ++i) {
+    parser.reset();
+    for (size_t n = 0; n < sizeof(frame); ++n) {
+      if (parser.push(frame[n]) == KfdFrameParser::FRAME_OK) ok++;
+    }
+  }
+  uint32_t parseUs = micros() - t0;
+  (void)sink;
+
+  const float mb = (float)sizeof(block) * iterations / 1e6f;
+  Serial.printf("[BENCH] crc16: %.2f MB/s\n", crcUs ? mb * 1e6f / (float)crcUs : 0.0f);
+  Serial.printf("[BENCH] encode %u-byte frame: %.3f us\n",
+                (unsigned)sizeof(frame), (float)encUs / iterations);
+  Serial.printf("[BENCH] parse  %u-byte frame: %.3f us (%u/%u ok)\n",
+                (unsigned)sizeof(frame), (float)parseUs / iterations, ok, iterations);
+}
+
+// Baselines: the conversions hex_codec replaced.
+static bool hexBaselineDecode(const char* hex, size_t n, uint8_t* out) {
+  auto cvt = [](char c) -> int {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return 10 + (c - 'A');
+    if (c >= 'a' && c <= 'f') return 10 + (c - 'a');
+    return -1;
+  };
+  for (size_t i = 0; i < n / 2; ++i) {
+    int vhi = cvt(hex[2 * i]);
+    int vlo = cvt(hex[2 * i + 1]);
+    if (vhi < 0 || vlo < 0) return false;
+    out[i] = (uint8_t)((vhi << 4) | vlo);
+  }
+  return true;
+}
+
+static void hexBaselineEncode(const uint8_t* data, size_t len, char* out) {
+  for (size_t i = 0; i < len; ++i) snprintf(out + 2 * i, 3, "%02X", data[i]);
+}
+
+void kfdRunHexBench(unsigned iterations) {
+  if (iterations == 0) return;
+
+  // One AES-256 key, as stored in a container.
+  uint8_t key[32];
+  for (size_t i = 0; i < sizeof(key); ++i) key[i] = (uint8_t)(i * 73 + 11);
+  char hex[2 * sizeof(key) + 1];
+  hexEncode(key, sizeof(key), hex, sizeof(hex));
+
+  uint8_t back[sizeof(key)];
+  size_t  n = 0;
+  bool    ok = hexDecode(hex, 2 * sizeof(key), back, sizeof(back), n) == HEX_OK &&
+               n == sizeof(key) && memcmp(back, key, sizeof(key)) == 0;
+  Serial.printf("[BENCH] hex round trip: %s\n", ok ? "PASS" : "FAIL");
+
+  volatile uint8_t sink = 0;
+  uint32_t t0 = micros();
+  for (unsigned i = 0; i < iterations; ++i) {
+    hex[0] = (i & 1) ? 'A' : 'B';
+    hexDecode(hex, 2 * sizeof(key), back, sizeof(back), n);
+    sink ^= back[0];
+  }
+  uint32_t decUs = micros() - t0;
+
+  t0 = micros();
+  for (unsigned i = 0; i < iterations; ++i) {
+    hex[0] = (i & 1) ? 'A' : 'B';
+    hexBaselineDecode(hex, 2 * sizeof(key), back);
+    sink ^= back[0];
+  }
+  uint32_t decBaseUs = micros() - t0;
+
+  t0 = micros();
+  for (unsigned i = 0; i < iterations; ++i) {
+    key[0] = (uint8_t)i;
+    hexEncode(key, sizeof(key), hex, sizeof(hex));
+    sink ^= (uint8_t)hex[1];
+  }
+  uint32_t encUs = micros() - t0;
+
+  t0 = micros();
+  for (unsigned i = 0; i < iterations; ++i) {
+    key[0] = (uint8_t)i;
+    hexBaselineEncode(key, sizeof(key), hex);
+    sink ^= (uint8_t)hex[1];
+  }
+  uint32_t encBaseUs = micros() - t0;
+  (void)sink;
+
+  Serial.printf("[BENCH] hex decode 64 digits: %.3f us (per-char %.3f us)\n",
+                (float)decUs / iterations, (float)decBaseUs / iterations);
+  Serial.printf("[BENCH] hex encode 32 bytes:  %.3f us (snprintf %.3f us)\n",
+                (float)encUs / iterations, (float)encBaseUs / iterations);
+}
+
+void kfdRunTraceBench(const KeyContainer& kc, unsigned sessions) {
+  if (sessions == 0) return;
+
+  KfdRadioEmulator radio;
+  KfdEmulatorConfig cfg;
+  cfg.responseLatencyUs = 0;
+  radio.configure(cfg);
+
+  KFDProtocol proto(KFD_NO_PINS);
+  proto.begin();
+  proto.attachEmulator(&radio);
+
+  KfdLineTrace& trace = KfdLineTrace::instance();
+  uint32_t      us[2] = { 0, 0 };
+
+  for (int pass = 0; pass < 2; ++pass) {
+    trace.clear();
+    trace.setEnabled(pass == 1);
+    proto.attachTrace(pass == 1 ? &trace : nullptr);
+
+    uint32_t t0 = micros();
+    for (unsigned s = 0; s < sessions; ++s) {
+      radio.reset();
+      if (!proto.beginKeyload(kc)) break;
+      while (proto.busy()) proto.loop();
+    }
+    us[pass] = micros() - t0;
+  }
+
+  proto.attachTrace(nullptr);
+  proto.attachEmulator(nullptr);
+  trace.setEnabled(false);
+
+  Serial.printf("[BENCH] trace: %u edges kept, %u overwritten, %u cycles/edge\n",
+                (unsigned)trace.edgeCount(), (unsigned)trace.overwritten(),
+                (unsigned)trace.cyclesPerEdge());
+  Serial.printf("[BENCH] trace: session %u us off, %u us on (%+.1f%%)\n",
+                (unsigned)(us[0] / sessions), (unsigned)(us[1] / sessions),
+                us[0] ? 100.0f * ((float)us[1] - (float)us[0]) / (float)us[0] : 0.0f);
+}
+
+// Run one session of kc to completion on proto; returns elapsed us, 0 on failure.
+static uint32_t runSession(KFDProtocol& proto, const KeyContainer& kc, KfdLoadMode mode) {
+  uint32_t t0 = micros();
+  if (!proto.beginKeyload(kc, mode)) return 0;
+  while (proto.busy()) proto.loop();
+  return proto.lastSessionOk() ? micros() - t0 : 0;
+}
+
+// Alter a key so the CRC-16 the inventory used to carry still matches:
+// flip the first byte, then search the last two for the old CRC. Only a
+// real digest tells the radio's copy apart.
+static void alterKeepingCrc16(KeySlot& k) {
+  uint8_t key[KFD_MAX_KEY_BYTES];
+  size_t  len = 0;
+  if (hexDecode(k.hex.data(), k.hex.size(), key, sizeof(key), len) != HEX_OK || len < 3) return;
+
+  const uint16_t seed = kfdCrc16Byte(KFD_CRC_INIT, KfdSessionPlan::algorithmId(k.algo));
+  const uint16_t crc  = kfdCrc16(key, len, seed);
+  key[0] ^= 0x01;
+  for (uint32_t v = 0; v <= 0xFFFF; ++v) {
+    key[len - 2] = (uint8_t)(v >> 8);
+    key[len - 1] = (uint8_t)v;
+    if (kfdCrc16(key, len, seed) == crc) break;
+  }
+
+  char hex[2 * KFD_MAX_KEY_BYTES + 1];
+  hexEncode(key, len, hex, sizeof(hex));
+  k.hex = hex;
+}
+
+void kfdRunDeltaBench(const KeyContainer& kc, const KfdEmulatorConfig& cfg, size_t changed) {
+  KfdRadioEmulator radios[2];
+  KFDProtocol      protos[2];
+  for (int i = 0; i < 2; ++i) {
+    radios[i].configure(cfg);
+    protos[i].setPins(KFD_NO_PINS);
+    protos[i].begin();
+    protos[i].attachEmulator(&radios[i]);
+    if (!runSession(protos[i], kc, KFD_LOAD_FULL)) {
+      Serial.println("[BENCH] delta: priming load failed");
+      protos[i].attachEmulator(nullptr);
+      return;
+    }
+  }
+
+  // Alter `changed` keys spread over the container; the first keeps its
+  // CRC-16.
+  KeyContainer next = kc;
+  if (changed > next.keys.size()) changed = next.keys.size();
+  for (size_t n = 0; n < changed; ++n) {
+    KeySlot& k = next.keys[n * next.keys.size() / changed];
+    if (n == 0) {
+      alterKeepingCrc16(k);
+      continue;
+    }
+    k.hex[0] = k.hex[0] == '0' ? '1' : '0';
+  }
+
+  const uint32_t fullUs  = runSession(protos[0], next, KFD_LOAD_FULL);
+  const uint32_t fullTx  = protos[0].telemetry().bytesTx;
+  const uint32_t deltaUs = runSession(protos[1], next, KFD_LOAD_DELTA);
+  const KfdSessionTelemetry& t = protos[1].telemetry();
+
+  bool same = radios[0].inventory().size() == radios[1].inventory().size();
+  for (size_t i = 0; same && i < radios[0].inventory().size(); ++i) {
+    const KfdEmulatedKey& a = radios[0].inventory()[i];
+    const KfdEmulatedKey& b = radios[1].inventory()[i];
+    same = a.keyId == b.keyId && a.length == b.length && memcmp(a.data, b.data, a.length) == 0;
+  }
+
+  for (int i = 0; i < 2; ++i) protos[i].attachEmulator(nullptr);
+
+  Serial.printf("[BENCH] delta: %u keys, %u changed, latency %u us\n",
+                (unsigned)kc.keys.size(), (unsigned)changed, (unsigned)cfg.responseLatencyUs);
+  Serial.printf("  full reload  %8u us  %5u B tx\n", (unsigned)fullUs, (unsigned)fullTx);
+  Serial.printf("  delta        %8u us  %5u B tx  (%u sent, %u current, inventory %u us)\n",
+                (unsigned)deltaUs, (unsigned)t.bytesTx, (unsigned)t.keysAcked,
+                (unsigned)t.keysSkipped, (unsigned)t.inventoryUs);
+  Serial.printf("  radios %s\n", same ? "identical" : "DIFFER");
+}
+
+void kfdRunClockBench(const KeyContainer& kc) {
+  KfdRadioEmulator  radio;
+  KfdEmulatorConfig cfg;
+  cfg.maxBitRate = 130000;
+
+  KFDProtocol::clearRateCache();
+  KFDProtocol proto(KFD_NO_PINS);
+  proto.begin();
+  proto.attachEmulator(&radio);
+
+  static const char* const NAMES[3] = { "probe", "cached", "degrading" };
+  for (int run = 0; run < 3; ++run) {
+    if (run == 2) {
+      cfg.radioId            = 0x00100002;
+      cfg.degradeAfterFrames = 40;
+      cfg.degradedMaxBitRate = 60000;
+    }
+    radio.configure(cfg);
+    radio.reset();
+
+    const uint32_t             us = runSession(proto, kc, KFD_LOAD_FULL);
+    const KfdSessionTelemetry& t  = proto.telemetry();
+    Serial.printf("[BENCH] clock %-9s %s %7u us, clock %6u bps, probe %6u us, %u step-down(s), %u retries\n",
+                  NAMES[run], us ? "ok" : "FAILED", (unsigned)us, (unsigned)t.clockBps,
+                  (unsigned)t.probeUs, (unsigned)t.rateStepDowns, (unsigned)t.retries);
+  }
+
+  proto.attachEmulator(nullptr);
+}
+
+void kfdRunDliBench(const KeyContainer& kc, uint32_t latencyUs, uint16_t dropPerMille) {
+  static KfdDliRadio radio;  // answer cache: too big for the loop task stack
+  KfdDliTransport    dli;
+  KFDProtocol        proto(KFD_NO_PINS);
+  proto.begin();
+  proto.attachTransport(&dli);
+
+  struct Run {
+    const char* name;
+    uint8_t     window;
+    uint16_t    drop;
+  };
+  const Run runs[3] = { { "window 1", 1, 0 }, { "window 8", 8, 0 }, { "window 8 lossy", 8, dropPerMille } };
+
+  Serial.printf("[BENCH] dli: %u keys over UDP loopback, turnaround %u us\n",
+                (unsigned)kc.keys.size(), (unsigned)latencyUs);
+  for (const Run& run : runs) {
+    KfdEmulatorConfig cfg;
+    cfg.responseLatencyUs = latencyUs;
+    if (!radio.begin(cfg, KFD_DLI_DEFAULT_PORT, run.drop)) {
+      Serial.println("[BENCH] dli: cannot bind the stand-in radio");
+      break;
+    }
+
+    KfdDliConfig dc;
+    dc.window = run.window;
+    dli.configure(dc);
+
+    const uint32_t t0 = micros();
+    bool ok = proto.beginKeyload(kc, KFD_LOAD_FULL);
+    while (ok && proto.busy()) {
+      proto.loop();
+      radio.service();
+    }
+    ok = ok && proto.lastSessionOk() && radio.emulator().inventory().size() == kc.keys.size();
+    const uint32_t us = micros() - t0;
+
+    Serial.printf("  %-15s %s %8u us  %6.1f keys/s  %u datagrams, %u retransmits, %u dropped\n",
+                  run.name, ok ? "ok  " : "FAIL", (unsigned)us,
+                  us ? kc.keys.size() * 1e6f / us : 0.0f, (unsigned)dli.datagramsSent(),
+                  (unsigned)dli.retransmits(), (unsigned)radio.dropped());
+    radio.end();
+  }
+  proto.attachTransport(nullptr);
+}
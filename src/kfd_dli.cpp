@@ -0,0 +1,169 @@
+#include "kfd_dli.h"
+
+#include <Arduino.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "klog.h"
+
+// -----------------------------------------------------------------------------
+// Session
+// -----------------------------------------------------------------------------
+
+void KfdDliTransport::open() {
+  close();
+
+  memset(&_peer, 0, sizeof(_peer));
+  _peer.sin_family = AF_INET;
+  _peer.sin_port   = htons(_cfg.port);
+  if (inet_pton(AF_INET, _cfg.host, &_peer.sin_addr) != 1) {
+    KLOGE(KFD, "dli: bad host address");
+    return;
+  }
+
+  _sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (_sock < 0) {
+    KLOGE(KFD, "dli: socket() failed");
+    return;
+  }
+  fcntl(_sock, F_SETFL, fcntl(_sock, F_GETFL, 0) | O_NONBLOCK);
+
+  // A connected UDP socket only delivers datagrams from the peer, so no
+  // other host can answer (acknowledge) a key frame by guessing its seq.
+  if (connect(_sock, (const sockaddr*)&_peer, sizeof(_peer)) != 0) {
+    KLOGE(KFD, "dli: connect() failed");
+    close();
+    return;
+  }
+
+  _sent        = 0;
+  _retransmits = 0;
+  _duplicates  = 0;
+  KLOGI(KFD, "dli: open, port %u, window %u", (unsigned)_cfg.port, (unsigned)window());
+}
+
+void KfdDliTransport::close() {
+  discard();
+  if (_sock < 0) return;
+  ::close(_sock);
+  _sock = -1;
+}
+
+// Forget everything in flight; answers that still arrive match nothing
+// pending and are dropped as duplicates.
+void KfdDliTransport::discard() {
+  for (size_t i = 0; i < KFD_DLI_MAX_WINDOW; ++i) _pending[i].used = false;
+  _lostCount = 0;
+}
+
+size_t KfdDliTransport::window() const {
+  if (_cfg.window == 0) return 1;
+  return _cfg.window < KFD_DLI_MAX_WINDOW ? _cfg.window : KFD_DLI_MAX_WINDOW;
+}
+
+// -----------------------------------------------------------------------------
+// Datagrams
+// -----------------------------------------------------------------------------
+
+void KfdDliTransport::transmit(const Pending& p) {
+  ::send(_sock, p.data, p.len, 0);
+  _sent++;
+}
+
+void KfdDliTransport::send(const uint8_t* frame, size_t len, uint16_t tag) {
+  if (_sock < 0 || len > KFD_DLI_MAX_DATAGRAM - KFD_DLI_HEADER) return;
+
+  Pending* p = nullptr;
+  for (size_t i = 0; i < KFD_DLI_MAX_WINDOW && !p; ++i) {
+    if (!_pending[i].used) p = &_pending[i];
+  }
+  if (!p) {
+    // More frames than the window: report it lost rather than block.
+    KLOGW(KFD, "dli: window full, frame %u dropped", (unsigned)tag);
+    if (_lostCount < KFD_DLI_MAX_WINDOW) _lost[_lostCount++] = tag;
+    return;
+  }
+
+  p->used     = true;
+  p->seq      = _nextSeq++;
+  p->tag      = tag;
+  p->tries    = 0;
+  p->data[0]  = KFD_DLI_VERSION;
+  p->data[1]  = (uint8_t)(p->seq >> 8);
+  p->data[2]  = (uint8_t)p->seq;
+  memcpy(p->data + KFD_DLI_HEADER, frame, len);
+  p->len      = KFD_DLI_HEADER + len;
+  p->sentAtUs = micros();
+  transmit(*p);
+}
+
+// Resend what has gone unanswered for rtoUs, with the same seq; past
+// maxRetransmits the frame is given up and reported lost.
+void KfdDliTransport::service() {
+  if (_sock < 0) return;
+  const uint32_t now = micros();
+
+  for (size_t i = 0; i < KFD_DLI_MAX_WINDOW; ++i) {
+    Pending& p = _pending[i];
+    if (!p.used || now - p.sentAtUs < _cfg.rtoUs) continue;
+
+    if (p.tries >= _cfg.maxRetransmits) {
+      p.used = false;
+      if (_lostCount < KFD_DLI_MAX_WINDOW) _lost[_lostCount++] = p.tag;
+      KLOGW(KFD, "dli: seq %u unanswered after %u tries", (unsigned)p.seq, (unsigned)p.tries + 1);
+      continue;
+    }
+    p.tries++;
+    p.sentAtUs = now;
+    _retransmits++;
+    transmit(p);
+  }
+}
+
+KfdTransport::RxStatus KfdDliTransport::receive(uint8_t* buf, size_t maxLen, size_t& outLen,
+                                                uint16_t& tag) {
+  outLen = 0;
+  if (_lostCount > 0) {
+    tag = _lost[0];
+    memmove(_lost, _lost + 1, (--_lostCount) * sizeof(_lost[0]));
+    return RX_LOST;
+  }
+  if (_sock < 0) return RX_NONE;
+
+  uint8_t d[KFD_DLI_MAX_DATAGRAM];
+  for (;;) {
+    const ssize_t n = recv(_sock, d, sizeof(d), 0);
+    if (n < 0) return RX_NONE;  // EWOULDBLOCK: nothing queued
+    if ((size_t)n <= KFD_DLI_HEADER || d[0] != KFD_DLI_VERSION) continue;
+
+    const uint16_t seq = (uint16_t)((d[1] << 8) | d[2]);
+    Pending*       p   = nullptr;
+    for (size_t i = 0; i < KFD_DLI_MAX_WINDOW && !p; ++i) {
+      if (_pending[i].used && _pending[i].seq == seq) p = &_pending[i];
+    }
+    if (!p) {
+      _duplicates++;
+      continue;
+    }
+    p->used = false;
+    tag     = p->tag;
+
+    KfdFrameParser parser;
+    parser.reset();
+    KfdFrameParser::Status st = KfdFrameParser::NEED_MORE;
+    for (ssize_t i = KFD_DLI_HEADER; i < n && st == KfdFrameParser::NEED_MORE; ++i) st = parser.push(d[i]);
+    if (st != KfdFrameParser::FRAME_OK) {
+      KLOGW(KFD, "dli: seq %u failed the frame check", (unsigned)seq);
+      return RX_CORRUPT;
+    }
+
+    size_t len = parser.payloadLen();
+    if (len > maxLen) len = maxLen;
+    memcpy(buf, parser.payload(), len);
+    outLen = len;
+    return RX_FRAME;
+  }
+}
@@ -0,0 +1,133 @@
+#include "kfd_dli_radio.h"
+
+#include <Arduino.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "klog.h"
+
+bool KfdDliRadio::begin(const KfdEmulatorConfig& cfg, uint16_t port, uint16_t dropPerMille) {
+  end();
+
+  // One answer owed per frame in flight.
+  KfdEmulatorConfig c  = cfg;
+  c.responseQueueDepth = KFD_EMULATOR_MAX_QUEUED;
+  _emu.configure(c);
+  _emu.reset();
+
+  _dropPerMille = dropPerMille;
+  _rng          = cfg.seed ? cfg.seed * 2654435761u : 1;
+  _havePeer     = false;
+  _owedCount    = 0;
+  _cacheNext    = 0;
+  _cacheCount   = 0;
+  _dropped      = 0;
+  _dupAnswered  = 0;
+
+  _sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (_sock < 0) return false;
+
+  sockaddr_in local;
+  memset(&local, 0, sizeof(local));
+  local.sin_family      = AF_INET;
+  local.sin_port        = htons(port);
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(_sock, (const sockaddr*)&local, sizeof(local)) != 0) {
+    KLOGE(KFD, "dli radio: bind to port %u failed", (unsigned)port);
+    end();
+    return false;
+  }
+  fcntl(_sock, F_SETFL, fcntl(_sock, F_GETFL, 0) | O_NONBLOCK);
+  return true;
+}
+
+void KfdDliRadio::end() {
+  if (_sock < 0) return;
+  ::close(_sock);
+  _sock = -1;
+}
+
+// xorshift32, as in the emulator.
+bool KfdDliRadio::drop() {
+  if (!_dropPerMille) return false;
+  uint32_t x = _rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  _rng = x;
+  if (x % 1000u >= _dropPerMille) return false;
+  _dropped++;
+  return true;
+}
+
+const KfdDliRadio::Answer* KfdDliRadio::cached(uint16_t seq) const {
+  for (size_t i = 0; i < _cacheCount; ++i) {
+    if (_cache[i].seq == seq) return &_cache[i];
+  }
+  return nullptr;
+}
+
+void KfdDliRadio::reply(const uint8_t* d, size_t len) {
+  if (!_havePeer || drop()) return;
+  sendto(_sock, d, len, 0, (const sockaddr*)&_peer, sizeof(_peer));
+}
+
+void KfdDliRadio::service() {
+  if (_sock < 0) return;
+
+  uint8_t d[KFD_DLI_MAX_DATAGRAM];
+  for (;;) {
+    sockaddr_in from;
+    socklen_t   fromLen = sizeof(from);
+    const ssize_t n = recvfrom(_sock, d, sizeof(d), 0, (sockaddr*)&from, &fromLen);
+    if (n < 0) break;
+    if ((size_t)n <= KFD_DLI_HEADER || d[0] != KFD_DLI_VERSION || drop()) continue;
+
+    _peer     = from;
+    _havePeer = true;
+
+    const uint16_t seq = (uint16_t)((d[1] << 8) | d[2]);
+    if (const Answer* a = cached(seq)) {
+      _dupAnswered++;
+      reply(a->data, a->len);
+      continue;
+    }
+    bool owed = false;
+    for (size_t i = 0; i < _owedCount && !owed; ++i) owed = _owed[i] == seq;
+    if (owed) continue;  // answer on its way
+
+    // The emulator answers at most once per frame, and not at all to a
+    // frame that fails its CRC (the KFD then retransmits).
+    const uint32_t before = _emu.responsesQueued();
+    _emu.onFrame(d + KFD_DLI_HEADER, (size_t)n - KFD_DLI_HEADER, micros());
+    if (_emu.responsesQueued() != before) {
+      if (_owedCount == KFD_EMULATOR_MAX_QUEUED) {
+        memmove(_owed, _owed + 1, --_owedCount * sizeof(_owed[0]));  // emulator dropped its oldest too
+      }
+      _owed[_owedCount++] = seq;
+    }
+  }
+
+  size_t len = 0;
+  while (_owedCount > 0 &&
+         _emu.takeResponse(d + KFD_DLI_HEADER, sizeof(d) - KFD_DLI_HEADER, len, micros())) {
+    const uint16_t seq = _owed[0];
+    memmove(_owed, _owed + 1, --_owedCount * sizeof(_owed[0]));
+
+    d[0] = KFD_DLI_VERSION;
+    d[1] = (uint8_t)(seq >> 8);
+    d[2] = (uint8_t)seq;
+
+    Answer& a = _cache[_cacheNext];
+    a.seq = seq;
+    a.len = KFD_DLI_HEADER + len;
+    memcpy(a.data, d, a.len);
+    _cacheNext = (_cacheNext + 1) % CACHE_SIZE;
+    if (_cacheCount < CACHE_SIZE) _cacheCount++;
+
+    reply(a.data, a.len);
+  }
+}
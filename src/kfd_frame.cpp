@@ -0,0 +1,158 @@
+#include "kfd_frame.h"
+
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+// Compile-time CRC table (C++11 constexpr, so no loops)
+// -----------------------------------------------------------------------------
+
+static constexpr uint16_t CRC_POLY = 0x1021;
+
+static constexpr uint16_t crcShift(uint16_t c) {
+  return (c & 0x8000) ? (uint16_t)((c << 1) ^ CRC_POLY) : (uint16_t)(c << 1);
+}
+
+static constexpr uint16_t crcEntry(uint16_t c, int bits) {
+  return bits == 0 ? c : crcEntry(crcShift(c), bits - 1);
+}
+
+template <size_t... I> struct CrcIndex {};
+template <size_t N, size_t... I> struct MakeCrcIndex : MakeCrcIndex<N - 1, N - 1, I...> {};
+template <size_t... I> struct MakeCrcIndex<0, I...> { typedef CrcIndex<I...> type; };
+
+struct CrcTable {
+  uint16_t v[256];
+};
+
+template <size_t... I>
+static constexpr CrcTable makeCrcTable(CrcIndex<I...>) {
+  return CrcTable{ { crcEntry((uint16_t)(I << 8), 8)... } };
+}
+
+static constexpr CrcTable CRC_TABLE = makeCrcTable(MakeCrcIndex<256>::type());
+
+static_assert(CRC_TABLE.v[1] == 0x1021, "CRC table generation broken");
+static_assert(CRC_TABLE.v[255] == 0x1EF0, "CRC table generation broken");
+
+// -----------------------------------------------------------------------------
+// CRC
+// -----------------------------------------------------------------------------
+
+uint16_t kfdCrc16Byte(uint16_t crc, uint8_t b) {
+  return (uint16_t)((crc << 8) ^ CRC_TABLE.v[(uint8_t)((crc >> 8) ^ b)]);
+}
+
+uint16_t kfdCrc16(const uint8_t* data, size_t len, uint16_t crc) {
+  for (size_t i = 0; i < len; ++i) {
+    crc = (uint16_t)((crc << 8) ^ CRC_TABLE.v[(uint8_t)((crc >> 8) ^ data[i])]);
+  }
+  return crc;
+}
+
+// -----------------------------------------------------------------------------
+// Encode
+// -----------------------------------------------------------------------------
+
+size_t kfdFrameEncode(const uint8_t* payload, size_t len, uint8_t* out, size_t outMax) {
+  if (len > KFD_FRAME_MAX_PAYLOAD) return 0;
+  if (outMax < len + KFD_FRAME_OVERHEAD) return 0;
+
+  out[0] = KFD_FRAME_SOF;
+  out[1] = (uint8_t)(len >> 8);
+  out[2] = (uint8_t)(len & 0xFF);
+  memcpy(out + 3, payload, len);
+
+  uint16_t crc = kfdCrc16(out + 1, len + 2);
+  out[3 + len] = (uint8_t)(crc >> 8);
+  out[4 + len] = (uint8_t)(crc & 0xFF);
+  return len + KFD_FRAME_OVERHEAD;
+}
+
+// -----------------------------------------------------------------------------
+// Streaming parser
+// -----------------------------------------------------------------------------
+
+void KfdFrameParser::reset() {
+  _stage = WAIT_SOF;
+  _len   = 0;
+  _pos   = 0;
+  _crc   = KFD_CRC_INIT;
+  _rxCrc = 0;
+}
+
+KfdFrameParser::Status KfdFrameParser::push(uint8_t b) {
+  switch (_stage) {
+    case WAIT_SOF:
+      if (b == KFD_FRAME_SOF) {
+        _crc   = KFD_CRC_INIT;
+        _stage = LEN_HI;
+      }
+      return NEED_MORE;
+
+    case LEN_HI:
+      _len   = (uint16_t)(b << 8);
+      _crc   = kfdCrc16Byte(_crc, b);
+      _stage = LEN_LO;
+      return NEED_MORE;
+
+    case LEN_LO:
+      _len |= b;
+      _crc  = kfdCrc16Byte(_crc, b);
+      if (_len > KFD_FRAME_MAX_PAYLOAD) {
+        reset();
+        return LENGTH_ERROR;
+      }
+      _pos   = 0;
+      _stage = (_len == 0) ? CRC_HI : PAYLOAD;
+      return NEED_MORE;
+
+    case PAYLOAD:
+      _payload[_pos++] = b;
+      _crc = kfdCrc16Byte(_crc, b);
+      if (_pos == _len) _stage = CRC_HI;
+      return NEED_MORE;
+
+    case CRC_HI:
+      _rxCrc = (uint16_t)(b << 8);
+      _stage = CRC_LO;
+      return NEED_MORE;
+
+    case CRC_LO: {
+      _rxCrc |= b;
+      bool ok = (_rxCrc == _crc);
+      _stage = WAIT_SOF;
+      return ok ? FRAME_OK : CRC_ERROR;
+    }
+  }
+  return NEED_MORE;
+}
+
+// -----------------------------------------------------------------------------
+// Self-test
+// -----------------------------------------------------------------------------
+
+bool kfdFrameSelfTest() {
+  // CRC-16/CCITT-FALSE check value.
+  static const uint8_t CHECK[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+  if (kfdCrc16(CHECK, sizeof(CHECK)) != 0x29B1) return false;
+
+  uint8_t payload[KFD_FRAME_MAX_PAYLOAD];
+  for (size_t i = 0; i < sizeof(payload); ++i) payload[i] = (uint8_t)(i * 37 + 11);
+
+  uint8_t frame[KFD_FRAME_MAX_PAYLOAD + KFD_FRAME_OVERHEAD];
+  size_t  n = kfdFrameEncode(payload, sizeof(payload), frame, sizeof(frame));
+  if (n != sizeof(frame)) return false;
+
+  KfdFrameParser p;
+  p.reset();
+  KfdFrameParser::Status st = KfdFrameParser::NEED_MORE;
+  for (size_t i = 0; i < n; ++i) st = p.push(frame[i]);
+  if (st != KfdFrameParser::FRAME_OK) return false;
+  if (p.payloadLen() != sizeof(payload) || memcmp(p.payload(), payload, sizeof(payload)) != 0) return false;
+
+  // A single flipped payload bit must be caught.
+  frame[10] ^= 0x04;
+  p.reset();
+  for (size_t i = 0; i < n; ++i) st = p.push(frame[i]);
+  return st == KfdFrameParser::CRC_ERROR;
+}
@@ -0,0 +1,113 @@
+#include "kfd_line_trace.h"
+
+#include <Arduino.h>
+
+#if KFD_USE_SD
+#include <SD.h>
+#include <SPI.h>
+
+// microSD slot on the WT32-SC01-PLUS – adjust to your hardware.
+static constexpr int PIN_SD_SCK  = 39;
+static constexpr int PIN_SD_MISO = 38;
+static constexpr int PIN_SD_MOSI = 40;
+static constexpr int PIN_SD_CS   = 41;
+#endif
+
+static_assert((KFD_TRACE_EDGES & (KFD_TRACE_EDGES - 1)) == 0,
+              "KFD_TRACE_EDGES must be a power of two");
+
+static constexpr uint32_t TRACE_MASK = KFD_TRACE_EDGES - 1;
+
+// VCD identifiers for DATA, CLK, EN.
+static const char LINE_IDS[KFD_LINE_COUNT]      = { '!', '"', '#' };
+static const char* const LINE_NAMES[KFD_LINE_COUNT] = { "DATA", "CLK", "EN" };
+
+KfdLineTrace& KfdLineTrace::instance() {
+  static KfdLineTrace inst;
+  return inst;
+}
+
+void KfdLineTrace::clear() {
+  _levels         = 0;
+  _count          = 0;
+  _overheadCycles = 0;
+}
+
+void KfdLineTrace::record(KfdLine line, bool level) {
+  if (!_enabled.load(std::memory_order_relaxed)) return;
+
+  const uint32_t t0   = ESP.getCycleCount();
+  const uint8_t  bit  = (uint8_t)(1u << line);
+  const uint8_t  next = level ? (uint8_t)(_levels | bit) : (uint8_t)(_levels & ~bit);
+  if (next == _levels) return;
+
+  const uint32_t slot = _count & TRACE_MASK;
+  _cycles[slot] = t0;
+  _state[slot]  = next;
+  _levels       = next;
+  _count++;
+
+  _overheadCycles += ESP.getCycleCount() - t0;
+}
+
+void KfdLineTrace::writeVcd(Print& out) const {
+  const uint32_t n     = (uint32_t)edgeCount();
+  const uint32_t first = _count - n;
+  const uint32_t mhz   = getCpuFrequencyMhz() ? getCpuFrequencyMhz() : 240;
+
+  out.printf("$comment KFD 3WI line trace, %u edges, %u overwritten, %u cycles/edge $end\n",
+             (unsigned)n, (unsigned)overwritten(), (unsigned)cyclesPerEdge());
+  out.print("$timescale 1ns $end\n$scope module kfd $end\n");
+  for (int l = 0; l < KFD_LINE_COUNT; ++l) {
+    out.printf("$var wire 1 %c %s $end\n", LINE_IDS[l], LINE_NAMES[l]);
+  }
+  out.print("$upscope $end\n$enddefinitions $end\n");
+  if (n == 0) return;
+
+  // Without overwrite the capture starts from all-low; otherwise the
+  // oldest kept state is the best known starting point.
+  uint8_t prev = overwritten() ? _state[first & TRACE_MASK] : 0;
+  out.print("#0\n");
+  for (int l = 0; l < KFD_LINE_COUNT; ++l) {
+    out.printf("%c%c\n", (prev >> l) & 1 ? '1' : '0', LINE_IDS[l]);
+  }
+
+  // Cycle stamps are 32-bit; deltas stay valid across a counter wrap as
+  // long as consecutive edges are less than one wrap (~17 s) apart.
+  uint64_t ns   = 0;
+  uint32_t last = _cycles[first & TRACE_MASK];
+  for (uint32_t i = first; i != _count; ++i) {
+    const uint32_t slot = i & TRACE_MASK;
+    ns  += (uint64_t)(_cycles[slot] - last) * 1000u / mhz;
+    last = _cycles[slot];
+
+    const uint8_t s       = _state[slot];
+    const uint8_t changed = (uint8_t)(s ^ prev);
+    if (!changed) continue;
+    out.printf("#%llu\n", (unsigned long long)ns);
+    for (int l = 0; l < KFD_LINE_COUNT; ++l) {
+      if ((changed >> l) & 1) out.printf("%c%c\n", (s >> l) & 1 ? '1' : '0', LINE_IDS[l]);
+    }
+    prev = s;
+  }
+}
+
+bool KfdLineTrace::saveVcd(const char* path) const {
+#if KFD_USE_SD
+  static bool mounted = false;
+  if (!mounted) {
+    SPI.begin(PIN_SD_SCK, PIN_SD_MISO, PIN_SD_MOSI, PIN_SD_CS);
+    mounted = SD.begin(PIN_SD_CS);
+    if (!mounted) return false;
+  }
+
+  File f = SD.open(path, FILE_WRITE);
+  if (!f) return false;
+  writeVcd(f);
+  f.close();
+  return true;
+#else
+  (void)path;
+  return false;
+#endif
+}
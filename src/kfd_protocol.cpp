@@ -1,134 +1,663 @@
 #include <Arduino.h>
 #include "kfd_protocol.h"
+#include "klog.h"
+
+#include <algorithm>
 
 // -----------------------------------------------------------------------------
-// Pin assignments for the 3-wire interface – adjust to your hardware.
+// Setup and stepping
 // -----------------------------------------------------------------------------
-static constexpr int PIN_TWI_DATA = 21;
-static constexpr int PIN_TWI_CLK  = 22;
-static constexpr int PIN_TWI_EN   = 23;
+
+// Upper bound on state machine steps per loop() call, so one port streaming
+// against the receive stub cannot starve the others or the UI.
+static constexpr int KFD_LOOP_STEP_LIMIT = 64;
 
 // -----------------------------------------------------------------------------
-// Low-level helpers (currently stubs / debug only)
+// Negotiated clock rate per radio ID, shared by all ports. Only touched from
+// the thread that runs the ports (the protocol task, or a benchmark).
 // -----------------------------------------------------------------------------
 
-bool KFDProtocol::begin() {
-  // Configure GPIO as outputs; you can tune this to your real wiring.
-  pinMode(PIN_TWI_DATA, OUTPUT);
-  pinMode(PIN_TWI_CLK,  OUTPUT);
-  pinMode(PIN_TWI_EN,   OUTPUT);
+static constexpr size_t KFD_RATE_CACHE_SIZE = 16;
 
-  digitalWrite(PIN_TWI_DATA, LOW);
-  digitalWrite(PIN_TWI_CLK,  LOW);
-  digitalWrite(PIN_TWI_EN,   LOW);
+struct KfdRateCacheEntry {
+  uint32_t radioId;   // 0 = free
+  uint8_t  rateIdx;
+  uint32_t lastUsed;
+};
 
-  _state           = IDLE;
-  _currentKeyIndex = 0;
+static KfdRateCacheEntry s_rateCache[KFD_RATE_CACHE_SIZE];
+static uint32_t          s_rateCacheClock = 0;
 
-  Serial.println("[KFD] begin(): interface initialised (stub)");
-  return true;
+static int rateCacheLookup(uint32_t radioId) {
+  for (auto& e : s_rateCache) {
+    if (e.radioId != radioId) continue;
+    e.lastUsed = ++s_rateCacheClock;
+    return e.rateIdx;
+  }
+  return -1;
 }
 
-void KFDProtocol::loop() {
-  stateMachine();
+// Update in place, else take a free or the least recently used slot.
+static void rateCacheStore(uint32_t radioId, size_t rateIdx) {
+  KfdRateCacheEntry* slot = &s_rateCache[0];
+  for (auto& e : s_rateCache) {
+    if (e.radioId == radioId) {
+      slot = &e;
+      break;
+    }
+    if (e.radioId == 0 && slot->radioId != 0) slot = &e;
+    else if (slot->radioId != 0 && e.lastUsed < slot->lastUsed) slot = &e;
+  }
+  slot->radioId  = radioId;
+  slot->rateIdx  = (uint8_t)rateIdx;
+  slot->lastUsed = ++s_rateCacheClock;
 }
 
-void KFDProtocol::twiSetData(bool level)   { digitalWrite(PIN_TWI_DATA, level ? HIGH : LOW); }
-void KFDProtocol::twiSetClock(bool level)  { digitalWrite(PIN_TWI_CLK,  level ? HIGH : LOW); }
-void KFDProtocol::twiSetEnable(bool level) { digitalWrite(PIN_TWI_EN,   level ? HIGH : LOW); }
-bool KFDProtocol::twiGetData()             { return digitalRead(PIN_TWI_DATA) != 0; }
-
-// For now these are just stubs. When you’re ready to implement real
-// protocol timing, expand these.
-void KFDProtocol::sendBit(bool bit) {
-  (void)bit;
-  // TODO: implement real timing; for now just a debug placeholder.
-  // twiSetData(bit);
-  // delayMicroseconds(5);
-  // twiSetClock(true);
-  // delayMicroseconds(5);
-  // twiSetClock(false);
+void KFDProtocol::clearRateCache() {
+  memset(s_rateCache, 0, sizeof(s_rateCache));
+  s_rateCacheClock = 0;
 }
 
-void KFDProtocol::sendByte(uint8_t value) {
-  for (int i = 7; i >= 0; --i) {
-    bool b = (value >> i) & 0x01;
-    sendBit(b);
+bool KFDProtocol::begin() {
+  _line.begin();
+
+  _state        = IDLE;
+  _currentFrame = 0;
+  _crcErrors    = 0;
+
+  if (!kfdFrameSelfTest()) {
+    Serial.println("[KFD] begin(): frame CRC self-test FAILED");
+    return false;
   }
+
+  Serial.printf("[KFD] begin(): interface initialised (stub, EN pin %d)\n", _line.pins().en);
+  return true;
 }
 
-void KFDProtocol::sendFrame(const uint8_t* data, size_t len) {
-  // Stub: in real implementation you would frame bytes with start/stop
-  // conditions and any header the radio expects. For now we just log.
-  Serial.print("[KFD] sendFrame: ");
-  for (size_t i = 0; i < len; ++i) {
-    Serial.printf("%02X", data[i]);
-  }
-  Serial.println();
+bool KFDProtocol::attachTransport(KfdTransport* transport) {
+  if (_state != IDLE) return false;
+  _transport = transport ? transport : &_line;
+  return true;
 }
 
-bool KFDProtocol::recvFrame(uint8_t* buf, size_t maxLen, size_t& outLen) {
-  (void)buf;
-  (void)maxLen;
-  outLen = 0;
-  // Stub: no real receive yet.
-  return false;
+void KFDProtocol::loop() {
+  for (int i = 0; i < KFD_LOOP_STEP_LIMIT && _state != IDLE; ++i) {
+    if (abortIfRequested()) break;
+    _transport->service();
+
+    const State  before = _state;
+    const size_t frame  = _currentFrame;
+    _pipeMoved = false;
+    stateMachine();
+    // No transition: waiting on the radio or on a backoff timer.
+    if (_state == before && _currentFrame == frame && !_pipeMoved) break;
+  }
 }
 
 // -----------------------------------------------------------------------------
 // High-level API
 // -----------------------------------------------------------------------------
 
-bool KFDProtocol::beginKeyload(const KeyContainer& kc) {
+bool KFDProtocol::beginKeyload(const KeyContainer& kc, KfdLoadMode mode) {
   if (!kc.isValid()) {
-    Serial.println("[KFD] beginKeyload(): container not valid (no keys)");
+    KLOGW(KFD, "beginKeyload(): container not valid (no keys)");
     return false;
   }
 
   if (_state != IDLE) {
-    Serial.println("[KFD] beginKeyload(): already busy");
+    KLOGW(KFD, "beginKeyload(): already busy");
+    return false;
+  }
+
+  // Compile the whole session before touching the radio so that bad hex or
+  // wrong key lengths are reported while the line is still idle.
+  _lastPlanResult = _plan.compile(kc, mode);
+  if (_lastPlanResult != KfdSessionPlan::OK) {
+    KLOGW(KFD, "beginKeyload(): plan rejected: result %d (key %d)",
+          (int)_lastPlanResult, _plan.errorKeyIndex());
     return false;
   }
 
   _activeContainer   = kc;     // copy UI-level container
-  _currentKeyIndex   = 0;
+  _currentFrame      = 0;
+  _lastSessionOk     = false;
+  _attempt           = 0;
+  _lastFailure       = FAIL_NONE;
+  _lastNakStatus     = KFD_STATUS_PERFORMED;
+  _lastFailedKey     = -1;
+  _inFlight          = 0;
   _state             = SESSION_START;
 
-  Serial.printf("[KFD] beginKeyload(): %u keys queued (label='%s')\n",
-                (unsigned)_activeContainer.keys.size(),
-                _activeContainer.label.c_str());
+  _committedKeys.clear();
+  _committedKeys.reserve(_plan.keyCount());
+  _unverifiedKeys.clear();
+  _inDoubtKeys.clear();
+  _abortRequested.store(false, std::memory_order_relaxed);
+
+  _telemetry.reset(++_sessionCounter, (uint32_t)_plan.keyCount(), micros());
+
+  // The radio is unknown until it answers READY_REQ at the safe rate.
+  _radioId    = 0;
+  _errHistory = 0;
+  setRate(0);
+
+  KLOGI(KFD, "beginKeyload(): %u of %u keys planned, %u frames, %u bytes",
+        (unsigned)_plan.keyCount(),
+        (unsigned)_activeContainer.keys.size(),
+        (unsigned)_plan.frameCount(),
+        (unsigned)_plan.totalBytes());
   return true;
 }
 
-// Convert hex string to bytes (utility for the stub).
-static bool hexToBytes(const std::string& hex, uint8_t* out, size_t& outLen, size_t maxLen) {
-  outLen = 0;
-  size_t n = hex.size();
-  if (n == 0) return false;
-  if (n % 2 != 0) return false;
+// NAK status names (P25 OTAR status field).
+const char* KFDProtocol::nakStatusName(uint8_t status) {
+  switch (status) {
+    case KFD_STATUS_PERFORMED:      return "PERFORMED";
+    case KFD_STATUS_NOT_PERFORMED:  return "NOT PERFORMED";
+    case KFD_STATUS_NO_ITEM:        return "ITEM DOES NOT EXIST";
+    case KFD_STATUS_INVALID_MSG_ID: return "INVALID MESSAGE ID";
+    case KFD_STATUS_INVALID_MAC:    return "INVALID MAC";
+    case KFD_STATUS_OUT_OF_MEMORY:  return "OUT OF MEMORY";
+    case KFD_STATUS_DECRYPT_FAILED: return "COULD NOT DECRYPT";
+    case KFD_STATUS_INVALID_MSG_NO: return "INVALID MESSAGE NUMBER";
+    case KFD_STATUS_INVALID_KEY_ID: return "INVALID KEY ID";
+    case KFD_STATUS_INVALID_ALG_ID: return "INVALID ALGORITHM ID";
+    case KFD_STATUS_INVALID_MFID:   return "INVALID MFID";
+    case KFD_STATUS_MODULE_FAILURE: return "MODULE FAILURE";
+    case KFD_STATUS_MI_ALL_ZEROS:   return "MI ALL ZEROS";
+    case KFD_STATUS_KEYFAIL:        return "KEYFAIL";
+    default:                        return "UNKNOWN STATUS";
+  }
+}
+
+const char* KFDProtocol::failureText() const {
+  switch (_lastFailure) {
+    case FAIL_NONE:         return "NONE";
+    case FAIL_TIMEOUT:      return "NO RESPONSE";
+    case FAIL_INTEGRITY:    return "LINE ERRORS";
+    case FAIL_BAD_RESPONSE: return "UNEXPECTED RESPONSE";
+    case FAIL_NAK:          return nakStatusName(_lastNakStatus);
+    case FAIL_ABORTED:      return "ABORTED";
+  }
+  return "UNKNOWN";
+}
+
+// Only transient NAKs are worth a retransmit; a bad key ID or algorithm
+// will be rejected again no matter how often it is sent.
+static bool nakIsTransient(uint8_t status) {
+  switch (status) {
+    case KFD_STATUS_NOT_PERFORMED:
+    case KFD_STATUS_OUT_OF_MEMORY:
+    case KFD_STATUS_INVALID_MAC:
+    case KFD_STATUS_DECRYPT_FAILED:
+    case KFD_STATUS_INVALID_MSG_NO:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Clock one precompiled frame out and start waiting for its answer. The
+// phase that sent it is remembered so a retransmit re-enters the same place.
+void KFDProtocol::sendCurrentFrame() {
+  const KfdPlanFrame& f = _plan.frame(_currentFrame);
+
+  // Stale bytes from a timed-out attempt must not answer this one.
+  _transport->discard();
+
+  uint32_t t0 = micros();
+  _transport->send(_plan.frameData(_currentFrame), f.length, (uint16_t)_currentFrame);
+  _sentAtUs    = micros();
+  _sendUs      = _sentAtUs - t0;
+  _resumeState = _state;
+  _state       = AWAIT_ACK;
+}
+
+// Check for the radio's answer to _currentFrame against the plan. While
+// the transport's receive path is a stub, silence is tolerated; otherwise
+// the radio must answer within frameTimeoutUs, or the transport itself
+// reports the frame lost.
+KFDProtocol::FrameResult KFDProtocol::pollAck() {
+  const KfdPlanFrame& f = _plan.frame(_currentFrame);
+
+  uint8_t  rsp[KFD_FRAME_MAX_PAYLOAD];
+  size_t   rspLen = 0;
+  uint16_t tag    = 0;
+  const KfdTransport::RxStatus st = _transport->receive(rsp, sizeof(rsp), rspLen, tag);
+  const uint32_t waited = micros() - _sentAtUs;
+
+  // A late answer to an earlier frame is stale.
+  if (st != KfdTransport::RX_NONE && tag != (uint16_t)_currentFrame) return FRAME_PENDING;
+
+  switch (st) {
+    case KfdTransport::RX_CORRUPT:
+      _crcErrors++;
+      _telemetry.crcErrors++;
+      _telemetry.recordFrame(f.length, 0);
+      return FRAME_INTEGRITY;
+
+    case KfdTransport::RX_LOST:
+      _telemetry.recordFrame(f.length, 0);
+      _telemetry.timeouts++;
+      return FRAME_TIMEOUT;
+
+    case KfdTransport::RX_NONE:
+      if (!_transport->hasReceiver()) {
+        // Nothing can answer: move on, but the key stays unverified.
+        _telemetry.recordFrame(f.length, 0);
+        if (f.keyIndex >= 0) _telemetry.recordUnverifiedKey(_sendUs);
+        return FRAME_ACKED;
+      }
+      if (_transport->reliable() || waited < _delivery.frameTimeoutUs) return FRAME_PENDING;
+      _telemetry.recordFrame(f.length, 0);
+      _telemetry.timeouts++;
+      return FRAME_TIMEOUT;
+
+    case KfdTransport::RX_FRAME:
+      break;
+  }
+
+  _telemetry.recordFrame(f.length, rspLen + KFD_FRAME_OVERHEAD);
+  const FrameResult r = checkAnswer(_currentFrame, rsp, rspLen);
+  if (r == FRAME_ACKED && f.keyIndex >= 0) _telemetry.recordKey(_sendUs, waited);
+  return r;
+}
+
+// Judge a received answer to frame idx against the plan.
+KFDProtocol::FrameResult KFDProtocol::checkAnswer(size_t idx, const uint8_t* rsp, size_t rspLen) {
+  const KfdPlanFrame& f = _plan.frame(idx);
 
-  size_t bytes = n / 2;
-  if (bytes > maxLen) bytes = maxLen;
+  if (rspLen == 0 || rsp[0] != f.expectedResponse) {
+    KLOGW(KFD, "frame %u: expected %02X, got %02X",
+          (unsigned)idx, f.expectedResponse, rspLen ? rsp[0] : 0);
+    return FRAME_BAD_RESPONSE;
+  }
 
-  for (size_t i = 0; i < bytes; ++i) {
-    char hi = hex[2 * i];
-    char lo = hex[2 * i + 1];
+  // READY_GENERAL_MODE may carry the radio's 32-bit ID.
+  if (idx == 0) {
+    _radioId = rspLen >= 5 ? ((uint32_t)rsp[1] << 24) | ((uint32_t)rsp[2] << 16) |
+                             ((uint32_t)rsp[3] << 8) | rsp[4]
+                           : 0;
+  }
 
-    auto cvt = [](char c) -> int {
-      if (c >= '0' && c <= '9') return c - '0';
-      if (c >= 'A' && c <= 'F') return 10 + (c - 'A');
-      if (c >= 'a' && c <= 'f') return 10 + (c - 'a');
-      return -1;
-    };
+  if (f.inventory) return handleInventory(rsp, rspLen);
 
-    int vhi = cvt(hi);
-    int vlo = cvt(lo);
-    if (vhi < 0 || vlo < 0) return false;
+  if (f.keyIndex >= 0 && rspLen >= 3 && rsp[1] == KFD_KMM_NAK) {
+    _lastNakStatus = rsp[2];
+    _telemetry.naks++;
+    KLOGW(KFD, "key %d NAKed: status %02X", f.keyIndex, rsp[2]);
+    return FRAME_NAK;
+  }
+  return FRAME_ACKED;
+}
+
+// One page of the radio's key inventory. Keys it already holds unchanged
+// are marked in the plan; a radio without inventory support answers with
+// a NAK and simply gets every key.
+KFDProtocol::FrameResult KFDProtocol::handleInventory(const uint8_t* rsp, size_t len) {
+  if (len < 4 || rsp[1] != KFD_KMM_INVENTORY_RSP) {
+    KLOGW(KFD, "inventory not supported (%02X), sending all keys", len > 1 ? rsp[1] : 0);
+    return FRAME_ACKED;
+  }
 
-    out[i] = (uint8_t)((vhi << 4) | vlo);
+  const size_t count = rsp[3];
+  if (count > KFD_INVENTORY_MAX_ENTRIES || len < 4 + count * KFD_INVENTORY_ENTRY_BYTES) {
+    KLOGW(KFD, "inventory page malformed: %u entries in %u bytes", (unsigned)count, (unsigned)len);
+    return FRAME_BAD_RESPONSE;
   }
 
-  outLen = bytes;
+  _plan.applyInventory(rsp + 4, count);
+
+  if ((rsp[2] & KFD_INVENTORY_MORE) && count > 0) {
+    const uint8_t* last   = rsp + 4 + (count - 1) * KFD_INVENTORY_ENTRY_BYTES;
+    const uint16_t lastId = (uint16_t)((last[0] << 8) | last[1]);
+    if (lastId != 0xFFFF) {
+      _plan.setInventoryStart((uint16_t)(lastId + 1));
+      return FRAME_MORE;
+    }
+  }
+  return FRAME_ACKED;
+}
+
+// Phase that sends frame idx: READY_REQ and the inventory pages, the key
+// frames, then the closing control frames.
+KFDProtocol::State KFDProtocol::phaseFor(size_t idx) const {
+  if (idx == 0 || (idx < _plan.frameCount() && _plan.frame(idx).inventory)) return SESSION_START;
+  if (idx < _plan.frameCount() && _plan.frame(idx).keyIndex >= 0) return SENDING_KEYS;
+  return SESSION_END;
+}
+
+void KFDProtocol::setRate(size_t idx) {
+  _rateIdx = idx;
+  _line.setClockRate(idx);
+  _telemetry.clockBps = clockRateBps();
+}
+
+// After READY: take the radio's cached rate, or return true to probe it.
+// A line that cannot hear the radio cannot probe it either: every rate
+// would pass, so it stays at the default.
+bool KFDProtocol::startClock() {
+  if (!_line.hasReceiver()) {
+    setRate(KFD_CLOCK_DEFAULT);
+    return false;
+  }
+  const int cached = _radioId ? rateCacheLookup(_radioId) : -1;
+  if (cached >= 0) {
+    setRate((size_t)cached);
+    KLOGI(KFD, "clock: radio %08X cached at %u bps", _radioId, clockRateBps());
+    return false;
+  }
+  if (!_delivery.negotiateRate || _delivery.probeExchanges == 0) {
+    setRate(KFD_CLOCK_DEFAULT);
+    return false;
+  }
+  _probeIdx    = 1;
+  _probeBest   = 0;
+  _probePasses = 0;
+  _probeAtUs   = micros();
+  return true;
+}
+
+// One probe exchange done. A rate passes after probeExchanges clean
+// exchanges and the next one is tried; the first failure ends the probe
+// one rate below the fastest pass, i.e. two below the failing rate, for
+// margin. Passing the whole table keeps the top rate.
+void KFDProtocol::probeResult(bool ok) {
+  if (ok && ++_probePasses < _delivery.probeExchanges) {
+    _state = PROBE;
+    return;
+  }
+
+  if (ok) {
+    _probeBest = _probeIdx;
+    if (_probeIdx + 1 < KFD_CLOCK_RATE_COUNT) {
+      _probeIdx++;
+      _probePasses = 0;
+      _state       = PROBE;
+      return;
+    }
+  }
+
+  const size_t chosen = (!ok && _probeBest > 0) ? _probeBest - 1 : _probeBest;
+  setRate(chosen);
+  if (_radioId) rateCacheStore(_radioId, chosen);
+
+  _telemetry.probeUs = micros() - _probeAtUs;
+  KLOGI(KFD, "clock: radio %08X negotiated %u bps in %u us",
+        _radioId, clockRateBps(), (unsigned)_telemetry.probeUs);
+
+  _line.discard();
+  _state = _afterProbe;
+}
+
+// Feed one frame outcome into the error history; too many line errors
+// step the clock down and correct the cache.
+void KFDProtocol::noteLineResult(bool error) {
+  if (!usingLine()) return;
+  _errHistory = (uint16_t)((_errHistory << 1) | (error ? 1u : 0u));
+  if (!error || _rateIdx == 0) return;
+  if (__builtin_popcount(_errHistory) < KFD_RATE_STEPDOWN_ERRORS) return;
+
+  // The errors stay in the window: while the rate keeps failing, every
+  // further error steps down again before the retries run out.
+  setRate(_rateIdx - 1);
+  _telemetry.rateStepDowns++;
+  if (_radioId) rateCacheStore(_radioId, _rateIdx);
+  KLOGW(KFD, "clock: line errors, stepping down to %u bps", clockRateBps());
+}
+
+// First frame at or after idx that still has to go out.
+size_t KFDProtocol::nextFrame(size_t idx) const {
+  while (idx < _plan.frameCount() && _plan.frame(idx).skip) idx++;
+  return idx;
+}
+
+// Act on the answer to _currentFrame. An ack advances to the next frame's
+// phase. A retryable failure schedules a backoff and retransmit of this
+// frame only; anything else moves to ERROR.
+void KFDProtocol::handleAck(FrameResult r) {
+  if (r == FRAME_MORE) {
+    _attempt = 0;
+    _state   = _resumeState;
+    return;
+  }
+
+  noteLineResult(r == FRAME_TIMEOUT || r == FRAME_INTEGRITY);
+
+  if (r == FRAME_ACKED) {
+    const KfdPlanFrame& f     = _plan.frame(_currentFrame);
+    const bool          probe = _currentFrame == 0 && usingLine() && startClock();
+    if (f.keyIndex >= 0) {
+      (_transport->hasReceiver() ? _committedKeys : _unverifiedKeys).push_back((uint16_t)f.keyIndex);
+    }
+    if (f.inventory) {
+      const size_t skipped   = _plan.skippedCount();
+      _telemetry.keysSkipped = (uint32_t)skipped;
+      _telemetry.keysPlanned = (uint32_t)(_plan.keyCount() - skipped);
+      _telemetry.inventoryUs = micros() - _inventoryAtUs;
+      KLOGI(KFD, "inventory: %u of %u key(s) already current, %u us",
+            (unsigned)skipped, (unsigned)_plan.keyCount(), (unsigned)_telemetry.inventoryUs);
+    }
+    _currentFrame = nextFrame(_currentFrame + 1);
+    _attempt      = 0;
+    _state        = phaseFor(_currentFrame);
+    if (_state == SENDING_KEYS && _transport->window() > 1) {
+      _inFlight = 0;
+      _state    = PIPELINE;
+    }
+    if (_currentFrame < _plan.frameCount() && _plan.frame(_currentFrame).inventory) {
+      _inventoryAtUs = micros();
+    }
+    if (probe) {
+      _afterProbe = _state;
+      _state      = PROBE;
+    }
+    if (_state == SESSION_END && _resumeState != SESSION_END) KLOGI(KFD, "SESSION_END");
+    return;
+  }
+
+  if (!recordFailure(_currentFrame, r, _attempt)) {
+    _state = ERROR;
+    return;
+  }
+
+  _retryAtUs = micros() + backoffUs(_attempt);
+  _attempt++;
+  _telemetry.retries++;
+  _state = BACKOFF;
+}
+
+// Note why frame idx failed on the given attempt. Returns true if it may be
+// sent again: a timeout, a CRC failure or a transient NAK, with retries left.
+bool KFDProtocol::recordFailure(size_t idx, FrameResult r, uint8_t attempt) {
+  switch (r) {
+    case FRAME_TIMEOUT:      _lastFailure = FAIL_TIMEOUT;      break;
+    case FRAME_INTEGRITY:    _lastFailure = FAIL_INTEGRITY;    break;
+    case FRAME_BAD_RESPONSE: _lastFailure = FAIL_BAD_RESPONSE; break;
+    default:                 _lastFailure = FAIL_NAK;          break;
+  }
+  _lastFailedKey = _plan.frame(idx).keyIndex;
+
+  const bool retryable = (r == FRAME_TIMEOUT || r == FRAME_INTEGRITY ||
+                          (r == FRAME_NAK && nakIsTransient(_lastNakStatus)));
+  if (!retryable || attempt >= _delivery.maxRetries) {
+    KLOGE(KFD, "frame %u failed after %u attempt(s): failure %d, status %02X",
+          (unsigned)idx, (unsigned)attempt + 1, (int)_lastFailure, _lastNakStatus);
+    return false;
+  }
+  return true;
+}
+
+uint32_t KFDProtocol::backoffUs(uint8_t attempt) const {
+  uint32_t backoff = _delivery.backoffBaseUs << attempt;
+  return backoff > _delivery.backoffMaxUs ? _delivery.backoffMaxUs : backoff;
+}
+
+// -----------------------------------------------------------------------------
+// Pipelined key frames (windowed transports)
+// -----------------------------------------------------------------------------
+
+void KFDProtocol::pipelineSend(InFlight& slot) {
+  const uint32_t t0 = micros();
+  _transport->send(_plan.frameData(slot.frame), _plan.frame(slot.frame).length, slot.frame);
+  slot.sentAtUs = micros();
+  slot.sendUs   = slot.sentAtUs - t0;
+  slot.waiting  = true;
+}
+
+// An acknowledged frame leaves the window; a failed one is retransmitted on
+// its own after the usual backoff, while the rest of the window carries on.
+void KFDProtocol::pipelineAnswer(InFlight& slot, FrameResult r) {
+  const KfdPlanFrame& f = _plan.frame(slot.frame);
+
+  if (r == FRAME_ACKED) {
+    _committedKeys.push_back((uint16_t)f.keyIndex);
+    _telemetry.recordKey(slot.sendUs, micros() - slot.sentAtUs);
+    slot = _window[--_inFlight];
+    return;
+  }
+
+  if (!recordFailure(slot.frame, r, slot.attempt)) {
+    _state = ERROR;
+    return;
+  }
+  slot.nacked   = r == FRAME_NAK;
+  slot.waiting  = false;
+  slot.sentAtUs = micros() + backoffUs(slot.attempt);
+  slot.attempt++;
+  _telemetry.retries++;
+}
+
+// Keep up to window() key frames awaiting answers. Answers are matched to
+// their frame by tag and may arrive in any order. Once every key frame is
+// answered, the closing frames go out one at a time as usual.
+void KFDProtocol::pipelineStep() {
+  uint8_t  rsp[KFD_FRAME_MAX_PAYLOAD];
+  size_t   rspLen = 0;
+  uint16_t tag    = 0;
+  const KfdTransport::RxStatus st = _transport->receive(rsp, sizeof(rsp), rspLen, tag);
+
+  if (st != KfdTransport::RX_NONE) {
+    _pipeMoved = true;
+    for (size_t i = 0; i < _inFlight; ++i) {
+      InFlight& slot = _window[i];
+      if (!slot.waiting || slot.frame != tag) continue;
+
+      const KfdPlanFrame& f = _plan.frame(slot.frame);
+      FrameResult         r;
+      if (st == KfdTransport::RX_CORRUPT) {
+        _crcErrors++;
+        _telemetry.crcErrors++;
+        _telemetry.recordFrame(f.length, 0);
+        r = FRAME_INTEGRITY;
+      } else if (st == KfdTransport::RX_LOST) {
+        _telemetry.recordFrame(f.length, 0);
+        _telemetry.timeouts++;
+        r = FRAME_TIMEOUT;
+      } else {
+        _telemetry.recordFrame(f.length, rspLen + KFD_FRAME_OVERHEAD);
+        r = checkAnswer(slot.frame, rsp, rspLen);
+      }
+      pipelineAnswer(slot, r);
+      if (_state == ERROR) return;
+      break;
+    }
+  }
+
+  // Retransmits that are due, and timeouts on transports without their own.
+  const uint32_t now = micros();
+  for (size_t i = 0; i < _inFlight; ++i) {
+    InFlight& slot = _window[i];
+    if (!slot.waiting) {
+      if ((int32_t)(now - slot.sentAtUs) < 0) continue;
+      pipelineSend(slot);
+      _pipeMoved = true;
+    } else if (!_transport->reliable() && now - slot.sentAtUs >= _delivery.frameTimeoutUs) {
+      _telemetry.recordFrame(_plan.frame(slot.frame).length, 0);
+      _telemetry.timeouts++;
+      pipelineAnswer(slot, FRAME_TIMEOUT);
+      if (_state == ERROR) return;
+      _pipeMoved = true;
+    }
+  }
+
+  size_t window = _transport->window();
+  if (window > KFD_MAX_WINDOW) window = KFD_MAX_WINDOW;
+  while (_inFlight < window && phaseFor(_currentFrame) == SENDING_KEYS) {
+    InFlight& slot = _window[_inFlight++];
+    slot.frame   = (uint16_t)_currentFrame;
+    slot.attempt = 0;
+    slot.nacked  = false;
+    pipelineSend(slot);
+    _currentFrame = nextFrame(_currentFrame + 1);
+    _pipeMoved    = true;
+  }
+
+  if (_inFlight == 0 && phaseFor(_currentFrame) != SENDING_KEYS) {
+    _attempt     = 0;
+    _resumeState = SENDING_KEYS;
+    _state       = phaseFor(_currentFrame);
+    KLOGI(KFD, "SESSION_END");
+  }
+}
+
+void KFDProtocol::requestAbort() {
+  _abortRequestedUs.store(micros(), std::memory_order_relaxed);
+  _abortRequested.store(true, std::memory_order_release);
+}
+
+bool KFDProtocol::abortIfRequested() {
+  if (!_abortRequested.exchange(false, std::memory_order_acquire)) return false;
+  abort();
+  return true;
+}
+
+bool KFDProtocol::abort() {
+  _abortRequested.store(false, std::memory_order_relaxed);
+  if (_state == IDLE) return false;
+
+  // A frame that went out but was never acknowledged may or may not have
+  // been stored; a NAKed one was not.
+  _inDoubtKeys.clear();
+  const bool sentUnacked = _state == AWAIT_ACK ||
+                           (_state == BACKOFF && _lastFailure != FAIL_NAK);
+  if (sentUnacked && _plan.frame(_currentFrame).keyIndex >= 0) {
+    _inDoubtKeys.push_back((uint16_t)_plan.frame(_currentFrame).keyIndex);
+  }
+  if (_state == PIPELINE) {
+    for (size_t i = 0; i < _inFlight; ++i) {
+      if (_window[i].waiting || !_window[i].nacked) {
+        _inDoubtKeys.push_back((uint16_t)_plan.frame(_window[i].frame).keyIndex);
+      }
+    }
+    std::sort(_inDoubtKeys.begin(), _inDoubtKeys.end());
+  }
+  _inFlight = 0;
+
+  _transport->close();
+
+  const uint32_t requestedUs = _abortRequestedUs.exchange(0, std::memory_order_relaxed);
+  _abortLatencyUs = requestedUs ? micros() - requestedUs : 0;
+
+  _lastFailure   = FAIL_ABORTED;
+  _lastFailedKey = inDoubtKey();
+  _plan.clear();
+  _telemetry.finish(false, micros());
+  _state        = IDLE;
+  _currentFrame = 0;
+
+  KLOGI(KFD, "abort: %u key(s) committed, %u in doubt, %u sent unverified, latency %u us",
+        (unsigned)_committedKeys.size(), (unsigned)_inDoubtKeys.size(), (unsigned)_unverifiedKeys.size(),
+        (unsigned)_abortLatencyUs);
+  for (size_t i = 0; i < _inDoubtKeys.size(); ++i) {
+    KLOGI(KFD, "  in doubt key %u", (unsigned)_inDoubtKeys[i] + 1);
+  }
+  for (size_t i = 0; i < _committedKeys.size(); ++i) {
+    KLOGI(KFD, "  committed key %u", (unsigned)_committedKeys[i] + 1);
+  }
+  for (size_t i = 0; i < _unverifiedKeys.size(); ++i) {
+    KLOGI(KFD, "  unverified key %u", (unsigned)_unverifiedKeys[i] + 1);
+  }
   return true;
 }
 
@@ -136,6 +665,8 @@ static bool hexToBytes(const std::string& hex, uint8_t* out, size_t& outLen, siz
 // State machine
 // -----------------------------------------------------------------------------
 
+// Each call performs at most one line action (send a frame or poll for its
+// answer); loop() strings calls together until the port has to wait.
 void KFDProtocol::stateMachine() {
   switch (_state) {
     case IDLE:
@@ -143,65 +674,86 @@ void KFDProtocol::stateMachine() {
       break;
 
     case SESSION_START: {
-      Serial.println("[KFD] SESSION_START");
-      // In real life: assert EN, send any session start frames, etc.
-      twiSetEnable(true);
-      _state = SENDING_KEYS;
+      // First pass only; a retransmit of READY_REQ re-enters here.
+      if (_currentFrame == 0 && _attempt == 0) {
+        KLOGI(KFD, "SESSION_START");
+        _telemetry.startUs = micros();
+        _transport->open();
+      }
+      // Frame 0 is always READY_REQ; delta loads follow it with the
+      // inventory pages.
+      sendCurrentFrame();
       break;
     }
 
-    case SENDING_KEYS: {
-      if (_currentKeyIndex >= _activeContainer.keys.size()) {
-        _state = SESSION_END;
-        break;
-      }
-
-      const KeySlot& e = _activeContainer.keys[_currentKeyIndex];
+    case SENDING_KEYS:
+      sendCurrentFrame();
+      break;
 
-      // Skip keys that are not selected or have no hex data.
-      if (!e.selected || e.hex.empty()) {
-        Serial.printf("[KFD] Skipping key %u ('%s') – not selected/empty\n",
-                      (unsigned)_currentKeyIndex,
-                      e.label.c_str());
-        _currentKeyIndex++;
+    case SESSION_END: {
+      // Remaining frames are TRANSFER_DONE and DISCONNECT.
+      if (_currentFrame < _plan.frameCount()) {
+        sendCurrentFrame();
         break;
       }
+      _transport->close();
+      _plan.clear();
+      _telemetry.finish(true, micros());
+      _lastSessionOk = true;
+      _state         = IDLE;
+      _currentFrame  = 0;
+      break;
+    }
 
-      Serial.printf("[KFD] Sending key %u: label='%s', algo='%s'\n",
-                    (unsigned)_currentKeyIndex,
-                    e.label.c_str(),
-                    e.algo.c_str());
+    case AWAIT_ACK: {
+      const FrameResult r = pollAck();
+      if (r != FRAME_PENDING) handleAck(r);
+      break;
+    }
 
-      uint8_t keyBuf[64];
-      size_t  keyLen = 0;
-      if (!hexToBytes(e.hex, keyBuf, keyLen, sizeof(keyBuf))) {
-        Serial.println("[KFD] hexToBytes failed; marking ERROR");
-        _state = ERROR;
-        break;
-      }
+    case BACKOFF: {
+      if ((int32_t)(micros() - _retryAtUs) >= 0) _state = _resumeState;
+      break;
+    }
 
-      // For now, just send raw key bytes as a frame.
-      sendFrame(keyBuf, keyLen);
+    case PIPELINE:
+      pipelineStep();
+      break;
 
-      // Advance to next key; we send one key per stateMachine() pass.
-      _currentKeyIndex++;
+    case PROBE: {
+      // The test exchange is READY_REQ: short, and harmless to repeat.
+      setRate(_probeIdx);
+      _line.discard();
+      _line.send(_plan.frameData(0), _plan.frame(0).length, 0);
+      _sentAtUs = micros();
+      _state    = PROBE_WAIT;
       break;
     }
 
-    case SESSION_END: {
-      Serial.println("[KFD] SESSION_END");
-      // In real life: send session-end frame, drop EN, etc.
-      twiSetEnable(false);
-      _state           = IDLE;
-      _currentKeyIndex = 0;
+    case PROBE_WAIT: {
+      uint8_t  rsp[8];
+      size_t   rspLen = 0;
+      uint16_t tag    = 0;
+      const KfdTransport::RxStatus st = _line.receive(rsp, sizeof(rsp), rspLen, tag);
+      if (st == KfdTransport::RX_FRAME) {
+        probeResult(rspLen > 0 && rsp[0] == KFD_OPCODE_READY_GENERAL_MODE);
+      } else if (st == KfdTransport::RX_CORRUPT) {
+        _crcErrors++;
+        probeResult(false);
+      } else if (micros() - _sentAtUs >= _delivery.probeTimeoutUs) {
+        probeResult(false);
+      }
       break;
     }
 
     case ERROR: {
-      Serial.println("[KFD] ERROR state; aborting session");
-      twiSetEnable(false);
-      _state           = IDLE;
-      _currentKeyIndex = 0;
+      KLOGE(KFD, "ERROR state; aborting session");
+      _transport->close();
+      _inFlight = 0;
+      _plan.clear();
+      _telemetry.finish(false, micros());
+      _state        = IDLE;
+      _currentFrame = 0;
       break;
     }
   }
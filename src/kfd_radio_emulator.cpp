@@ -0,0 +1,221 @@
+#include "kfd_radio_emulator.h"
+
+#include <string.h>
+
+#include "kfd_frame.h"
+#include "kfd_session_plan.h"
+
+void KfdRadioEmulator::configure(const KfdEmulatorConfig& cfg) {
+  _cfg = cfg;
+  _rng = cfg.seed ? cfg.seed : 1;
+}
+
+void KfdRadioEmulator::reset() {
+  _inventory.clear();
+  _rspHead         = 0;
+  _rspCount        = 0;
+  _responsesQueued = 0;
+  _framesReceived  = 0;
+  _naksSent       = 0;
+  _bitsFlipped    = 0;
+  _crcRejects     = 0;
+}
+
+// xorshift32: cheap, deterministic for a given seed.
+uint32_t KfdRadioEmulator::nextRandom() {
+  uint32_t x = _rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  _rng = x;
+  return x;
+}
+
+// Configured line noise, plus the overspeed penalty when the KFD clocks
+// faster than the radio (currently) follows.
+uint32_t KfdRadioEmulator::bitErrorsPerMillion() const {
+  uint32_t limit = _cfg.maxBitRate;
+  if (_cfg.degradeAfterFrames && _framesReceived > _cfg.degradeAfterFrames) limit = _cfg.degradedMaxBitRate;
+  const bool overspeed = limit && _lineRate > limit;
+  return _cfg.bitErrorsPerMillion + (overspeed ? _cfg.overspeedErrorsPerMillion : 0);
+}
+
+void KfdRadioEmulator::corrupt(uint8_t* data, size_t len) {
+  const uint32_t ppm = bitErrorsPerMillion();
+  if (!ppm) return;
+  for (size_t i = 0; i < len; ++i) {
+    for (int b = 0; b < 8; ++b) {
+      if (nextRandom() % 1000000u < ppm) {
+        data[i] ^= (uint8_t)(1u << b);
+        _bitsFlipped++;
+      }
+    }
+  }
+}
+
+void KfdRadioEmulator::respond(const uint8_t* payload, size_t len, uint32_t nowUs) {
+  size_t depth = _cfg.responseQueueDepth ? _cfg.responseQueueDepth : 1;
+  if (depth > KFD_EMULATOR_MAX_QUEUED) depth = KFD_EMULATOR_MAX_QUEUED;
+  if (_rspCount >= depth) {
+    _rspHead = (_rspHead + 1) % KFD_EMULATOR_MAX_QUEUED;
+    _rspCount--;
+  }
+
+  Response& r = _rsp[(_rspHead + _rspCount) % KFD_EMULATOR_MAX_QUEUED];
+  r.len = kfdFrameEncode(payload, len, r.wire, sizeof(r.wire));
+  corrupt(r.wire, r.len);
+
+  uint32_t latency = _cfg.responseLatencyUs;
+  if (_cfg.latencyJitterUs) latency += nextRandom() % (_cfg.latencyJitterUs + 1);
+  r.readyUs = nowUs + latency;
+  _rspCount++;
+  _responsesQueued++;
+}
+
+void KfdRadioEmulator::storeKey(const uint8_t* frame, size_t len) {
+  KfdEmulatedKey k;
+  k.keyId  = (uint16_t)((frame[1] << 8) | frame[2]);
+  k.algId  = frame[3];
+  k.length = frame[4];
+  memset(k.data, 0, sizeof(k.data));
+  memcpy(k.data, frame + 5, len - 5);
+
+  for (auto& existing : _inventory) {
+    if (existing.keyId == k.keyId) {
+      existing = k;
+      return;
+    }
+  }
+  _inventory.push_back(k);
+}
+
+// One inventory page: keys from startId up, ascending, with the same
+// digest the KFD computes for the keys it plans to send.
+void KfdRadioEmulator::respondInventory(uint16_t startId, uint32_t nowUs) {
+  uint8_t rsp[4 + KFD_INVENTORY_MAX_ENTRIES * KFD_INVENTORY_ENTRY_BYTES];
+  rsp[0] = KFD_OPCODE_KMM;
+  rsp[1] = KFD_KMM_INVENTORY_RSP;
+  rsp[2] = 0;
+
+  size_t   count  = 0;
+  uint32_t nextId = startId;
+  while (count < KFD_INVENTORY_MAX_ENTRIES) {
+    // Smallest key ID >= nextId; the inventory is small, a scan will do.
+    const KfdEmulatedKey* best = nullptr;
+    for (const auto& k : _inventory) {
+      if (k.keyId >= nextId && (!best || k.keyId < best->keyId)) best = &k;
+    }
+    if (!best) break;
+
+    uint8_t* e = rsp + 4 + count * KFD_INVENTORY_ENTRY_BYTES;
+    e[0] = (uint8_t)(best->keyId >> 8);
+    e[1] = (uint8_t)(best->keyId & 0xFF);
+    e[2] = best->algId;
+    KfdSessionPlan::keyDigest(best->algId, best->data, best->length, e + 3);
+    count++;
+    nextId = (uint32_t)best->keyId + 1;
+  }
+
+  if (count == KFD_INVENTORY_MAX_ENTRIES) {
+    for (const auto& k : _inventory) {
+      if (k.keyId >= nextId) {
+        rsp[2] = KFD_INVENTORY_MORE;
+        break;
+      }
+    }
+  }
+  rsp[3] = (uint8_t)count;
+  respond(rsp, 4 + count * KFD_INVENTORY_ENTRY_BYTES, nowUs);
+}
+
+void KfdRadioEmulator::onFrame(const uint8_t* data, size_t len, uint32_t nowUs) {
+  if (!data || len == 0) return;
+  _framesReceived++;
+
+  uint8_t wire[KFD_FRAME_MAX_PAYLOAD + KFD_FRAME_OVERHEAD];
+  if (len > sizeof(wire)) len = sizeof(wire);
+  memcpy(wire, data, len);
+  corrupt(wire, len);
+
+  // A real radio drops frames that fail CRC; the KFD will time out.
+  KfdFrameParser parser;
+  parser.reset();
+  KfdFrameParser::Status st = KfdFrameParser::NEED_MORE;
+  for (size_t i = 0; i < len && st == KfdFrameParser::NEED_MORE; ++i) st = parser.push(wire[i]);
+  if (st != KfdFrameParser::FRAME_OK || parser.payloadLen() == 0) {
+    _crcRejects++;
+    return;
+  }
+
+  const uint8_t* frame = parser.payload();
+  len = parser.payloadLen();
+
+  switch (frame[0]) {
+    case KFD_OPCODE_READY_REQ: {
+      const uint8_t rsp[5] = { KFD_OPCODE_READY_GENERAL_MODE,
+                               (uint8_t)(_cfg.radioId >> 24), (uint8_t)(_cfg.radioId >> 16),
+                               (uint8_t)(_cfg.radioId >> 8),  (uint8_t)_cfg.radioId };
+      respond(rsp, _cfg.radioId ? sizeof(rsp) : 1, nowUs);
+      break;
+    }
+
+    case KFD_OPCODE_KMM: {
+      // Inventory requests are the only 4-byte KMM; key frames carry at
+      // least the 5-byte key header.
+      if (len == 4 && frame[1] == KFD_KMM_INVENTORY_CMD) {
+        if (_cfg.inventorySupported) {
+          respondInventory((uint16_t)((frame[2] << 8) | frame[3]), nowUs);
+        } else {
+          const uint8_t rsp[3] = { KFD_OPCODE_KMM, KFD_KMM_NAK, KFD_STATUS_INVALID_MSG_ID };
+          respond(rsp, sizeof(rsp), nowUs);
+        }
+        break;
+      }
+
+      bool wellFormed = len >= 5 && frame[4] <= sizeof(KfdEmulatedKey::data) && len == (size_t)(5 + frame[4]);
+      bool injectNak  = _cfg.nakPerMille && (nextRandom() % 1000u) < _cfg.nakPerMille;
+
+      if (!wellFormed || injectNak) {
+        const uint8_t rsp[3] = { KFD_OPCODE_KMM, KFD_KMM_NAK, KFD_STATUS_NOT_PERFORMED };
+        respond(rsp, sizeof(rsp), nowUs);
+        _naksSent++;
+        break;
+      }
+
+      storeKey(frame, len);
+      const uint8_t rsp[3] = { KFD_OPCODE_KMM, KFD_KMM_REKEY_ACK, 0x00 };
+      respond(rsp, sizeof(rsp), nowUs);
+      break;
+    }
+
+    case KFD_OPCODE_TRANSFER_DONE: {
+      const uint8_t rsp = KFD_OPCODE_TRANSFER_DONE;
+      respond(&rsp, 1, nowUs);
+      break;
+    }
+
+    case KFD_OPCODE_DISCONNECT: {
+      const uint8_t rsp = KFD_OPCODE_DISCONNECT_ACK;
+      respond(&rsp, 1, nowUs);
+      break;
+    }
+
+    default:
+      // Valid frame, unknown opcode: ignored like a real radio would.
+      break;
+  }
+}
+
+bool KfdRadioEmulator::takeResponse(uint8_t* buf, size_t maxLen, size_t& outLen, uint32_t nowUs) {
+  outLen = 0;
+  if (_rspCount == 0) return false;
+  const Response& r = _rsp[_rspHead];
+  if ((int32_t)(nowUs - r.readyUs) < 0) return false;
+
+  size_t n = (r.len < maxLen) ? r.len : maxLen;
+  memcpy(buf, r.wire, n);
+  outLen   = n;
+  _rspHead = (_rspHead + 1) % KFD_EMULATOR_MAX_QUEUED;
+  _rspCount--;
+  return true;
+}
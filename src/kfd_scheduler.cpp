@@ -0,0 +1,109 @@
+#include "kfd_scheduler.h"
+
+#include <Arduino.h>
+
+#include "kfd_line_trace.h"
+
+// -----------------------------------------------------------------------------
+// Pin assignments per 3WI port – adjust to your hardware. Port 0 keeps the
+// original single-port wiring; the others avoid the display bus, touch
+// I2C and interrupt, and microSD pins. GPIO 43 is UART0 TX, free because
+// Serial runs over USB CDC.
+// -----------------------------------------------------------------------------
+static constexpr KfdPins KFD_PORT_PINS[KFD_MAX_PORTS] = {
+  { 21, 22, 23 },
+  {  1,  2, 43 },
+  { 10, 11, 12 },
+  { 13, 14, 42 },
+};
+
+static constexpr bool portPinsAvoid(size_t i, int pin) {
+  return i == KFD_MAX_PORTS ||
+         (KFD_PORT_PINS[i].data != pin && KFD_PORT_PINS[i].clk != pin &&
+          KFD_PORT_PINS[i].en != pin && portPinsAvoid(i + 1, pin));
+}
+static_assert(portPinsAvoid(0, TOUCH_PIN_INT), "a 3WI port pin is the touch interrupt line");
+
+KfdPortScheduler& KfdPortScheduler::instance() {
+  static KfdPortScheduler inst;
+  return inst;
+}
+
+KfdPortScheduler::KfdPortScheduler() {
+  for (size_t i = 0; i < KFD_MAX_PORTS; ++i) _ports[i].setPins(KFD_PORT_PINS[i]);
+}
+
+bool KfdPortScheduler::begin() {
+  bool ok = true;
+  for (size_t i = 0; i < portCount(); ++i) ok = _ports[i].begin() && ok;
+  _ports[0].attachTrace(&KfdLineTrace::instance());
+  Serial.printf("[KFD] scheduler: %u port(s)\n", (unsigned)portCount());
+  return ok;
+}
+
+size_t KfdPortScheduler::beginKeyload(const KeyContainer& kc, KfdLoadMode mode) {
+  size_t   started = 0;
+  uint32_t mask    = 0;
+  for (size_t i = 0; i < portCount(); ++i) {
+    if (_ports[i].busy()) continue;
+    if (!_ports[i].beginKeyload(kc, mode)) {
+      // A rejected plan is rejected on every port; don't keep compiling it.
+      if (_ports[i].lastPlanResult() != KfdSessionPlan::OK) break;
+      continue;
+    }
+    mask |= 1u << i;
+    started++;
+  }
+  if (started) {
+    _sessionMask = mask;
+    _started     = started;
+    _active      = started;
+  }
+  return started;
+}
+
+void KfdPortScheduler::service() {
+  const size_t n = portCount();
+  size_t active = 0;
+  for (size_t k = 0; k < n; ++k) {
+    KFDProtocol& p = _ports[(_next + k) % n];
+    if (!p.busy()) continue;
+    p.loop();
+    if (p.busy()) active++;
+  }
+  _next   = (_next + 1) % n;
+  _active = active;
+}
+
+void KfdPortScheduler::requestAbort() {
+  for (size_t i = 0; i < portCount(); ++i) _ports[i].requestAbort();
+}
+
+void KfdPortScheduler::serviceAborts() {
+  for (size_t i = 0; i < portCount(); ++i) _ports[i].abortIfRequested();
+}
+
+bool KfdPortScheduler::busy() const {
+  for (size_t i = 0; i < portCount(); ++i) {
+    if (_ports[i].busy()) return true;
+  }
+  return false;
+}
+
+uint8_t KfdPortScheduler::progressPercent() const {
+  unsigned sum = 0, n = 0;
+  for (size_t i = 0; i < portCount(); ++i) {
+    if (!inSession(i)) continue;
+    sum += _ports[i].telemetry().progressPercent();
+    n++;
+  }
+  return n ? (uint8_t)(sum / n) : 0;
+}
+
+size_t KfdPortScheduler::okCount() const {
+  size_t ok = 0;
+  for (size_t i = 0; i < portCount(); ++i) {
+    if (inSession(i) && !_ports[i].busy() && _ports[i].lastSessionOk()) ok++;
+  }
+  return ok;
+}
@@ -0,0 +1,195 @@
+#include "kfd_session_plan.h"
+
+#include <string.h>
+
+#include "hex_codec.h"
+#include "kfd_frame.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/version.h"
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+size_t KfdSessionPlan::expectedKeyLength(uint8_t algId) {
+  switch (algId) {
+    case 0x84: return 32;  // AES-256
+    case 0x89: return 16;  // AES-128
+    case 0x81: return 8;   // DES-OFB
+    case 0xAA: return 5;   // ADP
+    default:   return 0;
+  }
+}
+
+uint8_t KfdSessionPlan::algorithmId(const std::string& algo) {
+  if (algo == "AES256")  return 0x84;
+  if (algo == "AES128")  return 0x89;
+  if (algo == "DES-OFB") return 0x81;
+  if (algo == "ADP")     return 0xAA;
+  return 0x80;
+}
+
+// mbedTLS 3 (IDF 5) dropped the _ret suffix the 2.x one-shot carries.
+void KfdSessionPlan::keyDigest(uint8_t algId, const uint8_t* key, size_t len, uint8_t* out) {
+  uint8_t in[1 + KFD_MAX_KEY_BYTES];
+  uint8_t sha[32];
+  if (len > KFD_MAX_KEY_BYTES) len = KFD_MAX_KEY_BYTES;
+  in[0] = algId;
+  memcpy(in + 1, key, len);
+#if MBEDTLS_VERSION_NUMBER >= 0x03000000
+  mbedtls_sha256(in, 1 + len, sha, 0);
+#else
+  mbedtls_sha256_ret(in, 1 + len, sha, 0);
+#endif
+  memcpy(out, sha, KFD_KEY_DIGEST_BYTES);
+}
+
+const char* KfdSessionPlan::resultName(Result r) {
+  switch (r) {
+    case OK:             return "OK";
+    case NO_KEYS:        return "NO KEYS SELECTED";
+    case BAD_HEX:        return "BAD KEY HEX";
+    case BAD_KEY_LENGTH: return "KEY LENGTH MISMATCH";
+    case TOO_MANY_KEYS:  return "TOO MANY KEYS";
+  }
+  return "UNKNOWN";
+}
+
+// -----------------------------------------------------------------------------
+// Plan building
+// -----------------------------------------------------------------------------
+
+void KfdSessionPlan::clear() {
+  bytes_.clear();
+  frames_.clear();
+  keyFrame_.clear();
+  inventoryFrame_ = -1;
+  keyCount_       = 0;
+  skipped_        = 0;
+  errorKeyIndex_  = -1;
+}
+
+// Every planned frame is stored already wrapped in SOF/LEN/CRC, so the line
+// engine never has to touch the payload again.
+void KfdSessionPlan::appendFrame(const uint8_t* payload, size_t len, int16_t keyIndex, uint8_t expectedResponse) {
+  KfdPlanFrame f;
+  f.offset           = (uint32_t)bytes_.size();
+  f.length           = (uint16_t)(len + KFD_FRAME_OVERHEAD);
+  f.keyIndex         = keyIndex;
+  f.expectedResponse = expectedResponse;
+  f.algId            = 0;
+  memset(f.digest, 0, sizeof(f.digest));
+  f.inventory        = false;
+  f.skip             = false;
+
+  bytes_.resize(bytes_.size() + f.length);
+  kfdFrameEncode(payload, len, bytes_.data() + f.offset, f.length);
+  frames_.push_back(f);
+}
+
+void KfdSessionPlan::appendControl(uint8_t opcode, uint8_t expectedResponse) {
+  appendFrame(&opcode, 1, -1, expectedResponse);
+}
+
+// Key payload layout: KMM, key ID (BE16), algorithm ID, key length, key bytes.
+void KfdSessionPlan::appendKey(uint16_t keyIndex, uint8_t algId, const uint8_t* key, size_t keyLen) {
+  const uint16_t keyId = (uint16_t)(keyIndex + 1);
+
+  uint8_t payload[5 + KFD_MAX_KEY_BYTES];
+  payload[0] = KFD_OPCODE_KMM;
+  payload[1] = (uint8_t)(keyId >> 8);
+  payload[2] = (uint8_t)(keyId & 0xFF);
+  payload[3] = algId;
+  payload[4] = (uint8_t)keyLen;
+  memcpy(payload + 5, key, keyLen);
+
+  appendFrame(payload, 5 + keyLen, (int16_t)keyIndex, KFD_OPCODE_KMM);
+  frames_.back().algId = algId;
+  keyDigest(algId, key, keyLen, frames_.back().digest);
+  keyFrame_[keyIndex] = (int16_t)(frames_.size() - 1);
+}
+
+// Always compiled for the first page; setInventoryStart() rewrites the
+// start ID in place for later pages (the frame length never changes).
+void KfdSessionPlan::appendInventory() {
+  const uint8_t payload[4] = { KFD_OPCODE_KMM, KFD_KMM_INVENTORY_CMD, 0x00, 0x00 };
+  appendFrame(payload, sizeof(payload), -1, KFD_OPCODE_KMM);
+  frames_.back().inventory = true;
+  inventoryFrame_          = (int)(frames_.size() - 1);
+}
+
+void KfdSessionPlan::setInventoryStart(uint16_t keyId) {
+  if (inventoryFrame_ < 0) return;
+  KfdPlanFrame& f = frames_[inventoryFrame_];
+  const uint8_t payload[4] = { KFD_OPCODE_KMM, KFD_KMM_INVENTORY_CMD,
+                               (uint8_t)(keyId >> 8), (uint8_t)(keyId & 0xFF) };
+  kfdFrameEncode(payload, sizeof(payload), bytes_.data() + f.offset, f.length);
+}
+
+size_t KfdSessionPlan::applyInventory(const uint8_t* entries, size_t count) {
+  size_t marked = 0;
+  for (size_t n = 0; n < count; ++n, entries += KFD_INVENTORY_ENTRY_BYTES) {
+    const uint16_t keyId = (uint16_t)((entries[0] << 8) | entries[1]);
+
+    // Key IDs are container index + 1; anything else is not ours.
+    if (keyId == 0 || keyId > keyFrame_.size()) continue;
+    const int16_t idx = keyFrame_[keyId - 1];
+    if (idx < 0) continue;
+
+    KfdPlanFrame& f = frames_[idx];
+    if (f.skip || f.algId != entries[2] || memcmp(f.digest, entries + 3, KFD_KEY_DIGEST_BYTES) != 0) continue;
+    f.skip = true;
+    marked++;
+  }
+  skipped_ += marked;
+  return marked;
+}
+
+KfdSessionPlan::Result KfdSessionPlan::compile(const KeyContainer& kc, KfdLoadMode mode) {
+  clear();
+
+  if (kc.keys.size() > 0x7FFF) return TOO_MANY_KEYS;
+
+  // Size the buffer once: control frames plus worst-case key frames.
+  size_t selected = 0;
+  for (const auto& k : kc.keys) {
+    if (k.selected && !k.hex.empty()) selected++;
+  }
+  if (selected == 0) return NO_KEYS;
+
+  bytes_.reserve((4 + selected) * KFD_FRAME_OVERHEAD + 7 + selected * (5 + KFD_MAX_KEY_BYTES));
+  frames_.reserve(4 + selected);
+  keyFrame_.assign(kc.keys.size(), -1);
+
+  appendControl(KFD_OPCODE_READY_REQ, KFD_OPCODE_READY_GENERAL_MODE);
+  if (mode == KFD_LOAD_DELTA) appendInventory();
+
+  for (size_t i = 0; i < kc.keys.size(); ++i) {
+    const KeySlot& e = kc.keys[i];
+    if (!e.selected || e.hex.empty()) continue;
+
+    uint8_t keyBuf[KFD_MAX_KEY_BYTES];
+    size_t  keyLen = 0;
+    if (hexDecode(e.hex.data(), e.hex.size(), keyBuf, sizeof(keyBuf), keyLen) != HEX_OK || keyLen == 0) {
+      clear();
+      errorKeyIndex_ = (int)i;
+      return BAD_HEX;
+    }
+
+    const uint8_t algId    = algorithmId(e.algo);
+    const size_t  expected = expectedKeyLength(algId);
+    if (expected != 0 && keyLen != expected) {
+      clear();
+      errorKeyIndex_ = (int)i;
+      return BAD_KEY_LENGTH;
+    }
+
+    appendKey((uint16_t)i, algId, keyBuf, keyLen);
+    keyCount_++;
+  }
+
+  appendControl(KFD_OPCODE_TRANSFER_DONE, KFD_OPCODE_TRANSFER_DONE);
+  appendControl(KFD_OPCODE_DISCONNECT,    KFD_OPCODE_DISCONNECT_ACK);
+
+  return OK;
+}
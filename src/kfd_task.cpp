@@ -0,0 +1,265 @@
+#include "kfd_task.h"
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "kfd_line_trace.h"
+
+// Progress events are dropped rather than block the line when the UI falls
+// behind; this many slots stay reserved for completion events.
+static constexpr size_t KFD_EVENT_RESERVE = 4;
+
+// Idle wait between command checks when no session is running.
+static constexpr TickType_t KFD_IDLE_TICKS = pdMS_TO_TICKS(50);
+
+KfdProtocolTask& KfdProtocolTask::instance() {
+  static KfdProtocolTask inst;
+  return inst;
+}
+
+bool KfdProtocolTask::start() {
+  if (_handle) return true;
+
+  TaskHandle_t h = nullptr;
+  BaseType_t rc = xTaskCreatePinnedToCore(taskEntry, "kfd", KFD_TASK_STACK, this,
+                                          KFD_TASK_PRIORITY, &h, KFD_TASK_CORE);
+  if (rc != pdPASS) {
+    Serial.println("[KFD] task: create failed");
+    return false;
+  }
+  _handle = h;
+  Serial.printf("[KFD] task: running on core %d, priority %d\n", KFD_TASK_CORE, KFD_TASK_PRIORITY);
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+// UI side
+// -----------------------------------------------------------------------------
+
+// Refused while the task is not running (e.g. KFDtool adapter mode), so
+// the UI reports the port busy instead of waiting on a dead queue.
+bool KfdProtocolTask::sendCommand(const KfdCommand& cmd) {
+  if (!_handle || !_commands.push(cmd)) return false;
+  if (_handle) xTaskNotifyGive((TaskHandle_t)_handle);
+  return true;
+}
+
+bool KfdProtocolTask::requestKeyload(const KeyContainer& kc, KfdLoadMode mode) {
+  KfdCommand cmd;
+  cmd.type       = KfdCommand::START_KEYLOAD;
+  cmd.mode       = mode;
+  cmd.container  = new KeyContainer(kc);
+  cmd.abortEpoch = _abortEpoch.load(std::memory_order_relaxed);
+  if (sendCommand(cmd)) return true;
+  delete cmd.container;
+  return false;
+}
+
+bool KfdProtocolTask::requestStats() {
+  KfdCommand cmd;
+  cmd.type       = KfdCommand::PRINT_STATS;
+  cmd.mode       = KFD_LOAD_DELTA;
+  cmd.container  = nullptr;
+  cmd.abortEpoch = 0;
+  return sendCommand(cmd);
+}
+
+bool KfdProtocolTask::requestTrace(KfdCommand::Type type) {
+  KfdCommand cmd;
+  cmd.type       = type;
+  cmd.mode       = KFD_LOAD_DELTA;
+  cmd.container  = nullptr;
+  cmd.abortEpoch = 0;
+  return sendCommand(cmd);
+}
+
+// Bypasses the command queue: the ports' abort flags are atomic, and a
+// full queue must never delay a cancel.
+void KfdProtocolTask::requestAbort() {
+  _abortEpoch.fetch_add(1, std::memory_order_release);
+  KfdPortScheduler::instance().requestAbort();
+  if (_handle) xTaskNotifyGive((TaskHandle_t)_handle);
+}
+
+// -----------------------------------------------------------------------------
+// Task side
+// -----------------------------------------------------------------------------
+
+void KfdProtocolTask::taskEntry(void* arg) {
+  static_cast<KfdProtocolTask*>(arg)->run();
+}
+
+// Completion events must arrive; wait for the UI to drain a slot. A stop
+// requested meanwhile is still carried out within a tick.
+void KfdProtocolTask::post(const KfdEvent& ev) {
+  while (!_events.push(ev)) {
+    KfdPortScheduler::instance().serviceAborts();
+    vTaskDelay(1);
+  }
+  if (_waiter) xTaskNotifyGive((TaskHandle_t)_waiter);
+}
+
+void KfdProtocolTask::postBestEffort(const KfdEvent& ev) {
+  if (_events.space() <= KFD_EVENT_RESERVE || !_events.push(ev)) return;
+  if (_waiter) xTaskNotifyGive((TaskHandle_t)_waiter);
+}
+
+static KfdEvent makeEvent(KfdEvent::Type type, size_t port) {
+  const KFDProtocol& p = KfdPortScheduler::instance().port(port);
+
+  KfdEvent ev = {};
+  ev.type       = type;
+  ev.port       = (uint8_t)port;
+  ev.aborted    = p.lastFailure() == KFDProtocol::FAIL_ABORTED;
+  ev.committed  = (uint16_t)p.committedKeys().size();
+  ev.unverified = (uint16_t)p.unverifiedKeys().size();
+  ev.inDoubtKey = (int16_t)p.inDoubtKey();
+  ev.inDoubt    = (uint8_t)p.inDoubtKeys().size();
+  ev.telemetry  = p.telemetry();
+  return ev;
+}
+
+void KfdProtocolTask::handleCommand(const KfdCommand& cmd) {
+  KfdPortScheduler& sched = KfdPortScheduler::instance();
+
+  switch (cmd.type) {
+    case KfdCommand::START_KEYLOAD: {
+      // Stopped before the task got to it: a session start would clear
+      // the ports' abort flags, so the stop has to be honoured here.
+      if (cmd.abortEpoch != _abortEpoch.load(std::memory_order_acquire)) {
+        delete cmd.container;
+        KfdEvent ev   = makeEvent(KfdEvent::REJECTED, 0);
+        ev.planResult = (uint8_t)KfdSessionPlan::OK;
+        ev.aborted    = true;
+        post(ev);
+        break;
+      }
+
+      const size_t started = sched.busy() ? 0 : sched.beginKeyload(*cmd.container, cmd.mode);
+      delete cmd.container;
+
+      if (started == 0) {
+        KfdEvent ev = makeEvent(KfdEvent::REJECTED, 0);
+        ev.planResult = sched.busy() ? (uint8_t)KfdSessionPlan::OK
+                                     : (uint8_t)sched.port(0).lastPlanResult();
+        post(ev);
+        break;
+      }
+
+      KfdEvent ev = makeEvent(KfdEvent::STARTED, 0);
+      for (size_t i = 0; i < sched.portCount(); ++i) {
+        _lastPercent[i] = 0;
+        _wasBusy[i]     = sched.inSession(i);
+        if (_wasBusy[i]) ev.portMask |= (uint8_t)(1u << i);
+      }
+      _sessionOpen = true;
+
+      ev.ports = (uint8_t)started;
+      post(ev);
+      break;
+    }
+
+    case KfdCommand::PRINT_STATS:
+      for (size_t i = 0; i < sched.portCount(); ++i) {
+        Serial.printf("[KFD] port %u:\n", (unsigned)(i + 1));
+        sched.port(i).telemetry().print();
+      }
+      break;
+
+    case KfdCommand::TRACE_ON:
+      KfdLineTrace::instance().clear();
+      KfdLineTrace::instance().setEnabled(true);
+      Serial.println("[KFD] trace: capturing port 1");
+      break;
+
+    case KfdCommand::TRACE_OFF:
+      KfdLineTrace::instance().setEnabled(false);
+      Serial.printf("[KFD] trace: stopped, %u edges, %u cycles/edge\n",
+                    (unsigned)KfdLineTrace::instance().edgeCount(),
+                    (unsigned)KfdLineTrace::instance().cyclesPerEdge());
+      break;
+
+    case KfdCommand::TRACE_DUMP:
+      KfdLineTrace::instance().writeVcd(Serial);
+      break;
+
+    case KfdCommand::TRACE_SAVE:
+      Serial.printf("[KFD] trace: save to SD %s\n",
+                    KfdLineTrace::instance().saveVcd("/kfd_trace.vcd") ? "OK" : "FAILED");
+      break;
+  }
+}
+
+void KfdProtocolTask::publishProgress() {
+  KfdPortScheduler& sched = KfdPortScheduler::instance();
+
+  for (size_t i = 0; i < sched.portCount(); ++i) {
+    if (!sched.inSession(i)) continue;
+    const KFDProtocol& p = sched.port(i);
+
+    if (_wasBusy[i] && !p.busy()) {
+      _wasBusy[i] = false;
+      KfdEvent ev = makeEvent(KfdEvent::PORT_DONE, i);
+      ev.percent  = p.telemetry().progressPercent();
+      ev.ok       = p.lastSessionOk();
+      ev.failure  = ev.ok ? nullptr : p.failureText();
+      post(ev);
+      continue;
+    }
+
+    const uint8_t pct = p.telemetry().progressPercent();
+    if (p.busy() && pct != _lastPercent[i]) {
+      _lastPercent[i] = pct;
+      KfdEvent ev = makeEvent(KfdEvent::PROGRESS, i);
+      ev.percent  = pct;
+      postBestEffort(ev);
+    }
+  }
+
+  if (_sessionOpen && !sched.busy()) {
+    _sessionOpen = false;
+
+    // Carry the first failed port, or the first port if all succeeded.
+    size_t shown = sched.portCount();
+    for (size_t i = 0; i < sched.portCount(); ++i) {
+      if (!sched.inSession(i)) continue;
+      if (shown == sched.portCount()) shown = i;
+      if (!sched.port(i).lastSessionOk()) {
+        shown = i;
+        break;
+      }
+    }
+    if (shown == sched.portCount()) shown = 0;
+
+    KfdEvent ev = makeEvent(KfdEvent::SESSION_DONE, shown);
+    ev.percent  = sched.progressPercent();
+    ev.ports    = (uint8_t)sched.sessionCount();
+    ev.okPorts  = (uint8_t)sched.okCount();
+    ev.ok       = ev.okPorts == ev.ports;
+    ev.failure  = ev.ok ? nullptr : sched.port(shown).failureText();
+    post(ev);
+  }
+}
+
+void KfdProtocolTask::run() {
+  KfdPortScheduler& sched = KfdPortScheduler::instance();
+
+  for (;;) {
+    KfdCommand cmd;
+    while (_commands.pop(cmd)) handleCommand(cmd);
+
+    if (!sched.busy()) {
+      // Sleep until the UI sends a command (or the idle period passes).
+      ulTaskNotifyTake(pdTRUE, KFD_IDLE_TICKS);
+      continue;
+    }
+
+    sched.service();
+    publishProgress();
+
+    // Every busy port is waiting on its radio: give up the core for a
+    // tick, or less if an abort notification arrives.
+    if (sched.busy()) ulTaskNotifyTake(pdTRUE, 1);
+  }
+}
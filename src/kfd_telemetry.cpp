@@ -0,0 +1,109 @@
+#include "kfd_telemetry.h"
+
+#include <Arduino.h>
+#include <string.h>
+
+void KfdSessionTelemetry::reset(uint32_t id, uint32_t keys, uint32_t nowUs) {
+  memset(this, 0, sizeof(*this));
+  sessionId    = id;
+  keysPlanned  = keys;
+  startUs      = nowUs;
+  keySendUsMin = UINT32_MAX;
+  keyAckUsMin  = UINT32_MAX;
+  active       = true;
+}
+
+void KfdSessionTelemetry::recordFrame(size_t txBytes, size_t rxBytes) {
+  framesTx++;
+  bytesTx += (uint32_t)txBytes;
+  bytesRx += (uint32_t)rxBytes;
+}
+
+static void recordSend(KfdSessionTelemetry& t, uint32_t sendUs) {
+  if (t.keysAcked + t.keysUnverified == 0) t.firstKeyUs = micros() - t.startUs;
+  if (sendUs < t.keySendUsMin) t.keySendUsMin = sendUs;
+  if (sendUs > t.keySendUsMax) t.keySendUsMax = sendUs;
+  t.keySendUsTotal += sendUs;
+}
+
+void KfdSessionTelemetry::recordKey(uint32_t sendUs, uint32_t ackUs) {
+  recordSend(*this, sendUs);
+  keysAcked++;
+
+  if (ackUs < keyAckUsMin) keyAckUsMin = ackUs;
+  if (ackUs > keyAckUsMax) keyAckUsMax = ackUs;
+  keyAckUsTotal += ackUs;
+}
+
+// Nothing can answer on the line, so the key is counted as sent only:
+// whether the radio stored it is unknown.
+void KfdSessionTelemetry::recordUnverifiedKey(uint32_t sendUs) {
+  recordSend(*this, sendUs);
+  keysUnverified++;
+}
+
+void KfdSessionTelemetry::finish(bool success, uint32_t nowUs) {
+  totalUs    = nowUs - startUs;
+  bitRateBps = totalUs ? (uint32_t)(((uint64_t)(bytesTx + bytesRx) * 8u * 1000000u) / totalUs) : 0;
+  ok         = success;
+  active     = false;
+}
+
+uint8_t KfdSessionTelemetry::progressPercent() const {
+  // A delta load can find nothing to send.
+  if (keysPlanned == 0) return (!active && ok) ? 100 : 0;
+  return (uint8_t)(((keysAcked + keysUnverified) * 100u) / keysPlanned);
+}
+
+void KfdSessionTelemetry::format(char* buf, size_t len) const {
+  const uint32_t avgAck = keysAcked ? keyAckUsTotal / keysAcked : 0;
+  const uint32_t elapsed = active ? micros() - startUs : totalUs;
+
+  char skipped[20] = "";
+  if (keysSkipped) snprintf(skipped, sizeof(skipped), " +%u CUR", (unsigned)keysSkipped);
+
+  // Without a receiver only the count sent is known.
+  const bool unverified = keysUnverified > 0;
+
+  snprintf(buf, len,
+           "%s %u/%u%s  %u.%03u s  %u bps\n"
+           "1ST KEY %u ms  ACK AVG %u us\n"
+           "RETRY %u  NAK %u  TIMEOUT %u  CRC %u",
+           unverified ? "SENT, UNVERIFIED" : "KEYS",
+           (unsigned)(unverified ? keysUnverified : keysAcked), (unsigned)keysPlanned, skipped,
+           (unsigned)(elapsed / 1000000u), (unsigned)((elapsed / 1000u) % 1000u),
+           (unsigned)bitRateBps,
+           (unsigned)(firstKeyUs / 1000u), (unsigned)avgAck,
+           (unsigned)retries, (unsigned)naks, (unsigned)timeouts, (unsigned)crcErrors);
+}
+
+void KfdSessionTelemetry::print() const {
+  const uint32_t sent = keysAcked + keysUnverified;
+  const uint32_t n    = keysAcked ? keysAcked : 1;
+
+  Serial.printf("[KFD] session %u: %s\n", (unsigned)sessionId,
+                active ? "ACTIVE" : (ok ? "OK" : "FAILED"));
+  Serial.printf("  keys        %u/%u acked\n", (unsigned)keysAcked, (unsigned)keysPlanned);
+  if (keysUnverified) {
+    Serial.printf("              %u sent, unverified (no receiver on the line)\n", (unsigned)keysUnverified);
+  }
+  if (keysSkipped || inventoryUs) {
+    Serial.printf("  inventory   %u us, %u key(s) already current\n",
+                  (unsigned)inventoryUs, (unsigned)keysSkipped);
+  }
+  Serial.printf("  first key   %u us\n", (unsigned)firstKeyUs);
+  Serial.printf("  total       %u us\n", (unsigned)totalUs);
+  Serial.printf("  frames/tx/rx %u / %u B / %u B\n",
+                (unsigned)framesTx, (unsigned)bytesTx, (unsigned)bytesRx);
+  Serial.printf("  bit rate    %u bps\n", (unsigned)bitRateBps);
+  Serial.printf("  clock       %u bps, probe %u us, %u step-down(s)\n",
+                (unsigned)clockBps, (unsigned)probeUs, (unsigned)rateStepDowns);
+  Serial.printf("  key send us min/avg/max %u / %u / %u\n",
+                (unsigned)(sent ? keySendUsMin : 0), (unsigned)(keySendUsTotal / (sent ? sent : 1)),
+                (unsigned)keySendUsMax);
+  Serial.printf("  key ack  us min/avg/max %u / %u / %u\n",
+                (unsigned)(keysAcked ? keyAckUsMin : 0), (unsigned)(keyAckUsTotal / n),
+                (unsigned)keyAckUsMax);
+  Serial.printf("  retries %u  naks %u  timeouts %u  crc errors %u\n",
+                (unsigned)retries, (unsigned)naks, (unsigned)timeouts, (unsigned)crcErrors);
+}
@@ -0,0 +1,173 @@
+#include "kfd_three_wire.h"
+
+#include <Arduino.h>
+
+#include "kfd_line_trace.h"
+#include "kfd_radio_emulator.h"
+#include "klog.h"
+
+// -----------------------------------------------------------------------------
+// Line setup
+// -----------------------------------------------------------------------------
+
+void KfdThreeWireTransport::begin() {
+  // Configure GPIO as outputs; you can tune this to your real wiring.
+  if (_pins.data >= 0) {
+    pinMode(_pins.data, OUTPUT);
+    pinMode(_pins.clk,  OUTPUT);
+    pinMode(_pins.en,   OUTPUT);
+
+    digitalWrite(_pins.data, LOW);
+    digitalWrite(_pins.clk,  LOW);
+    digitalWrite(_pins.en,   LOW);
+  }
+  discard();
+}
+
+void KfdThreeWireTransport::setClockRate(size_t idx) {
+  _rateIdx = idx;
+  _halfUs  = _pins.data >= 0 ? KFD_CLOCK_HALF_US[idx] : 0;
+}
+
+void KfdThreeWireTransport::open() {
+  twiSetEnable(true);
+}
+
+// Safe state: EN, CLK and DATA low. Frames are clocked out whole inside
+// send(), so no partial frame is ever left on the wire.
+void KfdThreeWireTransport::close() {
+  twiSetEnable(false);
+  twiSetClock(false);
+  twiSetData(false);
+  discard();
+}
+
+void KfdThreeWireTransport::discard() {
+  _rxRing.clear();
+  _rxParser.reset();
+  _txParser.reset();
+  _txRawLen = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Low-level helpers
+// -----------------------------------------------------------------------------
+
+// Every driven level also goes to the line trace (if attached), pins or not.
+void KfdThreeWireTransport::twiSetData(bool level) {
+  if (_pins.data >= 0) digitalWrite(_pins.data, level ? HIGH : LOW);
+  if (_trace) _trace->record(KFD_LINE_DATA, level);
+}
+void KfdThreeWireTransport::twiSetClock(bool level) {
+  if (_pins.clk >= 0) digitalWrite(_pins.clk, level ? HIGH : LOW);
+  if (_trace) _trace->record(KFD_LINE_CLK, level);
+}
+void KfdThreeWireTransport::twiSetEnable(bool level) {
+  if (_pins.en >= 0) digitalWrite(_pins.en, level ? HIGH : LOW);
+  if (_trace) _trace->record(KFD_LINE_EN, level);
+}
+bool KfdThreeWireTransport::twiGetData() { return _pins.data >= 0 && digitalRead(_pins.data) != 0; }
+
+// Data is set up, then latched on the rising clock edge, MSB first, with
+// the negotiated half period on each side. Pinless ports skip the delay;
+// an attached emulator is told the rate instead.
+void KfdThreeWireTransport::sendBit(bool bit) {
+  twiSetData(bit);
+  if (_halfUs) delayMicroseconds(_halfUs);
+  twiSetClock(true);
+  if (_halfUs) delayMicroseconds(_halfUs);
+  twiSetClock(false);
+}
+
+void KfdThreeWireTransport::sendByte(uint8_t value) {
+  for (int i = 7; i >= 0; --i) {
+    bool b = (value >> i) & 0x01;
+    sendBit(b);
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Transport
+// -----------------------------------------------------------------------------
+
+// The frame is always clocked out on the line (and into the trace); an
+// attached emulator then receives it as the radio at the far end would.
+void KfdThreeWireTransport::send(const uint8_t* frame, size_t len, uint16_t tag) {
+  _lastTag = tag;
+  for (size_t i = 0; i < len; ++i) sendByte(frame[i]);
+  twiSetData(false);
+
+  if (_emulator) {
+    _emulator->setLineRate(clockRateBps());
+    _emulator->onFrame(frame, len, micros());
+    return;
+  }
+
+  KLOGD(KFD, "sendFrame: %u bytes, opcode %02X", (unsigned)len, len > 3 ? frame[3] : 0);
+}
+
+// Move any emulator response that is due into the receive ring, as the
+// GPIO receiver will once real 3WI receive timing is implemented.
+void KfdThreeWireTransport::pumpEmulator() {
+  uint8_t wire[KFD_FRAME_MAX_PAYLOAD + KFD_FRAME_OVERHEAD];
+  size_t  n = 0;
+  if (!_emulator->takeResponse(wire, sizeof(wire), n, micros())) return;
+  for (size_t i = 0; i < n; ++i) _rxRing.push(wire[i]);
+}
+
+// Drain the receive ring through the frame parser; the CRC is validated as
+// the bytes go by. Non-blocking: a partial frame stays in the parser until
+// the next call. On success the payload is copied to buf.
+KfdTransport::RxStatus KfdThreeWireTransport::receive(uint8_t* buf, size_t maxLen, size_t& outLen,
+                                                      uint16_t& tag) {
+  outLen = 0;
+  tag    = _lastTag;
+  if (_emulator) pumpEmulator();
+
+  uint8_t b;
+  while (_rxRing.pop(b)) {
+    KfdFrameParser::Status st = _rxParser.push(b);
+    if (st == KfdFrameParser::NEED_MORE) continue;
+
+    if (st != KfdFrameParser::FRAME_OK) {
+      discard();
+      KLOGW(KFD, "recvFrame: integrity check failed");
+      return RX_CORRUPT;
+    }
+
+    size_t n = _rxParser.payloadLen();
+    if (n > maxLen) n = maxLen;
+    memcpy(buf, _rxParser.payload(), n);
+    outLen = n;
+    _rxParser.reset();
+    return RX_FRAME;
+  }
+  return RX_NONE;
+}
+
+// -----------------------------------------------------------------------------
+// Byte-level access
+// -----------------------------------------------------------------------------
+
+void KfdThreeWireTransport::writeBytes(const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len; ++i) sendByte(data[i]);
+  twiSetData(false);
+  if (!_emulator) return;
+
+  // Hand each complete frame (or what failed to parse as one) to the
+  // emulator, which runs its own CRC check on it.
+  _emulator->setLineRate(clockRateBps());
+  for (size_t i = 0; i < len; ++i) {
+    if (_txRawLen == 0 && data[i] != KFD_FRAME_SOF) continue;
+    _txRaw[_txRawLen++] = data[i];
+    if (_txParser.push(data[i]) == KfdFrameParser::NEED_MORE && _txRawLen < sizeof(_txRaw)) continue;
+    _emulator->onFrame(_txRaw, _txRawLen, micros());
+    _txParser.reset();
+    _txRawLen = 0;
+  }
+}
+
+bool KfdThreeWireTransport::readByte(uint8_t& b) {
+  if (_emulator) pumpEmulator();
+  return _rxRing.pop(b);
+}
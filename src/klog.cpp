@@ -0,0 +1,165 @@
+#include "klog.h"
+
+#include <Arduino.h>
+#include <atomic>
+#include <string.h>
+
+#include "hex_codec.h"
+
+static_assert((KLOG_RING_ENTRIES & (KLOG_RING_ENTRIES - 1)) == 0,
+              "KLOG_RING_ENTRIES must be a power of two");
+
+// -----------------------------------------------------------------------------
+// Ring
+// -----------------------------------------------------------------------------
+
+// Producers (any task) claim a slot with one fetch_add and publish it by
+// storing seq last; readers copy an entry and re-check seq to detect an
+// overwrite that raced with the copy.
+struct KlogEntry {
+  std::atomic<uint32_t> seq;  // claim index + 1 once complete, 0 while written
+  uint32_t    timeUs;
+  const char* fmt;
+  uint8_t     module;
+  uint8_t     level;
+  uint8_t     argc;
+  uint32_t    args[4];
+};
+
+struct KlogSnapshot {
+  uint32_t    timeUs;
+  const char* fmt;
+  uint8_t     module;
+  uint8_t     level;
+  uint8_t     argc;
+  uint32_t    args[4];
+};
+
+static constexpr uint32_t KLOG_MASK = KLOG_RING_ENTRIES - 1;
+
+static KlogEntry             s_ring[KLOG_RING_ENTRIES];
+static std::atomic<uint32_t> s_head{0};
+static uint32_t              s_tail    = 0;  // klogService() only
+static uint32_t              s_dropped = 0;
+static bool                  s_echo    = true;
+
+static const char* const MODULE_NAMES[KLOG_MOD_COUNT] = { "KFD", "MODEL", "UI", "TOUCH" };
+static const char        LEVEL_CHARS[] = "-EWIDV";
+
+void klogRecord(uint8_t module, uint8_t level, const char* fmt, const uint32_t* args, uint8_t argc) {
+  const uint32_t claim = s_head.fetch_add(1, std::memory_order_relaxed);
+  KlogEntry&     e     = s_ring[claim & KLOG_MASK];
+
+  e.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  e.timeUs = micros();
+  e.fmt    = fmt;
+  e.module = module;
+  e.level  = level;
+  e.argc   = argc;
+  for (uint8_t i = 0; i < argc; ++i) e.args[i] = args[i];
+  e.seq.store(claim + 1, std::memory_order_release);
+}
+
+// Copy entry idx if it is complete and still the one claimed at idx.
+static bool readEntry(uint32_t idx, KlogSnapshot& out) {
+  const KlogEntry& e = s_ring[idx & KLOG_MASK];
+  if (e.seq.load(std::memory_order_acquire) != idx + 1) return false;
+
+  out.timeUs = e.timeUs;
+  out.fmt    = e.fmt;
+  out.module = e.module;
+  out.level  = e.level;
+  out.argc   = e.argc;
+  memcpy(out.args, e.args, sizeof(out.args));
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return e.seq.load(std::memory_order_relaxed) == idx + 1;
+}
+
+// -----------------------------------------------------------------------------
+// Consumers
+// -----------------------------------------------------------------------------
+
+static void printEntry(const KlogSnapshot& s) {
+  char msg[128];
+  snprintf(msg, sizeof(msg), s.fmt, s.args[0], s.args[1], s.args[2], s.args[3]);
+
+  const char* mod = s.module < KLOG_MOD_COUNT ? MODULE_NAMES[s.module] : "?";
+  const char  lvl = s.level <= KLOG_VERBOSE ? LEVEL_CHARS[s.level] : '?';
+  Serial.printf("%u.%06u %c [%s] %s\n",
+                (unsigned)(s.timeUs / 1000000u), (unsigned)(s.timeUs % 1000000u), lvl, mod, msg);
+}
+
+bool klogService(size_t maxEntries) {
+  const uint32_t head = s_head.load(std::memory_order_acquire);
+  if (head - s_tail > KLOG_RING_ENTRIES) {
+    s_dropped += head - s_tail - KLOG_RING_ENTRIES;
+    s_tail     = head - KLOG_RING_ENTRIES;
+  }
+
+  for (size_t n = 0; n < maxEntries && s_tail != head; ++n) {
+    KlogSnapshot s;
+    if (!readEntry(s_tail, s)) {
+      // Still being written: try again next call. Overwritten: lost.
+      const uint32_t seq = s_ring[s_tail & KLOG_MASK].seq.load(std::memory_order_acquire);
+      if (seq == 0 || seq <= s_tail) break;
+      s_dropped++;
+      s_tail++;
+      continue;
+    }
+    s_tail++;
+    if (s_echo) printEntry(s);
+  }
+  return s_tail != head;
+}
+
+void klogSetEcho(bool on) { s_echo = on; }
+
+uint32_t klogDropped() { return s_dropped; }
+
+// Dump layout, one record per line, binary fields hex-encoded:
+//   KLOG BEGIN <entries> <dropped>
+//   KLOGS <fmt address> <fmt text>           once per distinct format
+//   KLOGE <28 bytes: timeUs, fmt address, module, level, argc, pad, args[4]>
+//   KLOG END
+// Multi-byte fields are little-endian (native on the ESP32).
+void klogDump() {
+  static const char* fmts[KLOG_RING_ENTRIES];
+  size_t             fmtCount = 0;
+
+  const uint32_t head  = s_head.load(std::memory_order_acquire);
+  const uint32_t first = head > KLOG_RING_ENTRIES ? head - KLOG_RING_ENTRIES : 0;
+
+  Serial.printf("KLOG BEGIN %u %u\n", (unsigned)(head - first), (unsigned)s_dropped);
+
+  char hex[2 * 128 + 1];
+  for (uint32_t i = first; i != head; ++i) {
+    KlogSnapshot s;
+    if (!readEntry(i, s)) continue;
+
+    bool known = false;
+    for (size_t k = 0; k < fmtCount && !known; ++k) known = fmts[k] == s.fmt;
+    if (!known) {
+      fmts[fmtCount++] = s.fmt;
+      size_t len = strlen(s.fmt);
+      if (len > 127) len = 127;
+      hexEncode((const uint8_t*)s.fmt, len, hex, sizeof(hex));
+      Serial.printf("KLOGS %08X %s\n", (unsigned)(uintptr_t)s.fmt, hex);
+    }
+
+    uint8_t        rec[28];
+    const uint32_t fmtAddr = (uint32_t)(uintptr_t)s.fmt;
+    memcpy(rec + 0, &s.timeUs, 4);
+    memcpy(rec + 4, &fmtAddr, 4);
+    rec[8]  = s.module;
+    rec[9]  = s.level;
+    rec[10] = s.argc;
+    rec[11] = 0;
+    memcpy(rec + 12, s.args, 16);
+    hexEncode(rec, sizeof(rec), hex, sizeof(hex));
+    Serial.printf("KLOGE %s\n", hex);
+  }
+
+  Serial.println("KLOG END");
+}
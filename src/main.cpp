@@ -1,15 +1,64 @@
 #include <Arduino.h>
+#include <driver/gpio.h>
+#include <esp_heap_caps.h>
+#include <esp_idf_version.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
 #include "container_model.h"
+#include "container_search.h"
+#include "kfd_scheduler.h"
+#include "kfd_task.h"
+#include "klog.h"
 
 #define LGFX_USE_V1
 #include <LovyanGFX.hpp>
 #include <lvgl.h>
 #include "ui.h"
 
+#ifndef KFD_BENCH_ON_BOOT
+#define KFD_BENCH_ON_BOOT 0
+#endif
+
+// DLI keyloading needs the network interface up; the DLI bench only runs
+// when the build brings it up (-DKFD_USE_DLI=1).
+#ifndef KFD_USE_DLI
+#define KFD_USE_DLI 0
+#endif
+
+// KFDtool adapter mode (-DKFD_ADAPTER_MODE=1): the USB port speaks the
+// KFDtool adapter protocol instead of the text console, and port 1's line
+// belongs to the host application. On-device keyloading is off and klog
+// echo is off; nothing that runs in this mode may write text to Serial
+// directly (the model's load/autosave messages go through klog).
+#ifndef KFD_ADAPTER_MODE
+#define KFD_ADAPTER_MODE 0
+#endif
+
+#if KFD_BENCH_ON_BOOT
+#include "kfd_bench.h"
+#endif
+
+#if KFD_ADAPTER_MODE
+#include "kfd_adapter.h"
+static KfdThreeWireTransport adapter_line(KFD_DEFAULT_PINS);
+static KfdToolAdapter        adapter(Serial, adapter_line);
+
+// Serviced on the line's core in place of the protocol task: the host
+// waits for each response, so the UI loop's delays must stay out of the
+// round trip. Idles a tick only when nothing moved.
+static void adapter_task(void*) {
+  for (;;) {
+    if (!adapter.service()) vTaskDelay(1);
+  }
+}
+#endif
+
 // ------------------------------------------------------------------
 // LovyanGFX config for WT32-SC01-PLUS (ESP32-S3, 8-bit parallel ST7796)
 // ------------------------------------------------------------------
 
+// FT6336U interrupt output: TOUCH_PIN_INT (kfd_three_wire.h).
+
 class LGFX : public lgfx::LGFX_Device {
 public:
   lgfx::Panel_ST7796   _panel_instance;   // ST7796U
@@ -94,7 +143,9 @@ public:
       cfg.y_min          = 0;
       cfg.y_max          = 479;
 
-      cfg.pin_int        = -1;     // we poll I2C
+      // INT is handled by touch_isr(), not LovyanGFX: its pin test would
+      // skip the read once the controller's short pulse has ended.
+      cfg.pin_int        = -1;
       cfg.bus_shared     = false;  // separate I2C bus
       cfg.offset_rotation = 0;
 
@@ -118,12 +169,90 @@ static LGFX lcd;
 // LVGL glue
 // ------------------------------------------------------------------
 
+// Draw buffer strategies, switchable at runtime ("disp mode ..."):
+//   partial  two 40-line bands in internal DMA RAM; LVGL renders one while
+//            the other is on the 8080 bus
+//   full     one full frame in PSRAM with full_refresh: one flush per
+//            frame, every pixel redrawn
+//   direct   one full frame in PSRAM with direct_mode: LVGL redraws only
+//            the dirty areas, which are then copied to the panel
+// The boot mode is DISP_MODE_DEFAULT (-DDISP_MODE_DEFAULT=n).
+enum DispMode : uint8_t { DISP_PARTIAL = 0, DISP_FULL, DISP_DIRECT, DISP_MODE_COUNT };
+static const char* const DISP_MODE_NAMES[DISP_MODE_COUNT] = { "partial", "full", "direct" };
+
+#ifndef DISP_MODE_DEFAULT
+#define DISP_MODE_DEFAULT DISP_PARTIAL
+#endif
+
+static constexpr int32_t DISP_W      = 320;
+static constexpr int32_t DISP_H      = 480;
+static constexpr size_t  DRAW_BUF_PX = DISP_W * 40;
+static constexpr size_t  FRAME_PX    = DISP_W * DISP_H;
+
+static lv_disp_drv_t      disp_drv;
+static lv_disp_t*         display   = nullptr;
 static lv_disp_draw_buf_t draw_buf;
-static lv_color_t         lv_buf1[320 * 40];
+static DispMode           disp_mode = DISP_PARTIAL;
+static lv_color_t*        lv_buf1   = nullptr;  // bands or frames, per disp_mode
+static lv_color_t*        lv_buf2   = nullptr;
+
+// Band whose DMA transfer is in flight (nullptr when the bus is idle).
+static lv_disp_drv_t* flush_pending = nullptr;
+
+// Flush timing since boot or the last "disp stats". Bus time is estimated
+// from the DMA rate measured at boot; the part of it LVGL did not spend
+// stalled waiting for a buffer overlapped with rendering.
+struct DispStats {
+  uint32_t frames;    // refresh cycles that drew something
+  uint32_t flushes;   // bands sent
+  uint64_t pixels;
+  uint64_t refreshUs; // lv_timer_handler() passes that drew a frame
+  uint64_t stallUs;   // LVGL blocked on a transfer in lvgl_wait_cb()
+};
+static DispStats disp_stats;
+static float     disp_ns_per_px = 0;
+static bool      disp_frame_drawn = false;
+
+// LovyanGFX has no transfer-complete interrupt hook; completion is polled
+// here from LVGL's wait callback and once per loop pass.
+static void disp_poll_flush() {
+  if (!flush_pending || lcd.dmaBusy()) return;
+  lcd.endWrite();
+  lv_disp_drv_t* disp = flush_pending;
+  flush_pending = nullptr;
+  lv_disp_flush_ready(disp);
+}
+
+// direct_mode: the frame holds the whole screen at absolute coordinates.
+// On the last flush of a refresh, copy out just the areas LVGL redrew.
+static void disp_flush_direct(lv_disp_drv_t* drv, lv_color_t* frame) {
+  if (lv_disp_flush_is_last(drv)) {
+    const lv_disp_t* d = _lv_refr_get_disp_refreshing();
+    lcd.startWrite();
+    for (uint16_t i = 0; i < d->inv_p; ++i) {
+      if (d->inv_area_joined[i]) continue;
+      const lv_area_t& a = d->inv_areas[i];
+      const int32_t    w = a.x2 - a.x1 + 1;
+      lcd.setAddrWindow(a.x1, a.y1, w, a.y2 - a.y1 + 1);
+      for (int32_t y = a.y1; y <= a.y2; ++y) {
+        lcd.pushPixels((lgfx::swap565_t*)&frame[y * DISP_W + a.x1].full, w);
+      }
+      disp_stats.flushes++;
+      disp_stats.pixels += (uint32_t)(w * (a.y2 - a.y1 + 1));
+    }
+    lcd.endWrite();
+  }
+  lv_disp_flush_ready(drv);
+}
 
 static void lvgl_flush_cb(lv_disp_drv_t* disp,
                           const lv_area_t* area,
                           lv_color_t* color_p) {
+  if (disp_mode == DISP_DIRECT) {
+    disp_flush_direct(disp, color_p);
+    return;
+  }
+
   int32_t x1 = area->x1;
   int32_t y1 = area->y1;
   int32_t w  = area->x2 - area->x1 + 1;
@@ -134,68 +263,727 @@ static void lvgl_flush_cb(lv_disp_drv_t* disp,
     return;
   }
 
+  disp_stats.flushes++;
+  disp_stats.pixels += (uint32_t)(w * h);
+
   lcd.startWrite();
   lcd.setAddrWindow(x1, y1, w, h);
 
-  // LV_COLOR_DEPTH must be 16 for this direct cast to be valid.
-  lcd.pushPixels((lgfx::rgb565_t*)&color_p->full, w * h);
-
+  // LV_COLOR_DEPTH 16 with LV_COLOR_16_SWAP: the buffer is already in
+  // panel byte order. Bands in internal RAM go to the bus by DMA in place
+  // and this returns at once; PSRAM frames are not DMA-safe without cache
+  // maintenance, so LovyanGFX streams them through its own buffer.
+  if (disp_mode == DISP_PARTIAL) {
+    lcd.pushPixelsDMA((lgfx::swap565_t*)&color_p->full, w * h);
+    flush_pending = disp;
+    return;
+  }
+  lcd.pushPixels((lgfx::swap565_t*)&color_p->full, w * h);
   lcd.endWrite();
   lv_disp_flush_ready(disp);
-  
 }
 
-static bool    last_pressed = false;
+// LVGL needs the band on the bus back before it can render further.
+static void lvgl_wait_cb(lv_disp_drv_t* disp) {
+  (void)disp;
+  const uint32_t t0 = micros();
+  while (flush_pending && lcd.dmaBusy()) {
+  }
+  disp_poll_flush();
+  disp_stats.stallUs += micros() - t0;
+}
+
+static void lvgl_monitor_cb(lv_disp_drv_t* disp, uint32_t time_ms, uint32_t px) {
+  (void)disp;
+  (void)time_ms;
+  (void)px;
+  disp_frame_drawn = true;
+}
+
+// One band over DMA, timed, for the bus estimate in the stats. Runs
+// before LVGL draws anything; the band is cleared to black.
+static void disp_measure_bus() {
+  lv_color_t* band = (lv_color_t*)heap_caps_calloc(DRAW_BUF_PX, sizeof(lv_color_t),
+                                                   MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+  if (!band) return;
+  lcd.startWrite();
+  lcd.setAddrWindow(0, 0, DISP_W, DRAW_BUF_PX / DISP_W);
+  const uint32_t t0 = micros();
+  lcd.pushPixelsDMA((lgfx::swap565_t*)band, DRAW_BUF_PX);
+  lcd.waitDMA();
+  const uint32_t us = micros() - t0;
+  lcd.endWrite();
+  heap_caps_free(band);
+  disp_ns_per_px = us * 1000.0f / DRAW_BUF_PX;
+}
+
+// Allocate the buffers of mode m and point draw_buf and disp_drv at them.
+// The new buffers are taken before the old ones are released, so a
+// failure leaves the current mode intact.
+static bool disp_apply_mode(DispMode m) {
+  const bool     frame = m != DISP_PARTIAL;
+  const size_t   px    = frame ? FRAME_PX : DRAW_BUF_PX;
+  const uint32_t caps  = frame ? MALLOC_CAP_SPIRAM : (MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+
+  // The frames are pushed synchronously, so a second one would never be
+  // rendered into while the first is on the bus.
+  lv_color_t* b1 = (lv_color_t*)heap_caps_malloc(px * sizeof(lv_color_t), caps);
+  lv_color_t* b2 = frame ? nullptr : (lv_color_t*)heap_caps_malloc(px * sizeof(lv_color_t), caps);
+  if (!b1 || (!frame && !b2)) {
+    heap_caps_free(b1);
+    heap_caps_free(b2);
+    KLOGW(UI, "disp: no memory for mode %d", (int)m);
+    return false;
+  }
+  heap_caps_free(lv_buf1);
+  heap_caps_free(lv_buf2);
+  lv_buf1 = b1;
+  lv_buf2 = b2;
+
+  lv_disp_draw_buf_init(&draw_buf, b1, b2, px);
+  disp_drv.full_refresh = m == DISP_FULL;
+  disp_drv.direct_mode  = m == DISP_DIRECT;
+  disp_mode = m;
+  return true;
+}
+
+// Switch strategies at runtime; the active screen is redrawn in full.
+static bool disp_set_mode(DispMode m) {
+  if (m == disp_mode) return true;
+  while (flush_pending) lvgl_wait_cb(&disp_drv);  // the band in flight is about to be freed
+  if (!disp_apply_mode(m)) return false;
+  lv_disp_drv_update(display, &disp_drv);
+  lv_obj_invalidate(lv_scr_act());
+  return true;
+}
+
+static void disp_print_stats() {
+  const DispStats& s = disp_stats;
+  const uint32_t busUs   = (uint32_t)(s.pixels * disp_ns_per_px / 1000.0f);
+  const uint32_t stallUs = (uint32_t)s.stallUs;
+  const uint32_t hidden  = busUs > stallUs ? busUs - stallUs : 0;
+
+  Serial.printf("disp: %s, %u frames, %u flushes, refresh avg %u us\n",
+                DISP_MODE_NAMES[disp_mode], (unsigned)s.frames, (unsigned)s.flushes,
+                s.frames ? (unsigned)(s.refreshUs / s.frames) : 0u);
+  Serial.printf("  bus %u us (%.1f ns/px), stalled %u us, overlapped %u us (%u%%)\n",
+                (unsigned)busUs, disp_ns_per_px, (unsigned)stallUs, (unsigned)hidden,
+                busUs ? (unsigned)(hidden * 100ull / busUs) : 0u);
+  memset(&disp_stats, 0, sizeof(disp_stats));
+}
+
+// ------------------------------------------------------------------
+// Touch: the FT6336U is read only when its INT line fires. A reader task
+// does the I2C transfer and queues the sample; LVGL's read callback
+// drains the queue. The controller pulses INT once per report while a
+// finger is down; a lift is caught by one read after the pulses stop.
+// ------------------------------------------------------------------
+
+struct TouchSample {
+  int16_t x;
+  int16_t y;
+  bool    pressed;
+};
+
+static constexpr size_t   TOUCH_QUEUE_LEN  = 8;
+static constexpr uint32_t TOUCH_RELEASE_MS = 30;  // no pulse for this long: re-read
+
+static QueueHandle_t touch_queue       = nullptr;
+static TaskHandle_t  touch_task_handle = nullptr;
+static TaskHandle_t  loop_task_handle  = nullptr;  // woken for every queued sample
+static lv_indev_t*   touch_indev       = nullptr;
+static lv_timer_t*   touch_read_timer  = nullptr;
+static uint32_t      touch_reads       = 0;
+static uint32_t      touch_dropped     = 0;
+
+// Set while the display is blanked: INT is then level-triggered to wake
+// the chip from light sleep (see disp_blank()), and the first edge also
+// wakes the loop.
+static volatile bool touch_wake_armed = false;
+
+static void IRAM_ATTR touch_isr() {
+  BaseType_t woken = pdFALSE;
+  if (touch_wake_armed) {
+    gpio_intr_disable((gpio_num_t)TOUCH_PIN_INT);  // level-triggered: once is enough
+    touch_wake_armed = false;
+    vTaskNotifyGiveFromISR(loop_task_handle, &woken);
+  }
+  vTaskNotifyGiveFromISR(touch_task_handle, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+static void touch_push(const TouchSample& s) {
+  // Full queue: drop the oldest, so the latest state (a lift above all)
+  // always gets through.
+  if (xQueueSend(touch_queue, &s, 0) != pdTRUE) {
+    TouchSample old;
+    xQueueReceive(touch_queue, &old, 0);
+    xQueueSend(touch_queue, &s, 0);
+    touch_dropped++;
+  }
+  if (loop_task_handle) xTaskNotifyGive(loop_task_handle);
+}
+
+static void touch_task(void*) {
+  bool down = false;
+  for (;;) {
+    // Idle until INT; while a finger is down, also wake to see the lift.
+    const TickType_t wait = down ? pdMS_TO_TICKS(TOUCH_RELEASE_MS) : portMAX_DELAY;
+    const bool pulsed = ulTaskNotifyTake(pdTRUE, wait) != 0;
+    if (!pulsed && !down) continue;
+
+    uint16_t    x, y;
+    TouchSample s;
+    s.pressed = lcd.getTouch(&x, &y) > 0;
+    s.x       = (int16_t)x;
+    s.y       = (int16_t)y;
+    touch_reads++;
+    if (!s.pressed && !down) continue;  // pulse with no contact
+    down = s.pressed;
+    touch_push(s);
+  }
+}
+
+static void setup_touch() {
+  touch_queue = xQueueCreate(TOUCH_QUEUE_LEN, sizeof(TouchSample));
+  xTaskCreatePinnedToCore(touch_task, "touch", 3072, nullptr, 2, &touch_task_handle,
+                          xPortGetCoreID());
+  pinMode(TOUCH_PIN_INT, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(TOUCH_PIN_INT), touch_isr, FALLING);
+}
+
+// New samples: make LVGL's read timer due, so they are processed in the
+// very next lv_timer_handler(). The timer is paused while released (see
+// disp_governor()).
+static void touch_kick() {
+  if (!touch_read_timer || uxQueueMessagesWaiting(touch_queue) == 0) return;
+  lv_timer_resume(touch_read_timer);
+  lv_timer_ready(touch_read_timer);
+}
+
+static bool    last_pressed  = false;
+static bool    touch_swallow = false;  // the touch that unblanked the display
 static int16_t last_x = 0;
 static int16_t last_y = 0;
 
 static void lvgl_touch_read(lv_indev_drv_t* indev_drv, lv_indev_data_t* data) {
   (void)indev_drv;
 
-  uint16_t x, y;
-  bool pressed = lcd.getTouch(&x, &y);
-
-  if (pressed) {
-    int16_t tx = x;
-    int16_t ty = y;
-
-    data->state   = LV_INDEV_STATE_PRESSED;
-    data->point.x = tx;
-    data->point.y = ty;
-
-    if (!last_pressed || tx != last_x || ty != last_y) {
-      Serial.printf("LVGL touch DOWN: (%d, %d)\n", tx, ty);
-      last_x = tx;
-      last_y = ty;
-      last_pressed = true;
+  // No new sample: the contact (or its absence) is unchanged.
+  TouchSample s;
+  if (xQueueReceive(touch_queue, &s, 0) == pdTRUE) {
+    if (touch_swallow) {
+      touch_swallow = s.pressed;
+      s.pressed     = false;
     }
-  } else {
-    if (last_pressed) {
-      Serial.println("LVGL touch UP");
+    if (s.pressed && (!last_pressed || s.x != last_x || s.y != last_y)) {
+      KLOGV(TOUCH, "touch DOWN: (%d, %d)", s.x, s.y);
+      last_x = s.x;
+      last_y = s.y;
+    } else if (!s.pressed && last_pressed) {
+      KLOGV(TOUCH, "touch UP");
     }
-    data->state = LV_INDEV_STATE_RELEASED;
-    last_pressed = false;
+    last_pressed = s.pressed;
+    data->continue_reading = uxQueueMessagesWaiting(touch_queue) > 0;
   }
+
+  data->state   = last_pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+  data->point.x = last_x;
+  data->point.y = last_y;
 }
 
 static void setup_lvgl() {
   lv_init();
 
-  lv_disp_draw_buf_init(&draw_buf, lv_buf1, nullptr, 320 * 40);
+  disp_measure_bus();
 
-  static lv_disp_drv_t disp_drv;
   lv_disp_drv_init(&disp_drv);
-  disp_drv.hor_res  = 320;
-  disp_drv.ver_res  = 480;
-  disp_drv.flush_cb = lvgl_flush_cb;
-  disp_drv.draw_buf = &draw_buf;
-  lv_disp_drv_register(&disp_drv);
+  disp_drv.hor_res    = DISP_W;
+  disp_drv.ver_res    = DISP_H;
+  disp_drv.flush_cb   = lvgl_flush_cb;
+  disp_drv.wait_cb    = lvgl_wait_cb;
+  disp_drv.monitor_cb = lvgl_monitor_cb;
+  disp_drv.draw_buf   = &draw_buf;
+  if (!disp_apply_mode((DispMode)DISP_MODE_DEFAULT)) disp_apply_mode(DISP_PARTIAL);
+  display = lv_disp_drv_register(&disp_drv);
 
   static lv_indev_drv_t indev_drv;
   lv_indev_drv_init(&indev_drv);
   indev_drv.type    = LV_INDEV_TYPE_POINTER;
   indev_drv.read_cb = lvgl_touch_read;
-  lv_indev_drv_register(&indev_drv);
+  touch_indev      = lv_indev_drv_register(&indev_drv);
+  touch_read_timer = indev_drv.read_timer;
+}
+
+// ------------------------------------------------------------------
+// Display buffer benchmark ("disp bench")
+// ------------------------------------------------------------------
+
+// A list screen shaped like the containers screen.
+static lv_obj_t* disp_bench_screen(unsigned seed, lv_obj_t** list) {
+  lv_obj_t* scr   = lv_obj_create(NULL);
+  lv_obj_t* title = lv_label_create(scr);
+  lv_label_set_text_fmt(title, "BUFFER BENCH %u", seed);
+  lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 10);
+
+  *list = lv_list_create(scr);
+  lv_obj_set_size(*list, DISP_W, DISP_H - 40);
+  lv_obj_align(*list, LV_ALIGN_BOTTOM_MID, 0, 0);
+  for (unsigned i = 0; i < 40; ++i) {
+    char text[24];
+    snprintf(text, sizeof(text), "CONTAINER %02u-%u", i + 1, seed);
+    lv_list_add_btn(*list, LV_SYMBOL_EDIT, text);
+  }
+  return scr;
+}
+
+// For each strategy: screen switch (build, load, draw, drop the old
+// screen, as every ui.cpp navigation does), list scroll rate with a redraw
+// per 12 px step, and free internal / PSRAM heap with its buffers in place.
+static void disp_run_bench() {
+  static constexpr unsigned SWITCHES     = 10;
+  static constexpr unsigned SCROLL_STEPS = 60;
+
+  lv_obj_t* const ui_scr  = lv_scr_act();
+  const DispMode  ui_mode = disp_mode;
+
+  Serial.println("disp bench:       switch   scroll  internal free  psram free");
+  for (uint8_t m = 0; m < DISP_MODE_COUNT; ++m) {
+    if (!disp_set_mode((DispMode)m)) {
+      Serial.printf("  %-8s no memory\n", DISP_MODE_NAMES[m]);
+      continue;
+    }
+    lv_refr_now(NULL);
+
+    lv_obj_t* list = nullptr;
+    uint32_t  t0   = micros();
+    for (unsigned i = 0; i < SWITCHES; ++i) {
+      lv_obj_t* prev = lv_scr_act();
+      lv_scr_load(disp_bench_screen(i, &list));
+      lv_refr_now(NULL);
+      if (prev != ui_scr) lv_obj_del(prev);
+    }
+    const uint32_t switchUs = (micros() - t0) / SWITCHES;
+
+    t0 = micros();
+    for (unsigned i = 0; i < SCROLL_STEPS; ++i) {
+      lv_obj_scroll_by(list, 0, (i / 20) % 2 ? 12 : -12, LV_ANIM_OFF);
+      lv_refr_now(NULL);
+    }
+    const uint32_t scrollUs = micros() - t0;
+
+    Serial.printf("  %-8s %8.1f ms %5.1f fps %10u KB %9u KB\n", DISP_MODE_NAMES[m],
+                  switchUs / 1000.0f, scrollUs ? SCROLL_STEPS * 1e6f / scrollUs : 0.0f,
+                  (unsigned)(heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024),
+                  (unsigned)(heap_caps_get_free_size(MALLOC_CAP_SPIRAM) / 1024));
+  }
+
+  lv_obj_t* last = lv_scr_act();
+  lv_scr_load(ui_scr);
+  if (last != ui_scr) lv_obj_del(last);
+  disp_set_mode(ui_mode);
+}
+
+// ------------------------------------------------------------------
+// Keyload benchmark (emulated radio, -DKFD_BENCH_ON_BOOT=1)
+// ------------------------------------------------------------------
+
+#if KFD_BENCH_ON_BOOT
+static void run_keyload_bench() {
+  kfdRunFrameBench(2000);
+  kfdRunHexBench(2000);
+
+  const KeyContainer kc = kfdBenchContainer(150, 0x1234);
+  KfdBenchResult r;
+
+  KfdEmulatorConfig clean;
+  if (kfdRunBench(kc, clean, 20, 3, r)) kfdPrintBench("clean", r);
+
+  KfdEmulatorConfig jitter;
+  jitter.latencyJitterUs = 800;
+  if (kfdRunBench(kc, jitter, 20, 3, r)) kfdPrintBench("jitter", r);
+
+  KfdEmulatorConfig naks;
+  naks.nakPerMille = 5;
+  if (kfdRunBench(kc, naks, 20, 3, r)) kfdPrintBench("nak-0.5%", r);
+
+  KfdEmulatorConfig noisy;
+  noisy.bitErrorsPerMillion = 20;
+  if (kfdRunBench(kc, noisy, 20, 3, r)) kfdPrintBench("ber-2e-5", r);
+
+  KfdEmulatorConfig slow;
+  slow.responseLatencyUs = 2000;
+  kfdPrintParallelBench(kc, 1, kfdRunParallelBench(kc, slow, 1));
+  kfdPrintParallelBench(kc, KFD_MAX_PORTS, kfdRunParallelBench(kc, slow, KFD_MAX_PORTS));
+
+  kfdRunDeltaBench(kfdBenchContainer(40, 0x77), slow, 3);
+  kfdRunClockBench(kfdBenchContainer(40, 0x99));
+#if KFD_USE_DLI
+  kfdRunDliBench(kfdBenchContainer(40, 0x3C), 2000, 20);
+#endif
+  kfdRunTraceBench(kfdBenchContainer(20, 0x55), 20);
+}
+#endif
+
+// ------------------------------------------------------------------
+// Refresh governor: LVGL's refresh and input-read periods follow what
+// the screen is doing instead of the fixed lv_conf.h values.
+//   fast    finger down, scroll or throw in progress, animation running
+//   normal  up to GOV_HOLD_MS after that (the lv_conf.h periods)
+//   idle    after GOV_IDLE_MS more; slow refresh for background updates
+// Outside fast, the read timer is paused once the finger is up and the
+// throw has settled (touch_kick() restarts it), and the refresh timer is
+// parked while nothing is invalid (LVGL resumes it on invalidation).
+// ------------------------------------------------------------------
+
+enum GovLevel : uint8_t { GOV_IDLE = 0, GOV_NORMAL, GOV_FAST, GOV_LEVEL_COUNT };
+static const char* const GOV_LEVEL_NAMES[GOV_LEVEL_COUNT] = { "idle", "normal", "fast" };
+
+static constexpr uint32_t GOV_REFR_MS[GOV_LEVEL_COUNT] = { 100, LV_DISP_DEF_REFR_PERIOD, 16 };
+static constexpr uint32_t GOV_READ_MS[GOV_LEVEL_COUNT] = { 100, LV_INDEV_DEF_READ_PERIOD, 10 };
+static constexpr uint32_t GOV_HOLD_MS = 500;
+static constexpr uint32_t GOV_IDLE_MS = 2000;
+
+// Timer runs since boot or the last "gov stats". A run of the refresh
+// timer with nothing invalid is pure overhead; its measured cost prices
+// the runs the fixed lv_conf.h periods would have made on top of ours.
+struct GovStats {
+  uint32_t levelMs[GOV_LEVEL_COUNT];
+  uint32_t refrRuns;
+  uint32_t refrEmptyRuns;
+  uint64_t refrEmptyUs;
+  uint32_t readRuns;
+  uint64_t readUs;
+};
+static GovStats gov_stats;
+static uint32_t gov_stats_since_ms = 0;
+static GovLevel gov_level          = GOV_NORMAL;
+static uint32_t gov_active_ms      = 0;  // last time the screen was in motion
+static uint32_t gov_level_since_ms = 0;
+
+static void gov_refr_timer_cb(lv_timer_t* t) {
+  const bool     empty = display->inv_p == 0;
+  const uint32_t t0    = micros();
+  _lv_disp_refr_timer(t);
+  const uint32_t us = micros() - t0;
+  gov_stats.refrRuns++;
+  if (empty) {
+    gov_stats.refrEmptyRuns++;
+    gov_stats.refrEmptyUs += us;
+  }
+}
+
+static void gov_read_timer_cb(lv_timer_t* t) {
+  const uint32_t t0 = micros();
+  lv_indev_read_timer_cb(t);
+  gov_stats.readRuns++;
+  gov_stats.readUs += micros() - t0;
+}
+
+static bool gov_set_level(GovLevel l, uint32_t now) {
+  gov_stats.levelMs[gov_level] += now - gov_level_since_ms;
+  gov_level_since_ms = now;
+  if (l == gov_level) return false;
+  gov_level = l;
+  lv_timer_set_period(display->refr_timer, GOV_REFR_MS[l]);
+  lv_timer_set_period(touch_read_timer, GOV_READ_MS[l]);
+  KLOGD(UI, "gov: level %d", (int)l);
+  return true;
+}
+
+// Take over LVGL's two periodic timers; call after setup_lvgl().
+static void gov_begin() {
+  lv_timer_set_cb(display->refr_timer, gov_refr_timer_cb);
+  lv_timer_set_cb(touch_read_timer, gov_read_timer_cb);
+  gov_active_ms = gov_level_since_ms = gov_stats_since_ms = millis();
+}
+
+// Once per loop pass, after the pass's LVGL work. Returns true if the
+// timers changed, i.e. lv_timer_handler()'s idle estimate is stale.
+static bool disp_governor() {
+  const uint32_t now     = millis();
+  const bool     touched = last_pressed || uxQueueMessagesWaiting(touch_queue) > 0;
+  const bool     moving  = touched || lv_indev_get_scroll_obj(touch_indev) != nullptr ||
+                       lv_anim_count_running() > 0;
+
+  if (moving) gov_active_ms = now;
+  const uint32_t quiet   = now - gov_active_ms;
+  const bool     changed = gov_set_level(moving                            ? GOV_FAST
+                                         : quiet < GOV_HOLD_MS + GOV_IDLE_MS ? GOV_NORMAL
+                                                                             : GOV_IDLE,
+                                         now);
+
+  if (moving) {
+    const bool paused = touch_read_timer->paused;
+    lv_timer_resume(touch_read_timer);
+    return changed || paused;
+  }
+  lv_timer_pause(touch_read_timer);
+  if (!flush_pending && display->inv_p == 0) lv_timer_pause(display->refr_timer);
+  return changed;
+}
+
+static void gov_print_stats() {
+  const GovStats& s       = gov_stats;
+  const uint32_t  now     = millis();
+  const uint32_t  elapsed = now - gov_stats_since_ms;
+  gov_set_level(gov_level, now);  // close the current level's interval
+
+  const uint32_t fixedRefr = elapsed / LV_DISP_DEF_REFR_PERIOD;
+  const uint32_t fixedRead = elapsed / LV_INDEV_DEF_READ_PERIOD;
+  const uint32_t emptyUs   = s.refrEmptyRuns ? (uint32_t)(s.refrEmptyUs / s.refrEmptyRuns) : 0;
+  const uint32_t readUs    = s.readRuns ? (uint32_t)(s.readUs / s.readRuns) : 0;
+  const uint64_t savedUs   = (uint64_t)(fixedRefr > s.refrRuns ? fixedRefr - s.refrRuns : 0) * emptyUs +
+                           (uint64_t)(fixedRead > s.readRuns ? fixedRead - s.readRuns : 0) * readUs;
+
+  Serial.printf("gov: %s now; fast %u ms, normal %u ms, idle %u ms\n", GOV_LEVEL_NAMES[gov_level],
+                (unsigned)s.levelMs[GOV_FAST], (unsigned)s.levelMs[GOV_NORMAL],
+                (unsigned)s.levelMs[GOV_IDLE]);
+  Serial.printf("  refresh runs %u (fixed %u ms: %u), %u empty at %u us\n", (unsigned)s.refrRuns,
+                (unsigned)LV_DISP_DEF_REFR_PERIOD, (unsigned)fixedRefr, (unsigned)s.refrEmptyRuns,
+                (unsigned)emptyUs);
+  Serial.printf("  input reads %u (fixed %u ms: %u) at %u us\n", (unsigned)s.readRuns,
+                (unsigned)LV_INDEV_DEF_READ_PERIOD, (unsigned)fixedRead, (unsigned)readUs);
+  Serial.printf("  CPU saved ~%u us in %u ms (%u.%u%%)\n", (unsigned)savedUs, (unsigned)elapsed,
+                elapsed ? (unsigned)(savedUs / 10 / elapsed) : 0u,
+                elapsed ? (unsigned)(savedUs / elapsed % 10) : 0u);
+  memset(&gov_stats, 0, sizeof(gov_stats));
+  gov_stats_since_ms = now;
+}
+
+// ------------------------------------------------------------------
+// Main loop scheduling and power
+//
+// Each loop() pass does its work, then blocks on the loop task's
+// notification until the earliest deadline: LVGL's next timer, the next
+// autosave attempt, the display blank timeout, or the console poll.
+// Touch samples and protocol events notify the task and end the wait at
+// once. With the display blanked the PM locks are released, so a build
+// with tickless idle (CONFIG_FREERTOS_USE_TICKLESS_IDLE) light-sleeps in
+// the wait; the touch INT line wakes it.
+// ------------------------------------------------------------------
+
+// Inactivity before the backlight and panel are switched off; 0 keeps
+// the display on. Not while a keyload runs, nor in adapter mode.
+#ifndef DISP_BLANK_MS
+#define DISP_BLANK_MS 120000
+#endif
+
+static constexpr uint8_t  DISP_BRIGHTNESS = 200;
+static constexpr uint32_t CONSOLE_POLL_MS = 50;  // USB RX has no wake hook here
+
+// Pass timing since boot or the last "loop stats", log2 buckets:
+// bucket i counts [2^i, 2^(i+1)) us, the last one is open-ended.
+static constexpr size_t LOOP_HIST_BUCKETS = 22;
+
+struct LoopStats {
+  uint32_t passes;
+  uint32_t wokenEarly;  // wait ended by a notification before its deadline
+  uint64_t busyUs;
+  uint64_t waitUs;
+  uint32_t busy[LOOP_HIST_BUCKETS];
+  uint32_t wait[LOOP_HIST_BUCKETS];
+};
+static LoopStats loop_stats;
+static uint32_t  loop_stats_since_ms = 0;
+
+static bool disp_blanked = false;
+
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t pm_cpu_lock   = nullptr;  // CPU/APB at max: LCD bus, I2C, LEDC
+static esp_pm_lock_handle_t pm_awake_lock = nullptr;  // no light sleep
+#endif
+
+static void loop_hist_add(uint32_t* h, uint32_t us) {
+  size_t b = 0;
+  while (us > 1 && b < LOOP_HIST_BUCKETS - 1) {
+    us >>= 1;
+    ++b;
+  }
+  h[b]++;
+}
+
+static void loop_hist_print(const char* name, const uint32_t* h) {
+  Serial.printf("  %-5s", name);
+  for (size_t b = 0; b < LOOP_HIST_BUCKETS; ++b) {
+    if (!h[b]) continue;
+    const uint32_t lo = 1u << b;
+    if (lo < 1000) Serial.printf(" %uus:%u", (unsigned)lo, (unsigned)h[b]);
+    else Serial.printf(" %ums:%u", (unsigned)(lo / 1000), (unsigned)h[b]);
+  }
+  Serial.println();
+}
+
+static void loop_print_stats() {
+  const LoopStats& s       = loop_stats;
+  const uint32_t   elapsed = millis() - loop_stats_since_ms;
+  const uint64_t   total   = s.busyUs + s.waitUs;
+
+  Serial.printf("loop: %u passes in %u ms (%u/s), awake %u.%u%%, %u woken early\n",
+                (unsigned)s.passes, (unsigned)elapsed,
+                elapsed ? (unsigned)(s.passes * 1000ull / elapsed) : 0u,
+                total ? (unsigned)(s.busyUs * 100 / total) : 0u,
+                total ? (unsigned)(s.busyUs * 1000 / total % 10) : 0u, (unsigned)s.wokenEarly);
+  loop_hist_print("busy", s.busy);
+  loop_hist_print("wait", s.wait);
+  memset(&loop_stats, 0, sizeof(loop_stats));
+  loop_stats_since_ms = millis();
+}
+
+static void power_setup() {
+#if CONFIG_PM_ENABLE
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_pm_config_t pm = {};
+#else
+  esp_pm_config_esp32s3_t pm = {};
+#endif
+  pm.max_freq_mhz = 240;
+  pm.min_freq_mhz = 80;
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+  pm.light_sleep_enable = true;
+#endif
+  if (esp_pm_configure(&pm) != ESP_OK) {
+    KLOGW(UI, "power: esp_pm_configure failed");
+    return;
+  }
+  esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "ui", &pm_cpu_lock);
+  esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "ui", &pm_awake_lock);
+  if (pm_cpu_lock) esp_pm_lock_acquire(pm_cpu_lock);
+  if (pm_awake_lock) esp_pm_lock_acquire(pm_awake_lock);
+#endif
+}
+
+// Backlight and panel off, locks released. INT becomes a low-level wake
+// source; touch_isr() masks it after the first hit.
+static void disp_blank() {
+  while (flush_pending) lvgl_wait_cb(&disp_drv);
+  lcd.setBrightness(0);
+  lcd.sleep();
+  disp_blanked     = true;
+  touch_wake_armed = true;
+  gpio_wakeup_enable((gpio_num_t)TOUCH_PIN_INT, GPIO_INTR_LOW_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+#if CONFIG_PM_ENABLE
+  if (pm_awake_lock) esp_pm_lock_release(pm_awake_lock);
+  if (pm_cpu_lock) esp_pm_lock_release(pm_cpu_lock);
+#endif
+  KLOGI(UI, "display blanked");
+}
+
+// The waking touch is swallowed up to its lift, so it cannot press
+// whatever is under the finger.
+static void disp_unblank() {
+#if CONFIG_PM_ENABLE
+  if (pm_cpu_lock) esp_pm_lock_acquire(pm_cpu_lock);
+  if (pm_awake_lock) esp_pm_lock_acquire(pm_awake_lock);
+#endif
+  touch_wake_armed = false;
+  gpio_wakeup_disable((gpio_num_t)TOUCH_PIN_INT);
+  gpio_set_intr_type((gpio_num_t)TOUCH_PIN_INT, GPIO_INTR_NEGEDGE);
+  gpio_intr_enable((gpio_num_t)TOUCH_PIN_INT);
+  touch_swallow = true;
+  disp_blanked  = false;
+
+  lcd.wakeup();
+  lcd.setBrightness(DISP_BRIGHTNESS);
+  lv_disp_trig_activity(NULL);
+  lv_obj_invalidate(lv_scr_act());
+  KLOGI(UI, "display on");
+}
+
+// Blank or unblank as due; returns ms until the blank timeout.
+static uint32_t power_service() {
+  if (disp_blanked) {
+    if (!touch_wake_armed) disp_unblank();
+    return UINT32_MAX;
+  }
+  if (DISP_BLANK_MS == 0 || KFD_ADAPTER_MODE || ui_keyload_running()) return UINT32_MAX;
+
+  const uint32_t idle = lv_disp_get_inactive_time(NULL);
+  if (idle < DISP_BLANK_MS) return DISP_BLANK_MS - idle;
+  disp_blank();
+  return UINT32_MAX;
+}
+
+// Block until deadlineMs or a notification, and account for the pass.
+static void loop_wait(uint32_t passStartUs, uint32_t deadlineMs) {
+  const uint32_t t0 = micros();
+  uint32_t       woken = 0;
+  if (deadlineMs > 0) {
+    const TickType_t ticks = deadlineMs == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(deadlineMs);
+    woken = ulTaskNotifyTake(pdTRUE, ticks);
+  }
+  const uint32_t t1 = micros();
+  touch_kick();
+
+  LoopStats& s = loop_stats;
+  s.passes++;
+  if (woken && deadlineMs > 0) s.wokenEarly++;
+  s.busyUs += t0 - passStartUs;
+  s.waitUs += t1 - t0;
+  loop_hist_add(s.busy, t0 - passStartUs);
+  loop_hist_add(s.wait, t1 - t0);
+}
+
+// ------------------------------------------------------------------
+// Serial console (line-based commands on the USB port)
+// ------------------------------------------------------------------
+
+static void handle_console_command(const char* cmd) {
+  if (strcmp(cmd, "kfd stats") == 0) {
+    // Printed by the protocol task, which owns the ports.
+    if (!KfdProtocolTask::instance().requestStats()) Serial.println("kfd busy, try again");
+  } else if (strncmp(cmd, "trace ", 6) == 0) {
+    KfdProtocolTask& task = KfdProtocolTask::instance();
+    const char*      arg  = cmd + 6;
+    bool             ok   = true;
+    if (strcmp(arg, "on") == 0)        ok = task.requestTrace(KfdCommand::TRACE_ON);
+    else if (strcmp(arg, "off") == 0)  ok = task.requestTrace(KfdCommand::TRACE_OFF);
+    else if (strcmp(arg, "dump") == 0) ok = task.requestTrace(KfdCommand::TRACE_DUMP);
+    else if (strcmp(arg, "save") == 0) ok = task.requestTrace(KfdCommand::TRACE_SAVE);
+    else Serial.println("usage: trace on|off|dump|save");
+    if (!ok) Serial.println("kfd busy, try again");
+  } else if (strcmp(cmd, "disp stats") == 0) {
+    disp_print_stats();
+    Serial.printf("touch: %u reads, %u dropped\n", (unsigned)touch_reads, (unsigned)touch_dropped);
+  } else if (strcmp(cmd, "loop stats") == 0) {
+    loop_print_stats();
+  } else if (strcmp(cmd, "gov stats") == 0) {
+    gov_print_stats();
+  } else if (strcmp(cmd, "disp bench") == 0) {
+    disp_run_bench();
+  } else if (strncmp(cmd, "disp mode ", 10) == 0) {
+    uint8_t m = 0;
+    while (m < DISP_MODE_COUNT && strcmp(cmd + 10, DISP_MODE_NAMES[m]) != 0) ++m;
+    if (m == DISP_MODE_COUNT) Serial.println("usage: disp mode partial|full|direct");
+    else if (!disp_set_mode((DispMode)m)) Serial.println("disp: not enough memory for that mode");
+  } else if (strcmp(cmd, "klog dump") == 0) {
+    klogDump();
+  } else if (strcmp(cmd, "klog echo on") == 0 || strcmp(cmd, "klog echo off") == 0) {
+    klogSetEcho(strcmp(cmd, "klog echo on") == 0);
+  } else if (strcmp(cmd, "help") == 0) {
+    Serial.println("commands: kfd stats, disp stats|bench|mode <m>, loop stats, gov stats, trace on|off|dump|save, "
+                   "klog dump, klog echo on|off, help");
+  } else if (cmd[0]) {
+    Serial.printf("unknown command '%s' (try 'help')\n", cmd);
+  }
+}
+
+static void service_serial_console() {
+  static char   line[64];
+  static size_t len = 0;
+
+  while (Serial.available() > 0) {
+    char c = (char)Serial.read();
+    if (c == '\r') continue;
+    if (c == '\n') {
+      line[len] = '\0';
+      handle_console_command(line);
+      len = 0;
+    } else if (len < sizeof(line) - 1) {
+      line[len++] = c;
+    }
+  }
 }
 
 // ------------------------------------------------------------------
@@ -203,44 +991,97 @@ static void setup_lvgl() {
 // ------------------------------------------------------------------
 
 void setup() {
+#if KFD_ADAPTER_MODE
+  Serial.setRxBufferSize(KFD_AP_RX_BUFFER);
+  Serial.begin(KFD_AP_BAUD);
+  klogSetEcho(false);
+#else
   Serial.begin(115200);
   delay(200);
   Serial.println("Keyloader UI boot (LVGL, LittleFS, persistence)...");
+#endif
 
   lcd.init();
   lcd.setColorDepth(16);  // make sure LGFX is in 16-bit mode
   lcd.setRotation(0);     // portrait: 320x480
-  lcd.setBrightness(200);
+  lcd.setBrightness(DISP_BRIGHTNESS);
 
+  loop_task_handle = xTaskGetCurrentTaskHandle();
+  power_setup();
+  setup_touch();
   setup_lvgl();
+  gov_begin();
 
   // Mount storage + load containers from LittleFS (or defaults)
   ContainerModel& model = ContainerModel::instance();
   model.loadDefaults();  // safe defaults first
   model.load();          // try to override from persistent storage
+  ContainerSearch::instance().begin();  // observes the model ahead of the UI
+
+#if KFD_BENCH_ON_BOOT
+  run_keyload_bench();
+#endif
 
+#if KFD_ADAPTER_MODE
+  adapter_line.begin();
+  adapter.begin();
   ui_init();
+  xTaskCreatePinnedToCore(adapter_task, "kfd-adapter", KFD_TASK_STACK, nullptr,
+                          KFD_TASK_PRIORITY, nullptr, KFD_TASK_CORE);
+#else
+  KfdPortScheduler::instance().begin();
+
+  ui_init();
+
+  // The line runs on its own core from here on; the UI only sees events.
+  KfdProtocolTask::instance().setEventWaiter(loop_task_handle);
+  KfdProtocolTask::instance().start();
+#endif
 }
 
 void loop() {
-  lv_timer_handler();
+  const uint32_t t0 = micros();
+  ContainerModel& model = ContainerModel::instance();
+
+  // Model changes from the last pass (UI events, console) patch the
+  // screens, as one batch, before LVGL draws this frame.
+  model.dispatchEvents();
+  const uint32_t lv_idle_ms = lv_timer_handler();
+  const uint16_t lv_inv     = display->inv_p;
+  disp_poll_flush();
+  if (disp_frame_drawn) {
+    disp_frame_drawn = false;
+    disp_stats.frames++;
+    disp_stats.refreshUs += micros() - t0;
+  }
+  ui_poll_kfd_events();
+
+  // Format deferred log entries, a few per pass
+  const bool log_backlog = klogService();
 
   // Periodic container autosave (deferred, light)
-  ContainerModel::instance().service();
+  model.service();
 
-  // simple timing / debouncing
-  static uint32_t last = millis();
-  uint32_t now = millis();
-  if (now - last > 5) {
-    last = now;
-  }
+#if !KFD_ADAPTER_MODE
+  service_serial_console();
+#endif
 
-  static int32_t x, y;
-  if (lcd.getTouch(&x, &y)) {
-    delay(50);
-  } else {
-    delay(5);
-  }
+  // Invalidated after lv_timer_handler() (events, console), new timer
+  // periods or model changes not yet on screen: its idle estimate is
+  // stale, so come straight back.
+  const bool lv_stale = disp_governor() || display->inv_p > lv_inv || model.eventsPending();
+
+  // Earliest deadline; LV_NO_TIMER_READY (UINT32_MAX) when LVGL is idle.
+  uint32_t deadline = lv_idle_ms;
+  deadline = min(deadline, model.msUntilService());
+  deadline = min(deadline, power_service());
+#if !KFD_ADAPTER_MODE
+  deadline = min(deadline, CONSOLE_POLL_MS);
+#endif
+  if (flush_pending) deadline = min(deadline, (uint32_t)1);  // DMA completion is polled
+  if (log_backlog || lv_stale) deadline = 0;
+
+  loop_wait(t0, deadline);
 }
 
 
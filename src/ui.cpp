@@ -4,9 +4,21 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <algorithm>
+#include <vector>
 
 #include "container_model.h"
+#include "container_search.h"
+#include "hex_codec.h"
+#include "kfd_protocol.h"
+#include "kfd_scheduler.h"
+#include "kfd_session_plan.h"
+#include "kfd_task.h"
+#include "klog.h"
+#include "ui_theme.h"
+#include "ui_vlist.h"
 #include <esp_system.h>  // esp_random()
+#include <esp_timer.h>
 
 #ifndef LV_SYMBOL_KEY
     #define LV_SYMBOL_KEY LV_SYMBOL_BELL
@@ -32,6 +44,9 @@ static lv_obj_t* factory_reset_mbox     = nullptr;
 // ----------------------
 // Screens
 // ----------------------
+// Each screen is built once, on first use, and kept. Model changes patch
+// the affected widgets as they happen (see "Model events" below), so
+// entering a screen again costs next to nothing.
 static lv_obj_t* home_screen          = nullptr;
 static lv_obj_t* containers_screen    = nullptr;
 static lv_obj_t* keyload_screen       = nullptr;
@@ -51,7 +66,17 @@ static lv_obj_t* keyload_status          = nullptr;
 static lv_obj_t* keyload_bar             = nullptr;
 static lv_obj_t* keyload_container_label = nullptr;
 static lv_obj_t* keyload_container_dd    = nullptr; // select container from keyload screen
-static lv_timer_t* keyload_timer         = nullptr;
+static lv_obj_t* keyload_stats           = nullptr; // live session telemetry
+static lv_obj_t* keyload_ports           = nullptr; // per-port progress (multi-port builds)
+static lv_obj_t* keyload_full_cb         = nullptr; // force full reload instead of delta
+static lv_obj_t* keyload_search          = nullptr; // narrows the container dropdown
+static std::vector<int> keyload_dd_map;             // dropdown option -> container, -1 for none
+static bool       keyload_running        = false;
+static bool       keyload_pending        = false; // queued, STARTED not yet seen
+// Mirrors of protocol state, fed only by KfdProtocolTask events.
+static KfdSessionTelemetry keyload_tel   = {};
+static uint8_t    keyload_port_pct[KFD_MAX_PORTS]   = {};
+static uint8_t    keyload_port_state[KFD_MAX_PORTS] = {}; // 0 unused, 1 running, 2 ok, 3 failed, 4 aborted
 static int        keyload_progress       = 0;
 
 // User manager widgets
@@ -65,9 +90,21 @@ static UserRole  pending_role       = ROLE_NONE;
 // Container detail UI
 static lv_obj_t* container_keys_list     = nullptr;
 static lv_obj_t* container_detail_status = nullptr;
+static lv_obj_t* detail_label_line       = nullptr;
+static lv_obj_t* detail_agency_line      = nullptr;
+static lv_obj_t* detail_band_line        = nullptr;
+static lv_obj_t* detail_lock_line        = nullptr;
 static int       current_container_index = -1;
 
+// Containers list UI
+static lv_obj_t* containers_list   = nullptr;
+static lv_obj_t* containers_search = nullptr;
+static bool      containers_filtered = false;  // rows come from containers_filter
+static std::vector<uint16_t> containers_filter;  // row -> container while filtered
+
 // Key edit UI
+static lv_obj_t* keyedit_title          = nullptr;
+static lv_obj_t* keyedit_cont_label     = nullptr;
 static lv_obj_t* keyedit_label_ta       = nullptr;
 static lv_obj_t* keyedit_algo_dd        = nullptr;
 static lv_obj_t* keyedit_key_ta         = nullptr;
@@ -128,6 +165,7 @@ static void event_btn_keyload(lv_event_t* e);
 static void event_btn_settings(lv_event_t* e);
 static void event_btn_user_manager(lv_event_t* e);
 static void event_btn_keyload_start(lv_event_t* e);
+static void event_btn_keyload_cancel(lv_event_t* e);
 
 // user manager callbacks
 static void event_select_admin(lv_event_t* e);
@@ -137,11 +175,13 @@ static void event_keypad_clear(lv_event_t* e);
 static void event_keypad_ok(lv_event_t* e);
 
 // containers callbacks
-static void container_btn_event(lv_event_t* e);
+static void container_row_text(size_t idx, char* buf, size_t len);
+static void container_row_clicked(size_t idx);
 static void event_add_container(lv_event_t* e);
 
 // container detail callbacks
-static void key_item_event(lv_event_t* e);
+static void key_row_text(size_t idx, char* buf, size_t len);
+static void key_row_clicked(size_t idx);
 static void event_add_key(lv_event_t* e);
 static void event_set_active_container(lv_event_t* e);
 static void event_delete_container(lv_event_t* e);
@@ -162,36 +202,6 @@ static void event_keyedit_cancel(lv_event_t* e);
 // keyload container dropdown callback
 static void event_keyload_container_changed(lv_event_t* e);
 
-// ----------------------
-// Styling helpers
-// ----------------------
-
-static void style_moto_tile_button(lv_obj_t* btn) {
-    lv_obj_set_style_bg_color(btn, lv_color_hex(0x10202A), LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(btn, LV_OPA_COVER, LV_PART_MAIN);
-    lv_obj_set_style_border_color(btn, lv_color_hex(0x00C0FF), LV_PART_MAIN);
-    lv_obj_set_style_border_width(btn, 2, LV_PART_MAIN);
-    lv_obj_set_style_radius(btn, 4, LV_PART_MAIN);
-    lv_obj_set_style_shadow_width(btn, 0, LV_PART_MAIN);
-
-    lv_obj_set_style_bg_color(btn, lv_color_hex(0x1C3A4A), LV_STATE_PRESSED | LV_PART_MAIN);
-}
-
-static void style_moto_panel(lv_obj_t* panel) {
-    lv_obj_set_style_bg_color(panel, lv_color_hex(0x05121A), 0);
-    lv_obj_set_style_bg_opa(panel, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_color(panel, lv_color_hex(0x00C0FF), 0);
-    lv_obj_set_style_border_width(panel, 1, 0);
-    lv_obj_set_style_radius(panel, 4, 0);
-    lv_obj_set_style_pad_all(panel, 6, 0);
-}
-
-static void style_moto_screen(lv_obj_t* scr) {
-    lv_obj_remove_style_all(scr);
-    lv_obj_set_style_bg_color(scr, lv_color_black(), 0);
-    lv_obj_set_style_bg_opa(scr, LV_OPA_COVER, 0);
-}
-
 // ----------------------
 // Role + access helpers
 // ----------------------
@@ -231,6 +241,38 @@ static bool check_access(bool admin_only, const char* action_name) {
     return true;
 }
 
+// ----------------------
+// Model sync
+// ----------------------
+// Cached screens are kept current by ui_on_model_events(), which the
+// model calls once per frame with everything that changed.
+static int detail_index = -1;  // container shown on the detail screen
+
+// Start of a navigation: when, and how much LVGL heap was in use.
+struct NavMark {
+    int64_t  t0;
+    uint32_t heap_used;
+};
+
+static uint32_t lv_heap_used() {
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    return mon.total_size - mon.free_size;
+}
+
+static NavMark nav_mark() {
+    return NavMark{esp_timer_get_time(), lv_heap_used()};
+}
+
+// Show a screen. On a first visit the log line is the screen's build
+// cost: time since the mark and the LVGL heap its objects took.
+static void load_screen(lv_obj_t* scr, const NavMark& mark) {
+    lv_scr_load(scr);
+    const uint32_t used = lv_heap_used();
+    KLOGD(UI, "screen ready in %u us, LVGL heap %+d B (%u B in use)",
+          (unsigned)(esp_timer_get_time() - mark.t0), (int)(used - mark.heap_used), (unsigned)used);
+}
+
 static void update_keyload_container_label() {
     if (!keyload_container_label) return;
 
@@ -241,31 +283,112 @@ static void update_keyload_container_label() {
     else     lv_label_set_text_fmt(keyload_container_label, "ACTIVE: %s", kc->label.c_str());
 }
 
+// The dropdown lists the containers matching the keyload search box, at
+// most KEYLOAD_DD_MAX of them: an LVGL dropdown keeps its options as one
+// string and draws them all when opened, so it cannot hold the library.
+static constexpr size_t KEYLOAD_DD_MAX = 64;
+
 static void rebuild_keyload_container_dropdown() {
     if (!keyload_container_dd) return;
 
     ContainerModel& model = ContainerModel::instance();
-    const size_t count = model.getCount();
+    keyload_dd_map.clear();
 
-    if (count == 0) {
+    if (model.getCount() == 0) {
         lv_dropdown_set_options(keyload_container_dd, "NO CONTAINERS");
         lv_dropdown_set_selected(keyload_container_dd, 0);
+        keyload_dd_map.push_back(-1);
         return;
     }
 
+    const char* query = keyload_search ? lv_textarea_get_text(keyload_search) : "";
+    std::vector<uint16_t> hits;
+    const size_t total = ContainerSearch::instance().find(query, hits, KEYLOAD_DD_MAX);
+
+    // Keep the active container selected if it matches; otherwise a
+    // placeholder stands in for it, so nothing gets picked by accident.
+    const int  active       = model.getActiveIndex();
+    const bool active_shown = active >= 0 && std::binary_search(hits.begin(), hits.end(), (uint16_t)active);
+
     std::string opts;
-    opts.reserve(count * 32);
+    opts.reserve((hits.size() + 2) * 32);
+    char line[40];
 
-    for (size_t i = 0; i < count; ++i) {
-        opts += model.get(i).label;
-        if (i + 1 < count) opts += "\n";
+    if (!active_shown) {
+        lv_snprintf(line, sizeof(line), "-- %u MATCHES --", (unsigned)total);
+        opts += line;
+        keyload_dd_map.push_back(-1);
+    }
+    for (uint16_t idx : hits) {
+        if (!opts.empty()) opts += "\n";
+        opts += model.get(idx).label;
+        keyload_dd_map.push_back(idx);
+    }
+    if (total > hits.size()) {
+        lv_snprintf(line, sizeof(line), "\n(%u MORE - REFINE SEARCH)", (unsigned)(total - hits.size()));
+        opts += line;
+        keyload_dd_map.push_back(-1);
     }
 
     lv_dropdown_set_options(keyload_container_dd, opts.c_str());
 
-    int active = model.getActiveIndex();
-    if (active < 0 || active >= (int)count) active = 0;
-    lv_dropdown_set_selected(keyload_container_dd, (uint16_t)active);
+    uint16_t sel = 0;
+    if (active_shown) {
+        sel = (uint16_t)(std::find(keyload_dd_map.begin(), keyload_dd_map.end(), active) - keyload_dd_map.begin());
+    }
+    lv_dropdown_set_selected(keyload_container_dd, sel);
+}
+
+// ----------------------
+// Search fields
+// ----------------------
+
+// Shows the field's keyboard while it is being typed in. A second tap
+// on a field that kept focus only sends CLICKED, so that shows it too.
+static void search_field_event(lv_event_t* e) {
+    lv_obj_t* ta = lv_event_get_target(e);
+    lv_obj_t* kb = static_cast<lv_obj_t*>(lv_event_get_user_data(e));
+    const lv_event_code_t code = lv_event_get_code(e);
+
+    if (code == LV_EVENT_FOCUSED || code == LV_EVENT_CLICKED) {
+        lv_keyboard_set_textarea(kb, ta);
+        lv_obj_add_state(ta, LV_STATE_FOCUSED);
+        lv_obj_clear_flag(kb, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_add_flag(kb, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_clear_state(ta, LV_STATE_FOCUSED);
+    }
+}
+
+// One-line search box on `parent` with a keyboard along the bottom of
+// `scr`; `on_change` runs on every keystroke. Hiding the keyboard drops
+// the focus state too, so no cursor keeps blinking the display awake.
+static lv_obj_t* create_search_field(lv_obj_t* scr, lv_obj_t* parent, lv_coord_t w, lv_event_cb_t on_change) {
+    lv_obj_t* ta = lv_textarea_create(parent);
+    lv_obj_set_size(ta, w, 34);
+    lv_textarea_set_one_line(ta, true);
+    lv_textarea_set_max_length(ta, 32);
+    lv_textarea_set_placeholder_text(ta, "SEARCH");
+    lv_obj_add_event_cb(ta, on_change, LV_EVENT_VALUE_CHANGED, NULL);
+
+    lv_obj_t* kb = lv_keyboard_create(scr);
+    lv_obj_set_size(kb, scr_w(), 90);
+    lv_obj_align(kb, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_obj_add_flag(kb, LV_OBJ_FLAG_HIDDEN);
+
+    lv_obj_add_event_cb(ta, search_field_event, LV_EVENT_FOCUSED, kb);
+    lv_obj_add_event_cb(ta, search_field_event, LV_EVENT_CLICKED, kb);
+    lv_obj_add_event_cb(ta, search_field_event, LV_EVENT_DEFOCUSED, kb);
+    lv_obj_add_event_cb(ta, search_field_event, LV_EVENT_READY, kb);
+    lv_obj_add_event_cb(ta, search_field_event, LV_EVENT_CANCEL, kb);
+    return ta;
+}
+
+// Panel look and row font of the container and key lists; given to
+// ui_vlist_create() so it is set before the rows inherit from it.
+static void style_list_panel(lv_obj_t* list) {
+    ui_theme_panel(list);
+    lv_obj_set_style_text_font(list, &lv_font_montserrat_16, LV_PART_MAIN);
 }
 
 // ----------------------
@@ -279,7 +402,7 @@ static void build_home_screen(void) {
     }
 
     home_screen = lv_obj_create(NULL);
-    style_moto_screen(home_screen);
+    ui_theme_screen(home_screen);
 
     // ---------- Fonts (optional; safe if enabled in lv_conf.h) ----------
     // If these fonts are not enabled, comment these out.
@@ -291,14 +414,11 @@ static void build_home_screen(void) {
     lv_obj_set_size(top_bar, scr_w(), TOP_BAR_H);
     lv_obj_align(top_bar, LV_ALIGN_TOP_MID, 0, 0);
     lv_obj_clear_flag(top_bar, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_color(top_bar, lv_color_hex(0x001522), 0);
-    lv_obj_set_style_bg_opa(top_bar, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_width(top_bar, 0, 0);
+    ui_theme_bar(top_bar);
 
     lv_obj_t* title = lv_label_create(top_bar);
     lv_label_set_text(title, "KFD TERMINAL");
-    lv_obj_set_style_text_color(title, lv_color_hex(0x00C0FF), 0);
-    lv_obj_set_style_text_font(title, &lv_font_montserrat_20, 0);
+    ui_theme_title(title);
     lv_obj_align(title, LV_ALIGN_LEFT_MID, 8, 0);
 
     home_user_label = lv_label_create(top_bar);
@@ -312,9 +432,7 @@ static void build_home_screen(void) {
     lv_obj_set_size(bottom_bar, scr_w(), 36);
     lv_obj_align(bottom_bar, LV_ALIGN_BOTTOM_MID, 0, 0);
     lv_obj_clear_flag(bottom_bar, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_color(bottom_bar, lv_color_hex(0x001522), 0);
-    lv_obj_set_style_bg_opa(bottom_bar, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_width(bottom_bar, 0, 0);
+    ui_theme_bar(bottom_bar);
 
     status_label = lv_label_create(bottom_bar);
     lv_label_set_text(status_label, "READY - LOGIN RECOMMENDED");
@@ -347,7 +465,7 @@ static void build_home_screen(void) {
     lv_obj_t* btn_keys = lv_btn_create(home_screen);
     lv_obj_set_size(btn_keys, tile_w, tile_h);
     lv_obj_align(btn_keys, LV_ALIGN_TOP_MID, 0, y0);
-    style_moto_tile_button(btn_keys);
+    ui_theme_tile_button(btn_keys);
     lv_obj_add_event_cb(btn_keys, event_btn_keys, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_keys = lv_label_create(btn_keys);
@@ -358,7 +476,7 @@ static void build_home_screen(void) {
     lv_obj_t* btn_keyload = lv_btn_create(home_screen);
     lv_obj_set_size(btn_keyload, tile_w, tile_h);
     lv_obj_align(btn_keyload, LV_ALIGN_TOP_MID, 0, y0 + tile_h + gap);
-    style_moto_tile_button(btn_keyload);
+    ui_theme_tile_button(btn_keyload);
     lv_obj_add_event_cb(btn_keyload, event_btn_keyload, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_keyload = lv_label_create(btn_keyload);
@@ -369,7 +487,7 @@ static void build_home_screen(void) {
     lv_obj_t* btn_settings = lv_btn_create(home_screen);
     lv_obj_set_size(btn_settings, tile_w, tile_h);
     lv_obj_align(btn_settings, LV_ALIGN_TOP_MID, 0, y0 + (tile_h + gap) * 2);
-    style_moto_tile_button(btn_settings);
+    ui_theme_tile_button(btn_settings);
     lv_obj_add_event_cb(btn_settings, event_btn_settings, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_settings = lv_label_create(btn_settings);
@@ -381,7 +499,7 @@ static void build_home_screen(void) {
     lv_obj_t* btn_user = lv_btn_create(home_screen);
     lv_obj_set_size(btn_user, tile_w, login_h);
     lv_obj_align(btn_user, LV_ALIGN_TOP_MID, 0, y0 + (tile_h + gap) * 3 + gap_before_login);
-    style_moto_tile_button(btn_user);
+    ui_theme_tile_button(btn_user);
     lv_obj_add_event_cb(btn_user, event_btn_user_manager, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_user = lv_label_create(btn_user);
@@ -395,9 +513,38 @@ static void build_home_screen(void) {
 // CONTAINERS SCREEN
 // ----------------------
 
-static void container_btn_event(lv_event_t* e) {
-    uintptr_t idx_val = (uintptr_t) lv_event_get_user_data(e);
-    int idx = static_cast<int>(idx_val);
+static size_t container_at_row(size_t row) {
+    return containers_filtered ? containers_filter[row] : row;
+}
+
+static void container_row_text(size_t row, char* buf, size_t len) {
+    lv_snprintf(buf, len, "%s", ContainerModel::instance().get(container_at_row(row)).label.c_str());
+}
+
+// Show every container, or only those matching the search box.
+static void apply_containers_filter() {
+    if (!containers_list) return;
+
+    const char* query = containers_search ? lv_textarea_get_text(containers_search) : "";
+
+    containers_filtered = query[0] != '\0';
+    if (containers_filtered) {
+        ContainerSearch::instance().find(query, containers_filter);
+        ui_vlist_set_count(containers_list, containers_filter.size());
+    } else {
+        containers_filter.clear();
+        ui_vlist_set_count(containers_list, ContainerModel::instance().getCount());
+    }
+}
+
+static void event_containers_search(lv_event_t* e) {
+    (void)e;
+    apply_containers_filter();
+}
+
+static void container_row_clicked(size_t row) {
+    if (containers_filtered && row >= containers_filter.size()) return;
+    int idx = static_cast<int>(container_at_row(row));
 
     ContainerModel& model = ContainerModel::instance();
     if (idx < 0 || static_cast<size_t>(idx) >= model.getCount()) return;
@@ -409,21 +556,16 @@ static void container_btn_event(lv_event_t* e) {
         lv_label_set_text_fmt(status_label, "CONTAINER SELECTED: %s", model.get(idx).label.c_str());
     }
 
-    update_keyload_container_label();
-    if (keyload_container_dd) rebuild_keyload_container_dropdown();
-
+    const NavMark mark = nav_mark();
     build_container_detail_screen(idx);
-    if (container_detail_screen) lv_scr_load(container_detail_screen);
+    if (container_detail_screen) load_screen(container_detail_screen, mark);
 }
 
 static void build_containers_screen(void) {
-    if (containers_screen) {
-        lv_obj_del(containers_screen);
-        containers_screen = nullptr;
-    }
+    if (containers_screen) return;  // kept current by ui_on_model_events()
 
     containers_screen = lv_obj_create(NULL);
-    style_moto_screen(containers_screen);
+    ui_theme_screen(containers_screen);
 
     // Fonts (optional; comment out if not enabled)
     extern const lv_font_t lv_font_montserrat_20;
@@ -434,20 +576,17 @@ static void build_containers_screen(void) {
     lv_obj_set_size(top_bar, scr_w(), TOP_BAR_H);
     lv_obj_align(top_bar, LV_ALIGN_TOP_MID, 0, 0);
     lv_obj_clear_flag(top_bar, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_color(top_bar, lv_color_hex(0x001522), 0);
-    lv_obj_set_style_bg_opa(top_bar, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_width(top_bar, 0, 0);
+    ui_theme_bar(top_bar);
 
     lv_obj_t* title = lv_label_create(top_bar);
     lv_label_set_text(title, "CONTAINER INVENTORY");
-    lv_obj_set_style_text_color(title, lv_color_hex(0x00C0FF), 0);
-    lv_obj_set_style_text_font(title, &lv_font_montserrat_20, 0);
+    ui_theme_title(title);
     lv_obj_align(title, LV_ALIGN_LEFT_MID, 8, 0);
 
     lv_obj_t* btn_back = lv_btn_create(top_bar);
     lv_obj_set_size(btn_back, 92, 32);
     lv_obj_align(btn_back, LV_ALIGN_RIGHT_MID, -6, 0);
-    style_moto_tile_button(btn_back);
+    ui_theme_tile_button(btn_back);
     lv_obj_add_event_cb(btn_back, show_home_screen, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_back = lv_label_create(btn_back);
@@ -460,42 +599,26 @@ static void build_containers_screen(void) {
     const int footer_h = 54;           // bigger "NEW CONTAINER"
     const int footer_gap = 12;
 
-    const int list_top = TOP_BAR_H + PAD;
+    const int search_h = 34;
+    const int list_top = TOP_BAR_H + PAD + search_h + PAD;
     const int list_h = scr_h() - list_top - PAD - footer_h - footer_gap;
 
-    // List
-    lv_obj_t* list = lv_list_create(containers_screen);
-    lv_obj_set_size(list, list_w, (list_h > 60 ? list_h : 60));
-    lv_obj_align(list, LV_ALIGN_TOP_MID, 0, list_top);
-    style_moto_panel(list);
-
-    // Make list items bigger and easier to tap
-    lv_obj_set_style_pad_row(list, 8, LV_PART_MAIN);
-    lv_obj_set_style_text_font(list, &lv_font_montserrat_16, LV_PART_MAIN);
-
-    // The LVGL list buttons are children; increase their min height
-    // (Works well across LVGL 8.x)
-    lv_obj_set_style_pad_ver(list, 8, LV_PART_ITEMS);
-    lv_obj_set_style_text_font(list, &lv_font_montserrat_16, LV_PART_ITEMS);
+    containers_search = create_search_field(containers_screen, containers_screen, list_w, event_containers_search);
+    lv_obj_align(containers_search, LV_ALIGN_TOP_MID, 0, TOP_BAR_H + PAD);
 
-    ContainerModel& model = ContainerModel::instance();
-    size_t count = model.getCount();
+    // List: a fixed pool of large, easy to tap rows, rebound on scroll
+    containers_list = ui_vlist_create(containers_screen, list_w, (list_h > 60 ? list_h : 60),
+                                      44, 8, LV_SYMBOL_EDIT, style_list_panel,
+                                      container_row_text, container_row_clicked);
+    lv_obj_align(containers_list, LV_ALIGN_TOP_MID, 0, list_top);
 
-    for (size_t i = 0; i < count; ++i) {
-        const KeyContainer& kc = model.get(i);
-        lv_obj_t* btn = lv_list_add_btn(list, LV_SYMBOL_EDIT, kc.label.c_str());
-        lv_obj_add_event_cb(btn, container_btn_event, LV_EVENT_CLICKED, (void*)(uintptr_t)i);
-
-        // Per-item sizing
-        lv_obj_set_height(btn, 44); // larger row
-        lv_obj_set_style_text_font(btn, &lv_font_montserrat_16, 0);
-    }
+    apply_containers_filter();
 
     // Footer: New container button (full width, centered)
     lv_obj_t* btn_new = lv_btn_create(containers_screen);
     lv_obj_set_size(btn_new, list_w, footer_h);
     lv_obj_align(btn_new, LV_ALIGN_BOTTOM_MID, 0, -PAD);
-    style_moto_tile_button(btn_new);
+    ui_theme_tile_button(btn_new);
     lv_obj_add_event_cb(btn_new, event_add_container, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_new = lv_label_create(btn_new);
@@ -509,34 +632,51 @@ static void build_containers_screen(void) {
 // CONTAINER DETAIL + KEYS
 // ----------------------
 
+static void key_row_text(size_t idx, char* buf, size_t len) {
+    ContainerModel& model = ContainerModel::instance();
+    if (detail_index < 0 || (size_t)detail_index >= model.getCount()) return;
+
+    const KeyContainer& kc = model.get(detail_index);
+    if (idx >= kc.keys.size()) return;
+
+    const KeySlot& ks = kc.keys[idx];
+    lv_snprintf(buf, len,
+                "%02u  %s (%s)%s",
+                (unsigned)(idx + 1),
+                ks.label.c_str(),
+                ks.algo.c_str(),
+                ks.selected ? " [SEL]" : "");
+}
+
 static void rebuild_container_keys_list(int container_index) {
     ContainerModel& model = ContainerModel::instance();
     if (container_index < 0 || static_cast<size_t>(container_index) >= model.getCount()) return;
 
-    const KeyContainer& kc = model.get(container_index);
+    if (!container_keys_list) return;
 
-    if (container_keys_list) {
-        lv_obj_del(container_keys_list);
-        container_keys_list = nullptr;
-    }
+    ui_vlist_set_count(container_keys_list, model.get(container_index).keys.size());
+}
 
-    // We size/position this list in build_container_detail_screen()
-    container_keys_list = lv_list_create(container_detail_screen);
-    style_moto_panel(container_keys_list);
-
-    for (size_t i = 0; i < kc.keys.size(); ++i) {
-        const KeySlot& ks = kc.keys[i];
-        char line[96];
-        lv_snprintf(line, sizeof(line),
-                    "%02u  %s (%s)%s",
-                    (unsigned)(i + 1),
-                    ks.label.c_str(),
-                    ks.algo.c_str(),
-                    ks.selected ? " [SEL]" : "");
-
-        lv_obj_t* btn = lv_list_add_btn(container_keys_list, LV_SYMBOL_KEY, line);
-        lv_obj_add_event_cb(btn, key_item_event, LV_EVENT_CLICKED, (void*)(uintptr_t)i);
-    }
+static void fill_container_detail_meta(int container_index) {
+    const KeyContainer& kc = ContainerModel::instance().get(container_index);
+    lv_label_set_text(detail_label_line, kc.label.c_str());
+    lv_label_set_text_fmt(detail_agency_line, "Agency: %s", kc.agency.c_str());
+    lv_label_set_text_fmt(detail_band_line, "Band/Algo: %s / %s", kc.band.c_str(), kc.algo.c_str());
+    lv_label_set_text_fmt(detail_lock_line, "Locked: %s", kc.locked ? "YES" : "NO");
+    lv_obj_set_style_text_color(detail_lock_line, lv_color_hex(kc.locked ? 0xFF8080 : 0x80FF80), 0);
+}
+
+// Edits to the container already shown arrive through the model
+// observer; only switching to another container re-fills the screen.
+static void refresh_container_detail(int container_index) {
+    lv_label_set_text(container_detail_status, "CONTAINER READY");
+    if (container_index == detail_index) return;
+
+    // Another container starts at the top of its keys.
+    detail_index = container_index;
+    lv_obj_scroll_to_y(container_keys_list, 0, LV_ANIM_OFF);
+    fill_container_detail_meta(container_index);
+    rebuild_container_keys_list(container_index);
 }
 
 static void build_container_detail_screen(int container_index) {
@@ -544,13 +684,10 @@ static void build_container_detail_screen(int container_index) {
     if (container_index < 0 || static_cast<size_t>(container_index) >= model.getCount()) return;
 
     current_container_index = container_index;
-    const KeyContainer& kc = model.get(container_index);
 
     if (container_detail_screen) {
-        lv_obj_del(container_detail_screen);
-        container_detail_screen = nullptr;
-        container_keys_list = nullptr;
-        container_detail_status = nullptr;
+        refresh_container_detail(container_index);
+        return;
     }
 
     // Fonts (optional; comment out if not enabled)
@@ -558,27 +695,24 @@ static void build_container_detail_screen(int container_index) {
     extern const lv_font_t lv_font_montserrat_16;
 
     container_detail_screen = lv_obj_create(NULL);
-    style_moto_screen(container_detail_screen);
+    ui_theme_screen(container_detail_screen);
 
     // Top bar
     lv_obj_t* top_bar = lv_obj_create(container_detail_screen);
     lv_obj_set_size(top_bar, scr_w(), TOP_BAR_H);
     lv_obj_align(top_bar, LV_ALIGN_TOP_MID, 0, 0);
     lv_obj_clear_flag(top_bar, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_color(top_bar, lv_color_hex(0x001522), 0);
-    lv_obj_set_style_bg_opa(top_bar, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_width(top_bar, 0, 0);
+    ui_theme_bar(top_bar);
 
     lv_obj_t* title = lv_label_create(top_bar);
     lv_label_set_text(title, "CONTAINER DETAIL");
-    lv_obj_set_style_text_color(title, lv_color_hex(0x00C0FF), 0);
-    lv_obj_set_style_text_font(title, &lv_font_montserrat_20, 0);
+    ui_theme_title(title);
     lv_obj_align(title, LV_ALIGN_LEFT_MID, 8, 0);
 
     lv_obj_t* btn_back = lv_btn_create(top_bar);
     lv_obj_set_size(btn_back, 92, 32);
     lv_obj_align(btn_back, LV_ALIGN_RIGHT_MID, -6, 0);
-    style_moto_tile_button(btn_back);
+    ui_theme_tile_button(btn_back);
     lv_obj_add_event_cb(btn_back, show_containers_screen, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_back = lv_label_create(btn_back);
@@ -592,36 +726,32 @@ static void build_container_detail_screen(int container_index) {
     lv_obj_set_size(meta, scr_w() - (PAD * 2), meta_h);
     lv_obj_align(meta, LV_ALIGN_TOP_MID, 0, TOP_BAR_H + PAD);
     lv_obj_clear_flag(meta, LV_OBJ_FLAG_SCROLLABLE);
-    style_moto_panel(meta);
-
-    lv_obj_t* label_line = lv_label_create(meta);
-    lv_label_set_text_fmt(label_line, "%s", kc.label.c_str());
-    lv_obj_set_style_text_color(label_line, lv_color_hex(0xC8F4FF), 0);
-    lv_obj_set_style_text_font(label_line, &lv_font_montserrat_20, 0);
-    lv_obj_align(label_line, LV_ALIGN_TOP_LEFT, 2, 2);
-
-    lv_obj_t* agency_line = lv_label_create(meta);
-    lv_label_set_text_fmt(agency_line, "Agency: %s", kc.agency.c_str());
-    lv_obj_set_style_text_color(agency_line, lv_color_hex(0x80E0FF), 0);
-    lv_obj_set_style_text_font(agency_line, &lv_font_montserrat_16, 0);
-    lv_obj_align(agency_line, LV_ALIGN_TOP_LEFT, 2, 30);
-
-    lv_obj_t* band_line = lv_label_create(meta);
-    lv_label_set_text_fmt(band_line, "Band/Algo: %s / %s", kc.band.c_str(), kc.algo.c_str());
-    lv_obj_set_style_text_color(band_line, lv_color_hex(0x80E0FF), 0);
-    lv_obj_set_style_text_font(band_line, &lv_font_montserrat_16, 0);
-    lv_obj_align(band_line, LV_ALIGN_TOP_LEFT, 2, 50);
-
-    lv_obj_t* lock_line = lv_label_create(meta);
-    lv_label_set_text_fmt(lock_line, "Locked: %s", kc.locked ? "YES" : "NO");
-    lv_obj_set_style_text_color(lock_line, lv_color_hex(kc.locked ? 0xFF8080 : 0x80FF80), 0);
-    lv_obj_set_style_text_font(lock_line, &lv_font_montserrat_16, 0);
-    lv_obj_align(lock_line, LV_ALIGN_TOP_LEFT, 2, 70);
+    ui_theme_panel(meta);
+
+    // Text is filled in by refresh_container_detail()
+    detail_label_line = lv_label_create(meta);
+    lv_obj_set_style_text_color(detail_label_line, lv_color_hex(0xC8F4FF), 0);
+    lv_obj_set_style_text_font(detail_label_line, &lv_font_montserrat_20, 0);
+    lv_obj_align(detail_label_line, LV_ALIGN_TOP_LEFT, 2, 2);
+
+    detail_agency_line = lv_label_create(meta);
+    lv_obj_set_style_text_color(detail_agency_line, lv_color_hex(0x80E0FF), 0);
+    lv_obj_set_style_text_font(detail_agency_line, &lv_font_montserrat_16, 0);
+    lv_obj_align(detail_agency_line, LV_ALIGN_TOP_LEFT, 2, 30);
+
+    detail_band_line = lv_label_create(meta);
+    lv_obj_set_style_text_color(detail_band_line, lv_color_hex(0x80E0FF), 0);
+    lv_obj_set_style_text_font(detail_band_line, &lv_font_montserrat_16, 0);
+    lv_obj_align(detail_band_line, LV_ALIGN_TOP_LEFT, 2, 50);
+
+    detail_lock_line = lv_label_create(meta);
+    lv_obj_set_style_text_font(detail_lock_line, &lv_font_montserrat_16, 0);
+    lv_obj_align(detail_lock_line, LV_ALIGN_TOP_LEFT, 2, 70);
 
     lv_obj_t* btn_edit = lv_btn_create(meta);
     lv_obj_set_size(btn_edit, 84, 34);
     lv_obj_align(btn_edit, LV_ALIGN_RIGHT_MID, -4, 0);
-    style_moto_tile_button(btn_edit);
+    ui_theme_tile_button(btn_edit);
     lv_obj_add_event_cb(btn_edit, event_edit_container, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_edit = lv_label_create(btn_edit);
@@ -641,7 +771,7 @@ static void build_container_detail_screen(int container_index) {
     lv_obj_t* btn_active = lv_btn_create(container_detail_screen);
     lv_obj_set_size(btn_active, btn_w, btn_h);
     lv_obj_align(btn_active, LV_ALIGN_TOP_LEFT, PAD, btn_row_y);
-    style_moto_tile_button(btn_active);
+    ui_theme_tile_button(btn_active);
     lv_obj_add_event_cb(btn_active, event_set_active_container, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_active = lv_label_create(btn_active);
@@ -652,7 +782,7 @@ static void build_container_detail_screen(int container_index) {
     lv_obj_t* btn_add_key = lv_btn_create(container_detail_screen);
     lv_obj_set_size(btn_add_key, btn_w, btn_h);
     lv_obj_align(btn_add_key, LV_ALIGN_TOP_LEFT, PAD + btn_w + btn_gap, btn_row_y);
-    style_moto_tile_button(btn_add_key);
+    ui_theme_tile_button(btn_add_key);
     lv_obj_add_event_cb(btn_add_key, event_add_key, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_add_key = lv_label_create(btn_add_key);
@@ -663,7 +793,7 @@ static void build_container_detail_screen(int container_index) {
     lv_obj_t* btn_del = lv_btn_create(container_detail_screen);
     lv_obj_set_size(btn_del, btn_w, btn_h);
     lv_obj_align(btn_del, LV_ALIGN_TOP_RIGHT, -PAD, btn_row_y);
-    style_moto_tile_button(btn_del);
+    ui_theme_tile_button(btn_del);
     lv_obj_add_event_cb(btn_del, event_delete_container, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_del = lv_label_create(btn_del);
@@ -673,25 +803,23 @@ static void build_container_detail_screen(int container_index) {
 
     // Status line above buttons
     container_detail_status = lv_label_create(container_detail_screen);
-    lv_label_set_text(container_detail_status, "CONTAINER READY");
     lv_obj_set_style_text_color(container_detail_status, lv_color_hex(0x80E0FF), 0);
     lv_obj_set_style_text_font(container_detail_status, &lv_font_montserrat_16, 0);
     lv_obj_align(container_detail_status, LV_ALIGN_TOP_LEFT, PAD, status_y);
 
     // Keys list fills the remaining space
-    rebuild_container_keys_list(container_index);
-
     const int list_top = TOP_BAR_H + PAD + meta_h + PAD;
     const int list_bottom = status_y - 10;
     int list_h = list_bottom - list_top;
     if (list_h < 60) list_h = 60;
 
-    lv_obj_set_size(container_keys_list, scr_w() - (PAD * 2), list_h);
+    container_keys_list = ui_vlist_create(container_detail_screen, scr_w() - (PAD * 2), list_h,
+                                          40, 8, LV_SYMBOL_KEY, style_list_panel,
+                                          key_row_text, key_row_clicked);
     lv_obj_align(container_keys_list, LV_ALIGN_TOP_MID, 0, list_top);
 
-    // Make key list items larger
-    lv_obj_set_style_pad_row(container_keys_list, 8, LV_PART_MAIN);
-    lv_obj_set_style_text_font(container_keys_list, &lv_font_montserrat_16, LV_PART_MAIN);
+    detail_index = -1;
+    refresh_container_detail(container_index);
 }
 
 
@@ -699,17 +827,18 @@ static void build_container_detail_screen(int container_index) {
 
 static void show_containers_screen(lv_event_t* e) {
     (void)e;
+    const NavMark mark = nav_mark();
     build_containers_screen();
-    if (containers_screen) lv_scr_load(containers_screen);
+    if (containers_screen) load_screen(containers_screen, mark);
 }
 
-static void key_item_event(lv_event_t* e) {
+static void key_row_clicked(size_t row) {
     if (current_container_index < 0) return;
-    uintptr_t idx_val = (uintptr_t) lv_event_get_user_data(e);
-    int key_idx = static_cast<int>(idx_val);
+    int key_idx = static_cast<int>(row);
 
+    const NavMark mark = nav_mark();
     build_key_edit_screen(current_container_index, key_idx);
-    if (key_edit_screen) lv_scr_load(key_edit_screen);
+    if (key_edit_screen) load_screen(key_edit_screen, mark);
 }
 
 static void event_add_key(lv_event_t* e) {
@@ -717,8 +846,9 @@ static void event_add_key(lv_event_t* e) {
     if (!check_access(false, "ADD KEY")) return;
     if (current_container_index < 0) return;
 
+    const NavMark mark = nav_mark();
     build_key_edit_screen(current_container_index, -1);
-    if (key_edit_screen) lv_scr_load(key_edit_screen);
+    if (key_edit_screen) load_screen(key_edit_screen, mark);
 }
 
 static void event_set_active_container(lv_event_t* e) {
@@ -729,8 +859,6 @@ static void event_set_active_container(lv_event_t* e) {
     model.setActiveIndex(current_container_index);
 
     if (container_detail_status) lv_label_set_text(container_detail_status, "ACTIVE CONTAINER SET");
-    update_keyload_container_label();
-    if (keyload_container_dd) rebuild_keyload_container_dropdown();
 }
 
 static void event_btn_save_now(lv_event_t* e) {
@@ -920,13 +1048,21 @@ static void event_contedit_save(lv_event_t* e) {
         return;
     }
 
-    update_keyload_container_label();
-    if (keyload_container_dd) rebuild_keyload_container_dropdown();
-
     build_container_detail_screen(cont_edit_idx);
     if (container_detail_screen) lv_scr_load(container_detail_screen);
 }
 
+static void populate_container_edit(const KeyContainer& kc) {
+    lv_textarea_set_text(contedit_label_ta, kc.label.c_str());
+    lv_textarea_set_text(contedit_agency_ta, kc.agency.c_str());
+    lv_textarea_set_text(contedit_band_ta, kc.band.c_str());
+    lv_dropdown_set_selected(contedit_algo_dd, cont_algo_to_index(kc.algo));
+    if (kc.locked) lv_obj_add_state(contedit_locked_cb, LV_STATE_CHECKED);
+    else           lv_obj_clear_state(contedit_locked_cb, LV_STATE_CHECKED);
+    lv_label_set_text(contedit_status, "");
+    lv_keyboard_set_textarea(contedit_kb, contedit_label_ta);
+}
+
 static void build_container_edit_screen(int container_index) {
     ContainerModel& model = ContainerModel::instance();
     if (container_index < 0 || (size_t)container_index >= model.getCount()) return;
@@ -935,27 +1071,18 @@ static void build_container_edit_screen(int container_index) {
     const KeyContainer& kc = model.get(container_index);
 
     if (container_edit_screen) {
-        lv_obj_del(container_edit_screen);
-        container_edit_screen = nullptr;
-        contedit_label_ta = nullptr;
-        contedit_agency_ta = nullptr;
-        contedit_band_ta = nullptr;
-        contedit_algo_dd = nullptr;
-        contedit_locked_cb = nullptr;
-        contedit_status = nullptr;
-        contedit_kb = nullptr;
+        populate_container_edit(kc);
+        return;
     }
 
     container_edit_screen = lv_obj_create(NULL);
-    style_moto_screen(container_edit_screen);
+    ui_theme_screen(container_edit_screen);
 
     lv_obj_t* top_bar = lv_obj_create(container_edit_screen);
     lv_obj_set_size(top_bar, scr_w(), TOP_BAR_H);
     lv_obj_align(top_bar, LV_ALIGN_TOP_MID, 0, 0);
     lv_obj_clear_flag(top_bar, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_color(top_bar, lv_color_hex(0x001522), 0);
-    lv_obj_set_style_bg_opa(top_bar, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_width(top_bar, 0, 0);
+    ui_theme_bar(top_bar);
 
     lv_obj_t* title = lv_label_create(top_bar);
     lv_label_set_text(title, "EDIT CONTAINER");
@@ -965,7 +1092,7 @@ static void build_container_edit_screen(int container_index) {
     lv_obj_t* btn_back = lv_btn_create(top_bar);
     lv_obj_set_size(btn_back, 90, 30);
     lv_obj_align(btn_back, LV_ALIGN_RIGHT_MID, -4, 0);
-    style_moto_tile_button(btn_back);
+    ui_theme_tile_button(btn_back);
     lv_obj_add_event_cb(btn_back, event_contedit_cancel, LV_EVENT_CLICKED, NULL);
     lv_obj_t* lbl_back = lv_label_create(btn_back);
     lv_label_set_text(lbl_back, LV_SYMBOL_LEFT " BACK");
@@ -976,7 +1103,7 @@ static void build_container_edit_screen(int container_index) {
     lv_obj_set_size(form, scr_w() - (PAD * 2), 240);
     lv_obj_align(form, LV_ALIGN_TOP_MID, 0, TOP_BAR_H + PAD);
     lv_obj_clear_flag(form, LV_OBJ_FLAG_SCROLLABLE);
-    style_moto_panel(form);
+    ui_theme_panel(form);
 
     // Labels & fields
     lv_obj_t* lbl1 = lv_label_create(form);
@@ -1028,7 +1155,6 @@ static void build_container_edit_screen(int container_index) {
     lv_obj_align(contedit_locked_cb, LV_ALIGN_TOP_LEFT, 2, 160);
 
     contedit_status = lv_label_create(form);
-    lv_label_set_text(contedit_status, "");
     lv_obj_set_style_text_color(contedit_status, lv_color_hex(0xFFD0A0), 0);
     lv_obj_align(contedit_status, LV_ALIGN_TOP_LEFT, 2, 192);
 
@@ -1039,7 +1165,7 @@ static void build_container_edit_screen(int container_index) {
     lv_obj_t* btn_save = lv_btn_create(container_edit_screen);
     lv_obj_set_size(btn_save, (scr_w() - (PAD * 3)) / 2, 44);
     lv_obj_align(btn_save, LV_ALIGN_TOP_LEFT, PAD, btn_y);
-    style_moto_tile_button(btn_save);
+    ui_theme_tile_button(btn_save);
     lv_obj_add_event_cb(btn_save, event_contedit_save, LV_EVENT_CLICKED, NULL);
     lv_obj_t* lbl_save = lv_label_create(btn_save);
     lv_label_set_text(lbl_save, "SAVE");
@@ -1048,7 +1174,7 @@ static void build_container_edit_screen(int container_index) {
     lv_obj_t* btn_cancel = lv_btn_create(container_edit_screen);
     lv_obj_set_size(btn_cancel, (scr_w() - (PAD * 3)) / 2, 44);
     lv_obj_align(btn_cancel, LV_ALIGN_TOP_RIGHT, -PAD, btn_y);
-    style_moto_tile_button(btn_cancel);
+    ui_theme_tile_button(btn_cancel);
     lv_obj_add_event_cb(btn_cancel, event_contedit_cancel, LV_EVENT_CLICKED, NULL);
     lv_obj_t* lbl_cancel = lv_label_create(btn_cancel);
     lv_label_set_text(lbl_cancel, "CANCEL");
@@ -1057,15 +1183,8 @@ static void build_container_edit_screen(int container_index) {
     contedit_kb = lv_keyboard_create(container_edit_screen);
     lv_obj_set_size(contedit_kb, scr_w(), kb_h);
     lv_obj_align(contedit_kb, LV_ALIGN_BOTTOM_MID, 0, 0);
-    lv_keyboard_set_textarea(contedit_kb, contedit_label_ta);
 
-    // Populate
-    lv_textarea_set_text(contedit_label_ta, kc.label.c_str());
-    lv_textarea_set_text(contedit_agency_ta, kc.agency.c_str());
-    lv_textarea_set_text(contedit_band_ta, kc.band.c_str());
-    lv_dropdown_set_selected(contedit_algo_dd, cont_algo_to_index(kc.algo));
-    if (kc.locked) lv_obj_add_state(contedit_locked_cb, LV_STATE_CHECKED);
-    else           lv_obj_clear_state(contedit_locked_cb, LV_STATE_CHECKED);
+    populate_container_edit(kc);
 }
 
 static void event_edit_container(lv_event_t* e) {
@@ -1073,8 +1192,9 @@ static void event_edit_container(lv_event_t* e) {
     if (!check_access(true, "EDIT CONTAINER")) return;
     if (current_container_index < 0) return;
 
+    const NavMark mark = nav_mark();
     build_container_edit_screen(current_container_index);
-    if (container_edit_screen) lv_scr_load(container_edit_screen);
+    if (container_edit_screen) load_screen(container_edit_screen, mark);
 }
 
 // ----------------------
@@ -1094,20 +1214,17 @@ static void event_keyedit_gen_random(lv_event_t* e) {
     char algo[32] = {0};
     lv_dropdown_get_selected_str(keyedit_algo_dd, algo, sizeof(algo));
 
-    size_t key_bytes = 16;
-    if (strstr(algo, "256") != nullptr) key_bytes = 32;
+    // Exactly what the session plan will accept; 16 bytes for "Other".
+    size_t key_bytes = KfdSessionPlan::expectedKeyLength(KfdSessionPlan::algorithmId(algo));
+    if (key_bytes == 0) key_bytes = 16;
 
-    std::string hex;
-    hex.reserve(key_bytes * 2);
+    uint8_t key[32];
+    for (size_t i = 0; i < key_bytes; ++i) key[i] = (uint8_t) esp_random();
 
-    for (size_t i = 0; i < key_bytes; ++i) {
-        uint8_t b = (uint8_t) esp_random();
-        char tmp[3];
-        snprintf(tmp, sizeof(tmp), "%02X", b);
-        hex += tmp;
-    }
+    char hex[2 * sizeof(key) + 1];
+    hexEncode(key, key_bytes, hex, sizeof(hex));
 
-    lv_textarea_set_text(keyedit_key_ta, hex.c_str());
+    lv_textarea_set_text(keyedit_key_ta, hex);
     if (keyedit_status_label) lv_label_set_text(keyedit_status_label, "RANDOM KEY GENERATED");
 }
 
@@ -1128,7 +1245,7 @@ static void event_keyedit_save(lv_event_t* e) {
     ContainerModel& model = ContainerModel::instance();
     if ((size_t)key_edit_container_idx >= model.getCount()) return;
 
-    KeyContainer& kc = model.getMutable(key_edit_container_idx);
+    const KeyContainer& kc = model.get(key_edit_container_idx);
 
     if (kc.locked && current_role != ROLE_ADMIN) {
         if (keyedit_status_label) lv_label_set_text(keyedit_status_label, "CONTAINER LOCKED (ADMIN ONLY)");
@@ -1153,24 +1270,24 @@ static void event_keyedit_save(lv_event_t* e) {
         return;
     }
 
-    std::string clean_hex;
-    clean_hex.reserve(strlen(hex_txt));
-    for (const char* p = hex_txt; *p; ++p) {
-        char c = *p;
-        if (c == ' ' || c == '\n' || c == '\r' || c == '\t') continue;
-        if (c >= 'a' && c <= 'f') c = c - 'a' + 'A';
-        clean_hex.push_back(c);
+    // Whitespace is dropped and digits upper-cased; bad characters are
+    // caught here rather than when the keyload plan is compiled.
+    char   clean_hex[2 * KFD_MAX_KEY_BYTES];
+    size_t clean_len = 0;
+    HexStatus hs = hexCanonicalize(hex_txt, strlen(hex_txt), clean_hex, sizeof(clean_hex), clean_len);
+    if (hs != HEX_OK) {
+        if (keyedit_status_label) lv_label_set_text(keyedit_status_label, hexStatusName(hs));
+        return;
     }
-
-    if (clean_hex.size() % 2 != 0) {
-        if (keyedit_status_label) lv_label_set_text(keyedit_status_label, "HEX LENGTH MUST BE EVEN");
+    if (clean_len == 0) {
+        if (keyedit_status_label) lv_label_set_text(keyedit_status_label, "KEY HEX REQUIRED");
         return;
     }
 
     KeySlot slot;
     slot.label    = label_txt;
     slot.algo     = algo;
-    slot.hex      = clean_hex;
+    slot.hex.assign(clean_hex, clean_len);
     slot.selected = selected;
 
     if (key_edit_key_idx >= 0 && (size_t)key_edit_key_idx < kc.keys.size()) {
@@ -1183,9 +1300,39 @@ static void event_keyedit_save(lv_event_t* e) {
     if (container_detail_screen) lv_scr_load(container_detail_screen);
 }
 
+static uint16_t key_algo_to_index(const std::string& algo) {
+    if (algo == "AES256")   return 0;
+    if (algo == "AES128")   return 1;
+    if (algo == "DES-OFB")  return 2;
+    if (algo == "ADP")      return 3;
+    if (algo == "Other")    return 4;
+    return 0;
+}
+
+// ks is null when adding a key to kc.
+static void populate_key_edit(const KeyContainer& kc, const KeySlot* ks) {
+    lv_label_set_text(keyedit_title, ks ? "EDIT KEY" : "ADD KEY");
+    lv_label_set_text_fmt(keyedit_cont_label, "CONTAINER: %s", kc.label.c_str());
+
+    if (ks) {
+        lv_textarea_set_text(keyedit_label_ta, ks->label.c_str());
+        lv_textarea_set_text(keyedit_key_ta, ks->hex.c_str());
+        if (ks->selected) lv_obj_add_state(keyedit_selected_cb, LV_STATE_CHECKED);
+        else              lv_obj_clear_state(keyedit_selected_cb, LV_STATE_CHECKED);
+        lv_dropdown_set_selected(keyedit_algo_dd, key_algo_to_index(ks->algo));
+    } else {
+        lv_dropdown_set_selected(keyedit_algo_dd, key_algo_to_index(kc.algo));
+        lv_textarea_set_text(keyedit_label_ta, "");
+        lv_textarea_set_text(keyedit_key_ta, "");
+        lv_obj_add_state(keyedit_selected_cb, LV_STATE_CHECKED);
+    }
+
+    lv_label_set_text(keyedit_status_label, "");
+    lv_keyboard_set_textarea(keyedit_kb, keyedit_label_ta);
+    keyedit_active_ta = nullptr;
+}
+
 static void build_key_edit_screen(int container_index, int key_index) {
-    // (kept as-is from your working version; layout already stable due to keyboard docking)
-    // If you want, I can apply the same “computed layout” pattern here too.
     ContainerModel& model = ContainerModel::instance();
     if (container_index < 0 || (size_t)container_index >= model.getCount()) return;
 
@@ -1197,46 +1344,35 @@ static void build_key_edit_screen(int container_index, int key_index) {
     if (key_index >= 0 && (size_t)key_index < kc.keys.size()) ks = &kc.keys[key_index];
 
     if (key_edit_screen) {
-        lv_obj_del(key_edit_screen);
-        key_edit_screen = nullptr;
-        keyedit_label_ta = nullptr;
-        keyedit_algo_dd = nullptr;
-        keyedit_key_ta = nullptr;
-        keyedit_selected_cb = nullptr;
-        keyedit_status_label = nullptr;
-        keyedit_kb = nullptr;
-        keyedit_active_ta = nullptr;
+        populate_key_edit(kc, ks);
+        return;
     }
 
     key_edit_screen = lv_obj_create(NULL);
-    style_moto_screen(key_edit_screen);
+    ui_theme_screen(key_edit_screen);
 
     lv_obj_t* top_bar = lv_obj_create(key_edit_screen);
     lv_obj_set_size(top_bar, scr_w(), TOP_BAR_H);
     lv_obj_align(top_bar, LV_ALIGN_TOP_MID, 0, 0);
     lv_obj_clear_flag(top_bar, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_color(top_bar, lv_color_hex(0x001522), 0);
-    lv_obj_set_style_bg_opa(top_bar, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_width(top_bar, 0, 0);
+    ui_theme_bar(top_bar);
 
-    lv_obj_t* title = lv_label_create(top_bar);
-    lv_label_set_text(title, ks ? "EDIT KEY" : "ADD KEY");
-    lv_obj_set_style_text_color(title, lv_color_hex(0x00C0FF), 0);
-    lv_obj_align(title, LV_ALIGN_LEFT_MID, 8, 0);
+    keyedit_title = lv_label_create(top_bar);
+    lv_obj_set_style_text_color(keyedit_title, lv_color_hex(0x00C0FF), 0);
+    lv_obj_align(keyedit_title, LV_ALIGN_LEFT_MID, 8, 0);
 
     lv_obj_t* btn_back = lv_btn_create(top_bar);
     lv_obj_set_size(btn_back, 90, 30);
     lv_obj_align(btn_back, LV_ALIGN_RIGHT_MID, -4, 0);
-    style_moto_tile_button(btn_back);
+    ui_theme_tile_button(btn_back);
     lv_obj_add_event_cb(btn_back, event_keyedit_cancel, LV_EVENT_CLICKED, NULL);
     lv_obj_t* lbl_back = lv_label_create(btn_back);
     lv_label_set_text(lbl_back, LV_SYMBOL_LEFT " BACK");
     lv_obj_center(lbl_back);
 
-    lv_obj_t* cont_lbl = lv_label_create(key_edit_screen);
-    lv_label_set_text_fmt(cont_lbl, "CONTAINER: %s", kc.label.c_str());
-    lv_obj_set_style_text_color(cont_lbl, lv_color_hex(0xC8F4FF), 0);
-    lv_obj_align(cont_lbl, LV_ALIGN_TOP_LEFT, PAD, TOP_BAR_H + 8);
+    keyedit_cont_label = lv_label_create(key_edit_screen);
+    lv_obj_set_style_text_color(keyedit_cont_label, lv_color_hex(0xC8F4FF), 0);
+    lv_obj_align(keyedit_cont_label, LV_ALIGN_TOP_LEFT, PAD, TOP_BAR_H + 8);
 
     lv_obj_t* lbl_label = lv_label_create(key_edit_screen);
     lv_label_set_text(lbl_label, "Key Label:");
@@ -1277,14 +1413,13 @@ static void build_key_edit_screen(int container_index, int key_index) {
     lv_obj_align(keyedit_selected_cb, LV_ALIGN_TOP_LEFT, PAD, TOP_BAR_H + 220);
 
     keyedit_status_label = lv_label_create(key_edit_screen);
-    lv_label_set_text(keyedit_status_label, "");
     lv_obj_set_style_text_color(keyedit_status_label, lv_color_hex(0xFFD0A0), 0);
     lv_obj_align(keyedit_status_label, LV_ALIGN_TOP_LEFT, PAD, TOP_BAR_H + 246);
 
     lv_obj_t* btn_rand = lv_btn_create(key_edit_screen);
     lv_obj_set_size(btn_rand, 90, 35);
     lv_obj_align(btn_rand, LV_ALIGN_BOTTOM_LEFT, PAD, -90);
-    style_moto_tile_button(btn_rand);
+    ui_theme_tile_button(btn_rand);
     lv_obj_add_event_cb(btn_rand, event_keyedit_gen_random, LV_EVENT_CLICKED, NULL);
     lv_obj_t* lbl_rand = lv_label_create(btn_rand);
     lv_label_set_text(lbl_rand, "RAND");
@@ -1293,7 +1428,7 @@ static void build_key_edit_screen(int container_index, int key_index) {
     lv_obj_t* btn_save = lv_btn_create(key_edit_screen);
     lv_obj_set_size(btn_save, 90, 35);
     lv_obj_align(btn_save, LV_ALIGN_BOTTOM_MID, 0, -90);
-    style_moto_tile_button(btn_save);
+    ui_theme_tile_button(btn_save);
     lv_obj_add_event_cb(btn_save, event_keyedit_save, LV_EVENT_CLICKED, NULL);
     lv_obj_t* lbl_save = lv_label_create(btn_save);
     lv_label_set_text(lbl_save, "SAVE");
@@ -1302,7 +1437,7 @@ static void build_key_edit_screen(int container_index, int key_index) {
     lv_obj_t* btn_cancel = lv_btn_create(key_edit_screen);
     lv_obj_set_size(btn_cancel, 90, 35);
     lv_obj_align(btn_cancel, LV_ALIGN_BOTTOM_RIGHT, -PAD, -90);
-    style_moto_tile_button(btn_cancel);
+    ui_theme_tile_button(btn_cancel);
     lv_obj_add_event_cb(btn_cancel, event_keyedit_cancel, LV_EVENT_CLICKED, NULL);
     lv_obj_t* lbl_cancel = lv_label_create(btn_cancel);
     lv_label_set_text(lbl_cancel, "CANCEL");
@@ -1313,29 +1448,8 @@ static void build_key_edit_screen(int container_index, int key_index) {
     keyedit_kb = lv_keyboard_create(key_edit_screen);
     lv_obj_set_size(keyedit_kb, scr_w(), kb_h);
     lv_obj_align(keyedit_kb, LV_ALIGN_BOTTOM_MID, 0, 0);
-    lv_keyboard_set_textarea(keyedit_kb, keyedit_label_ta);
-
-    auto algo_to_index = [](const std::string& algo) -> uint16_t {
-        if (algo == "AES256")   return 0;
-        if (algo == "AES128")   return 1;
-        if (algo == "DES-OFB")  return 2;
-        if (algo == "ADP")      return 3;
-        if (algo == "Other")    return 4;
-        return 0;
-    };
 
-    if (ks) {
-        lv_textarea_set_text(keyedit_label_ta, ks->label.c_str());
-        lv_textarea_set_text(keyedit_key_ta, ks->hex.c_str());
-        if (ks->selected) lv_obj_add_state(keyedit_selected_cb, LV_STATE_CHECKED);
-        else              lv_obj_clear_state(keyedit_selected_cb, LV_STATE_CHECKED);
-        lv_dropdown_set_selected(keyedit_algo_dd, algo_to_index(ks->algo));
-    } else {
-        lv_dropdown_set_selected(keyedit_algo_dd, algo_to_index(kc.algo));
-        lv_textarea_set_text(keyedit_label_ta, "");
-        lv_textarea_set_text(keyedit_key_ta, "");
-        lv_obj_add_state(keyedit_selected_cb, LV_STATE_CHECKED);
-    }
+    populate_key_edit(kc, ks);
 }
 
 // ----------------------
@@ -1364,30 +1478,131 @@ static void event_add_container(lv_event_t* e) {
     current_container_index = idx;
 
     // Immediately edit (clean flow)
+    const NavMark mark = nav_mark();
     build_container_edit_screen(idx);
-    if (container_edit_screen) lv_scr_load(container_edit_screen);
-
-    update_keyload_container_label();
-    if (keyload_container_dd) rebuild_keyload_container_dropdown();
+    if (container_edit_screen) load_screen(container_edit_screen, mark);
 }
 
 // ----------------------
 // KEYLOAD SCREEN
 // ----------------------
 
-static void keyload_timer_cb(lv_timer_t* t) {
-    (void)t;
-    keyload_progress += 5;
-    if (keyload_progress > 100) {
-        keyload_progress = 100;
-        if (keyload_timer) {
-            lv_timer_del(keyload_timer);
-            keyload_timer = nullptr;
+static void update_keyload_stats() {
+    if (!keyload_stats) return;
+    char buf[160];
+    keyload_tel.format(buf, sizeof(buf));
+    lv_label_set_text(keyload_stats, buf);
+}
+
+static void update_keyload_ports() {
+    const size_t ports = KfdPortScheduler::instance().portCount();
+    if (!keyload_ports || ports < 2) return;
+
+    char buf[64];
+    size_t n = 0;
+    for (size_t i = 0; i < ports && n < sizeof(buf); ++i) {
+        switch (keyload_port_state[i]) {
+            case 0:  n += snprintf(buf + n, sizeof(buf) - n, "P%u --  ", (unsigned)(i + 1)); break;
+            case 3:  n += snprintf(buf + n, sizeof(buf) - n, "P%u ERR  ", (unsigned)(i + 1)); break;
+            case 4:  n += snprintf(buf + n, sizeof(buf) - n, "P%u STOP  ", (unsigned)(i + 1)); break;
+            default: n += snprintf(buf + n, sizeof(buf) - n, "P%u %u%%  ", (unsigned)(i + 1),
+                                   (unsigned)keyload_port_pct[i]); break;
         }
-        if (keyload_status) lv_label_set_text(keyload_status, "KEYLOAD COMPLETE - VERIFY RADIO");
-        if (status_label) lv_label_set_text(status_label, "KEYLOAD COMPLETE");
     }
-    if (keyload_bar) lv_bar_set_value(keyload_bar, keyload_progress, LV_ANIM_ON);
+    lv_label_set_text(keyload_ports, buf);
+}
+
+static void keyload_show_done(const KfdEvent& ev) {
+    if (ev.aborted) {
+        // Exactly what the radio holds: acked keys, plus those that may or may not be.
+        // A line with no receiver acks nothing; its keys were only sent.
+        if (keyload_status) {
+            if (ev.unverified > 0) lv_label_set_text_fmt(keyload_status, "ABORTED: %u/%u KEYS SENT, UNVERIFIED",
+                                                         (unsigned)ev.unverified, (unsigned)ev.telemetry.keysPlanned);
+            else if (ev.inDoubt > 1) lv_label_set_text_fmt(keyload_status, "ABORTED %u/%u - %u KEYS FROM %d IN DOUBT",
+                                                      (unsigned)ev.committed, (unsigned)ev.telemetry.keysPlanned,
+                                                      (unsigned)ev.inDoubt, ev.inDoubtKey + 1);
+            else if (ev.inDoubtKey >= 0) lv_label_set_text_fmt(keyload_status, "ABORTED %u/%u - KEY %d IN DOUBT",
+                                                          (unsigned)ev.committed, (unsigned)ev.telemetry.keysPlanned,
+                                                          ev.inDoubtKey + 1);
+            else lv_label_set_text_fmt(keyload_status, "ABORTED: %u/%u KEYS COMMITTED",
+                                       (unsigned)ev.committed, (unsigned)ev.telemetry.keysPlanned);
+        }
+        if (status_label) lv_label_set_text(status_label, "KEYLOAD ABORTED");
+    } else if (ev.ok) {
+        if (keyload_status) {
+            if (ev.unverified > 0) lv_label_set_text_fmt(keyload_status, "%u KEYS SENT, UNVERIFIED - CHECK RADIO",
+                                                         (unsigned)ev.unverified);
+            else if (ev.okPorts > 1) lv_label_set_text_fmt(keyload_status, "KEYLOAD COMPLETE %u RADIOS - VERIFY", (unsigned)ev.okPorts);
+            else lv_label_set_text(keyload_status, "KEYLOAD COMPLETE - VERIFY RADIO");
+        }
+        if (status_label) lv_label_set_text(status_label, ev.unverified > 0 ? "KEYS SENT, UNVERIFIED" : "KEYLOAD COMPLETE");
+    } else {
+        // The event carries the first failed port; the per-port line shows the rest.
+        if (keyload_status) lv_label_set_text_fmt(keyload_status, "KEYLOAD FAILED: %s",
+                                                  ev.failure ? ev.failure : "UNKNOWN");
+        if (status_label) lv_label_set_text_fmt(status_label, "KEYLOAD FAILED %u/%u",
+                                                (unsigned)(ev.ports - ev.okPorts), (unsigned)ev.ports);
+    }
+}
+
+bool ui_keyload_running(void) {
+    return keyload_running || keyload_pending;
+}
+
+// Drain protocol task events into the keyload screen. Called from the
+// Arduino loop; the protocol itself runs on its own core.
+void ui_poll_kfd_events(void) {
+    KfdEvent ev;
+    while (KfdProtocolTask::instance().pollEvent(ev)) {
+        switch (ev.type) {
+            case KfdEvent::STARTED:
+                keyload_pending = false;
+                keyload_running = true;
+                for (size_t i = 0; i < KFD_MAX_PORTS; ++i) {
+                    keyload_port_pct[i]   = 0;
+                    keyload_port_state[i] = ((ev.portMask >> i) & 1u) ? 1 : 0;
+                }
+                break;
+
+            case KfdEvent::REJECTED:
+                keyload_pending = false;
+                if (keyload_status) {
+                    if (ev.aborted) lv_label_set_text(keyload_status, "KEYLOAD CANCELLED");
+                    else if (ev.planResult == KfdSessionPlan::OK) lv_label_set_text(keyload_status, "KEYLOAD ALREADY RUNNING");
+                    else lv_label_set_text_fmt(keyload_status, "REJECTED: %s",
+                                               KfdSessionPlan::resultName((KfdSessionPlan::Result)ev.planResult));
+                }
+                continue;
+
+            case KfdEvent::PROGRESS:
+                keyload_port_pct[ev.port] = ev.percent;
+                break;
+
+            case KfdEvent::PORT_DONE:
+                keyload_port_pct[ev.port]   = ev.percent;
+                keyload_port_state[ev.port] = ev.ok ? 2 : (ev.aborted ? 4 : 3);
+                break;
+
+            case KfdEvent::SESSION_DONE:
+                keyload_running = false;
+                keyload_show_done(ev);
+                break;
+        }
+
+        keyload_tel = ev.telemetry;
+
+        unsigned sum = 0, n = 0;
+        for (size_t i = 0; i < KFD_MAX_PORTS; ++i) {
+            if (!keyload_port_state[i]) continue;
+            sum += keyload_port_pct[i];
+            n++;
+        }
+        keyload_progress = n ? (int)(sum / n) : 0;
+        if (keyload_bar) lv_bar_set_value(keyload_bar, keyload_progress, LV_ANIM_ON);
+        update_keyload_stats();
+        update_keyload_ports();
+    }
 }
 
 static void event_keyload_container_changed(lv_event_t* e) {
@@ -1395,21 +1610,22 @@ static void event_keyload_container_changed(lv_event_t* e) {
     if (!keyload_container_dd) return;
 
     ContainerModel& model = ContainerModel::instance();
-    size_t count = model.getCount();
-    if (count == 0) return;
+    const uint16_t sel = lv_dropdown_get_selected(keyload_container_dd);
+    if (sel >= keyload_dd_map.size() || keyload_dd_map[sel] < 0) return;
 
-    uint16_t sel = lv_dropdown_get_selected(keyload_container_dd);
-    if ((size_t)sel >= count) sel = 0;
+    model.setActiveIndex(keyload_dd_map[sel]);
 
-    model.setActiveIndex((int)sel);
-
-    update_keyload_container_label();
     if (status_label) {
         const KeyContainer* kc = model.getActive();
         if (kc) lv_label_set_text_fmt(status_label, "ACTIVE SET: %s", kc->label.c_str());
     }
 }
 
+static void event_keyload_search(lv_event_t* e) {
+    (void)e;
+    rebuild_keyload_container_dropdown();
+}
+
 static void event_btn_keyload_start(lv_event_t* e) {
     (void)e;
 
@@ -1423,50 +1639,58 @@ static void event_btn_keyload_start(lv_event_t* e) {
         return;
     }
 
+    const KfdLoadMode mode = (keyload_full_cb && lv_obj_has_state(keyload_full_cb, LV_STATE_CHECKED))
+                             ? KFD_LOAD_FULL : KFD_LOAD_DELTA;
+    if (keyload_running || keyload_pending || !KfdProtocolTask::instance().requestKeyload(*kc, mode)) {
+        if (keyload_status) lv_label_set_text(keyload_status, "KEYLOAD ALREADY RUNNING");
+        return;
+    }
+    keyload_pending = true;
+
     keyload_progress = 0;
     if (keyload_bar) lv_bar_set_value(keyload_bar, 0, LV_ANIM_OFF);
 
     if (keyload_status) lv_label_set_text_fmt(keyload_status, "KEYLOAD: %s", kc->label.c_str());
+}
+
+// Always allowed: the operator must be able to free the radio at once.
+static void event_btn_keyload_cancel(lv_event_t* e) {
+    (void)e;
+    if (!keyload_running && !keyload_pending) return;
 
-    if (!keyload_timer) keyload_timer = lv_timer_create(keyload_timer_cb, 200, NULL);
+    KfdProtocolTask::instance().requestAbort();
+    if (keyload_status) lv_label_set_text(keyload_status, "ABORTING...");
 }
 
+// Progress, status and stats are kept across visits; they are updated
+// from ui_poll_kfd_events() whether or not the screen is showing, and the
+// container dropdown from ui_on_model_events().
 static void build_keyload_screen(void) {
-    if (keyload_screen) {
-        lv_obj_del(keyload_screen);
-        keyload_screen = nullptr;
-        keyload_container_dd = nullptr;
-        keyload_container_label = nullptr;
-        keyload_status = nullptr;
-        keyload_bar = nullptr;
-    }
+    if (keyload_screen) return;
 
     // Fonts (optional; comment out if not enabled)
     extern const lv_font_t lv_font_montserrat_20;
     extern const lv_font_t lv_font_montserrat_16;
 
     keyload_screen = lv_obj_create(NULL);
-    style_moto_screen(keyload_screen);
+    ui_theme_screen(keyload_screen);
 
     // Top bar
     lv_obj_t* top_bar = lv_obj_create(keyload_screen);
     lv_obj_set_size(top_bar, scr_w(), TOP_BAR_H);
     lv_obj_align(top_bar, LV_ALIGN_TOP_MID, 0, 0);
     lv_obj_clear_flag(top_bar, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_color(top_bar, lv_color_hex(0x001522), 0);
-    lv_obj_set_style_bg_opa(top_bar, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_width(top_bar, 0, 0);
+    ui_theme_bar(top_bar);
 
     lv_obj_t* title = lv_label_create(top_bar);
     lv_label_set_text(title, "KEYLOAD CONSOLE");
-    lv_obj_set_style_text_color(title, lv_color_hex(0x00C0FF), 0);
-    lv_obj_set_style_text_font(title, &lv_font_montserrat_20, 0);
+    ui_theme_title(title);
     lv_obj_align(title, LV_ALIGN_LEFT_MID, 8, 0);
 
     lv_obj_t* btn_back = lv_btn_create(top_bar);
     lv_obj_set_size(btn_back, 92, 32);
     lv_obj_align(btn_back, LV_ALIGN_RIGHT_MID, -6, 0);
-    style_moto_tile_button(btn_back);
+    ui_theme_tile_button(btn_back);
     lv_obj_add_event_cb(btn_back, show_home_screen, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_back = lv_label_create(btn_back);
@@ -1490,7 +1714,7 @@ static void build_keyload_screen(void) {
     lv_obj_set_size(panel, panel_w, panel_h);
     lv_obj_align(panel, LV_ALIGN_TOP_MID, 0, top_content);
     lv_obj_clear_flag(panel, LV_OBJ_FLAG_SCROLLABLE);
-    style_moto_panel(panel);
+    ui_theme_panel(panel);
 
     lv_obj_t* info = lv_label_create(panel);
     lv_label_set_text(info,
@@ -1502,23 +1726,34 @@ static void build_keyload_screen(void) {
     lv_obj_set_style_text_font(info, &lv_font_montserrat_16, 0);
     lv_obj_align(info, LV_ALIGN_TOP_LEFT, 2, 2);
 
+    // Options row under the info block: search left, full reload right.
+    keyload_search = create_search_field(keyload_screen, panel, 120, event_keyload_search);
+    lv_obj_align(keyload_search, LV_ALIGN_TOP_LEFT, 2, 62);
+
+    // Unchecked: only keys the radio is missing or holds stale are sent.
+    keyload_full_cb = lv_checkbox_create(panel);
+    lv_checkbox_set_text(keyload_full_cb, "FULL RELOAD");
+    lv_obj_set_style_text_color(keyload_full_cb, lv_color_hex(0xC8F4FF), 0);
+    lv_obj_set_style_text_font(keyload_full_cb, &lv_font_montserrat_16, 0);
+    lv_obj_align(keyload_full_cb, LV_ALIGN_TOP_RIGHT, -2, 67);
+
     // Container row (label + dropdown) with clean spacing
     lv_obj_t* dd_lbl = lv_label_create(panel);
     lv_label_set_text(dd_lbl, "Container:");
     lv_obj_set_style_text_color(dd_lbl, lv_color_hex(0x80E0FF), 0);
     lv_obj_set_style_text_font(dd_lbl, &lv_font_montserrat_16, 0);
-    lv_obj_align(dd_lbl, LV_ALIGN_TOP_LEFT, 2, 86);
+    lv_obj_align(dd_lbl, LV_ALIGN_TOP_LEFT, 2, 110);
 
     keyload_container_dd = lv_dropdown_create(panel);
     lv_obj_set_size(keyload_container_dd, panel_w - 110, 34);
-    lv_obj_align(keyload_container_dd, LV_ALIGN_TOP_LEFT, 98, 80);
+    lv_obj_align(keyload_container_dd, LV_ALIGN_TOP_LEFT, 98, 104);
     lv_obj_add_event_cb(keyload_container_dd, event_keyload_container_changed, LV_EVENT_VALUE_CHANGED, NULL);
 
     // Active container line (below dropdown)
     keyload_container_label = lv_label_create(panel);
     lv_obj_set_style_text_color(keyload_container_label, lv_color_hex(0x80E0FF), 0);
     lv_obj_set_style_text_font(keyload_container_label, &lv_font_montserrat_16, 0);
-    lv_obj_align(keyload_container_label, LV_ALIGN_TOP_LEFT, 2, 128);
+    lv_obj_align(keyload_container_label, LV_ALIGN_TOP_LEFT, 2, 146);
 
     rebuild_keyload_container_dropdown();
     update_keyload_container_label();
@@ -1542,17 +1777,46 @@ static void build_keyload_screen(void) {
     lv_obj_set_style_text_font(keyload_status, &lv_font_montserrat_16, 0);
     lv_obj_align(keyload_status, LV_ALIGN_TOP_MID, 0, after_panel_y + 32);
 
-    // Start button (bigger and with clear margin)
+    keyload_stats = lv_label_create(keyload_screen);
+    lv_label_set_text(keyload_stats, "");
+    lv_obj_set_style_text_color(keyload_stats, lv_color_hex(0x80E0FF), 0);
+    lv_obj_align(keyload_stats, LV_ALIGN_TOP_LEFT, PAD, after_panel_y + 80);
+    if (keyload_tel.sessionId != 0) update_keyload_stats();
+
+    // One progress figure per radio; only on boards with several 3WI ports.
+    if (KfdPortScheduler::instance().portCount() > 1) {
+        keyload_ports = lv_label_create(keyload_screen);
+        lv_label_set_text(keyload_ports, "");
+        lv_obj_set_style_text_color(keyload_ports, lv_color_hex(0xFFFFFF), 0);
+        lv_obj_align(keyload_ports, LV_ALIGN_TOP_LEFT, PAD, after_panel_y + 58);
+        update_keyload_ports();
+    }
+
+    // Start button (bigger and with clear margin), cancel beside it
+    const int cancel_w = 104;
+
     lv_obj_t* btn_start = lv_btn_create(keyload_screen);
-    lv_obj_set_size(btn_start, panel_w, start_h);
-    lv_obj_align(btn_start, LV_ALIGN_BOTTOM_MID, 0, -PAD);
-    style_moto_tile_button(btn_start);
+    lv_obj_set_size(btn_start, panel_w - cancel_w - 8, start_h);
+    lv_obj_align(btn_start, LV_ALIGN_BOTTOM_LEFT, PAD, -PAD);
+    ui_theme_tile_button(btn_start);
     lv_obj_add_event_cb(btn_start, event_btn_keyload_start, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_start = lv_label_create(btn_start);
     lv_label_set_text(lbl_start, LV_SYMBOL_PLAY "  START LOAD");
     lv_obj_set_style_text_font(lbl_start, &lv_font_montserrat_20, 0);
     lv_obj_center(lbl_start);
+
+    lv_obj_t* btn_cancel = lv_btn_create(keyload_screen);
+    lv_obj_set_size(btn_cancel, cancel_w, start_h);
+    lv_obj_align(btn_cancel, LV_ALIGN_BOTTOM_RIGHT, -PAD, -PAD);
+    ui_theme_tile_button(btn_cancel);
+    lv_obj_set_style_border_color(btn_cancel, lv_color_hex(0xFF5050), LV_PART_MAIN);
+    lv_obj_add_event_cb(btn_cancel, event_btn_keyload_cancel, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t* lbl_cancel = lv_label_create(btn_cancel);
+    lv_label_set_text(lbl_cancel, LV_SYMBOL_STOP " STOP");
+    lv_obj_set_style_text_font(lbl_cancel, &lv_font_montserrat_20, 0);
+    lv_obj_center(lbl_cancel);
 }
 
 
@@ -1562,17 +1826,15 @@ static void build_keyload_screen(void) {
 // (left as in your working version; can be cleaned similarly if desired)
 
 static void build_settings_screen(void) {
-    if (settings_screen) { lv_obj_del(settings_screen); settings_screen = nullptr; }
+    if (settings_screen) return;  // nothing on it follows the model
     settings_screen = lv_obj_create(NULL);
-    style_moto_screen(settings_screen);
+    ui_theme_screen(settings_screen);
 
     lv_obj_t* top_bar = lv_obj_create(settings_screen);
     lv_obj_set_size(top_bar, scr_w(), TOP_BAR_H);
     lv_obj_align(top_bar, LV_ALIGN_TOP_MID, 0, 0);
     lv_obj_clear_flag(top_bar, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_color(top_bar, lv_color_hex(0x001522), 0);
-    lv_obj_set_style_bg_opa(top_bar, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_width(top_bar, 0, 0);
+    ui_theme_bar(top_bar);
 
     lv_obj_t* title = lv_label_create(top_bar);
     lv_label_set_text(title, "SECURITY / SETTINGS");
@@ -1582,7 +1844,7 @@ static void build_settings_screen(void) {
     lv_obj_t* btn_back = lv_btn_create(top_bar);
     lv_obj_set_size(btn_back, 90, 30);
     lv_obj_align(btn_back, LV_ALIGN_RIGHT_MID, -4, 0);
-    style_moto_tile_button(btn_back);
+    ui_theme_tile_button(btn_back);
     lv_obj_add_event_cb(btn_back, show_home_screen, LV_EVENT_CLICKED, NULL);
     lv_obj_t* lbl_back = lv_label_create(btn_back);
     lv_label_set_text(lbl_back, LV_SYMBOL_LEFT " HOME");
@@ -1606,7 +1868,7 @@ static void build_settings_screen(void) {
     lv_obj_t* btn_save = lv_btn_create(settings_screen);
     lv_obj_set_size(btn_save, scr_w() - (PAD * 2), 50);
     lv_obj_align(btn_save, LV_ALIGN_BOTTOM_MID, 0, -80);
-    style_moto_tile_button(btn_save);
+    ui_theme_tile_button(btn_save);
     lv_obj_add_event_cb(btn_save, event_btn_save_now, LV_EVENT_CLICKED, NULL);
     lv_obj_t* lbl_save = lv_label_create(btn_save);
     lv_label_set_text(lbl_save, "SAVE CONTAINERS NOW");
@@ -1615,7 +1877,7 @@ static void build_settings_screen(void) {
     lv_obj_t* btn_factory = lv_btn_create(settings_screen);
     lv_obj_set_size(btn_factory, scr_w() - (PAD * 2), 50);
     lv_obj_align(btn_factory, LV_ALIGN_BOTTOM_MID, 0, -20);
-    style_moto_tile_button(btn_factory);
+    ui_theme_tile_button(btn_factory);
     lv_obj_add_event_cb(btn_factory, event_btn_factory_reset, LV_EVENT_CLICKED, NULL);
     lv_obj_t* lbl_factory = lv_label_create(btn_factory);
     lv_label_set_text(lbl_factory, "FACTORY RESET (ERASE)");
@@ -1636,10 +1898,14 @@ static void set_pending_role(UserRole role, const char* label_text) {
 }
 
 static void build_user_screen(void) {
-    if (user_screen) { lv_obj_del(user_screen); user_screen = nullptr; }
+    if (user_screen) {
+        set_pending_role(ROLE_NONE, "LOGIN: (SELECT ROLE)");
+        lv_label_set_text(user_status_label, "SELECT ROLE");
+        return;
+    }
 
     user_screen = lv_obj_create(NULL);
-    style_moto_screen(user_screen);
+    ui_theme_screen(user_screen);
 
     // Fonts (optional; comment out if not enabled)
     extern const lv_font_t lv_font_montserrat_20;
@@ -1650,20 +1916,17 @@ static void build_user_screen(void) {
     lv_obj_set_size(top_bar, scr_w(), TOP_BAR_H);
     lv_obj_align(top_bar, LV_ALIGN_TOP_MID, 0, 0);
     lv_obj_clear_flag(top_bar, LV_OBJ_FLAG_SCROLLABLE);
-    lv_obj_set_style_bg_color(top_bar, lv_color_hex(0x001522), 0);
-    lv_obj_set_style_bg_opa(top_bar, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_width(top_bar, 0, 0);
+    ui_theme_bar(top_bar);
 
     lv_obj_t* title = lv_label_create(top_bar);
     lv_label_set_text(title, "USER LOGIN / ROLE");
-    lv_obj_set_style_text_color(title, lv_color_hex(0x00C0FF), 0);
-    lv_obj_set_style_text_font(title, &lv_font_montserrat_20, 0);
+    ui_theme_title(title);
     lv_obj_align(title, LV_ALIGN_LEFT_MID, 8, 0);
 
     lv_obj_t* btn_back = lv_btn_create(top_bar);
     lv_obj_set_size(btn_back, 92, 32);
     lv_obj_align(btn_back, LV_ALIGN_RIGHT_MID, -6, 0);
-    style_moto_tile_button(btn_back);
+    ui_theme_tile_button(btn_back);
     lv_obj_add_event_cb(btn_back, show_home_screen, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_back = lv_label_create(btn_back);
@@ -1697,7 +1960,7 @@ static void build_user_screen(void) {
     lv_obj_t* btn_admin = lv_btn_create(user_screen);
     lv_obj_set_size(btn_admin, 140, role_h);
     lv_obj_align(btn_admin, LV_ALIGN_TOP_MID, -(140/2 + 10), start_y);
-    style_moto_tile_button(btn_admin);
+    ui_theme_tile_button(btn_admin);
     lv_obj_add_event_cb(btn_admin, event_select_admin, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_admin = lv_label_create(btn_admin);
@@ -1708,7 +1971,7 @@ static void build_user_screen(void) {
     lv_obj_t* btn_operator = lv_btn_create(user_screen);
     lv_obj_set_size(btn_operator, 140, role_h);
     lv_obj_align(btn_operator, LV_ALIGN_TOP_MID, +(140/2 + 10), start_y);
-    style_moto_tile_button(btn_operator);
+    ui_theme_tile_button(btn_operator);
     lv_obj_add_event_cb(btn_operator, event_select_operator, LV_EVENT_CLICKED, NULL);
 
     lv_obj_t* lbl_operator = lv_label_create(btn_operator);
@@ -1775,7 +2038,7 @@ static void build_user_screen(void) {
             int yy = grid_top + row * (btn_h + row_gap);
 
             lv_obj_align(btn, LV_ALIGN_TOP_LEFT, x, yy);
-            style_moto_tile_button(btn);
+            ui_theme_tile_button(btn);
 
             lv_obj_t* lbl = lv_label_create(btn);
             lv_label_set_text(lbl, txt);
@@ -1852,6 +2115,96 @@ static void event_keypad_ok(lv_event_t* e) {
     }
 }
 
+// ----------------------
+// Model events
+// ----------------------
+
+// Where the container at `idx` is after `e`; -1 once it is gone.
+static int follow_container(int idx, const ModelEvent& e) {
+    if (idx < 0) return idx;
+    switch (e.type) {
+        case ModelEventType::Reloaded:
+            return -1;
+        case ModelEventType::ContainerRemoved:
+            if (idx == e.container) return -1;
+            return idx > e.container ? idx - 1 : idx;
+        case ModelEventType::ContainerMoved:
+            if (idx == e.container) return e.key;
+            if (e.container < idx && idx <= e.key) return idx - 1;
+            if (e.key <= idx && idx < e.container) return idx + 1;
+            return idx;
+        default:
+            return idx;
+    }
+}
+
+// One frame's model changes. Single-row edits are drawn straight away;
+// anything that reshapes a list is noted and applied once at the end.
+static void ui_on_model_events(const ModelEvent* events, size_t count, void* ctx) {
+    (void)ctx;
+
+    bool reshaped     = false;  // containers added, removed, moved, reloaded
+    bool relabelled   = false;  // a container's own fields changed
+    bool active       = false;
+    bool detail_meta  = false;
+    bool detail_keys  = false;  // keys added or removed on the detail screen
+
+    for (size_t i = 0; i < count; ++i) {
+        const ModelEvent& e = events[i];
+        detail_index            = follow_container(detail_index, e);
+        current_container_index = follow_container(current_container_index, e);
+
+        switch (e.type) {
+            case ModelEventType::Reloaded:
+                active = true;
+                // fall through
+            case ModelEventType::ContainerAdded:
+            case ModelEventType::ContainerRemoved:
+            case ModelEventType::ContainerMoved:
+                reshaped = true;
+                break;
+            case ModelEventType::ContainerUpdated:
+                relabelled = true;
+                if (!reshaped && !containers_filtered)
+                    ui_vlist_refresh_item(containers_list, (size_t)e.container);
+                if (e.container == detail_index) detail_meta = true;
+                break;
+            case ModelEventType::KeyAdded:
+            case ModelEventType::KeyRemoved:
+                if (e.container == detail_index) detail_keys = true;
+                break;
+            case ModelEventType::KeyUpdated:
+                if (e.container == detail_index && !detail_keys)
+                    ui_vlist_refresh_item(container_keys_list, (size_t)e.key);
+                break;
+            case ModelEventType::ActiveChanged:
+                active = true;
+                break;
+        }
+    }
+
+    // The search index has already taken these events in; a filtered list
+    // is re-run whenever they changed anything searchable.
+    static uint32_t search_gen = 0;
+    const uint32_t  gen        = ContainerSearch::instance().generation();
+    const bool      searched   = gen != search_gen;
+    search_gen = gen;
+    if (containers_filtered ? searched : reshaped) apply_containers_filter();
+
+    const bool keyload_filtered = keyload_search && lv_textarea_get_text(keyload_search)[0] != '\0';
+    if (reshaped || relabelled || active || (keyload_filtered && searched)) {
+        rebuild_keyload_container_dropdown();
+    }
+    if (reshaped || relabelled || active) update_keyload_container_label();
+
+    if (detail_index >= 0) {
+        if (detail_meta) fill_container_detail_meta(detail_index);
+        if (detail_keys) rebuild_container_keys_list(detail_index);
+    }
+
+    KLOGD(UI, "model: %u events, reshaped %d", (unsigned)count, (int)reshaped);
+}
+
 // ----------------------
 // Navigation
 // ----------------------
@@ -1868,32 +2221,33 @@ static void show_home_screen(lv_event_t* e) {
 static void event_btn_keys(lv_event_t* e) {
     (void)e;
     if (!check_access(false, "CONTAINER VIEW OPEN")) return;
+    const NavMark mark = nav_mark();
     build_containers_screen();
-    if (containers_screen) lv_scr_load(containers_screen);
+    if (containers_screen) load_screen(containers_screen, mark);
 }
 
 static void event_btn_keyload(lv_event_t* e) {
     (void)e;
     if (!check_access(false, "KEYLOAD CONSOLE OPEN")) return;
+    const NavMark mark = nav_mark();
     build_keyload_screen();
-    if (keyload_screen) {
-        update_keyload_container_label();
-        lv_scr_load(keyload_screen);
-    }
+    if (keyload_screen) load_screen(keyload_screen, mark);
 }
 
 static void event_btn_settings(lv_event_t* e) {
     (void)e;
     if (!check_access(true, "SETTINGS OPEN")) return;
+    const NavMark mark = nav_mark();
     build_settings_screen();
-    if (settings_screen) lv_scr_load(settings_screen);
+    if (settings_screen) load_screen(settings_screen, mark);
 }
 
 static void event_btn_user_manager(lv_event_t* e) {
     (void)e;
     if (status_label) lv_label_set_text(status_label, "USER LOGIN SCREEN");
+    const NavMark mark = nav_mark();
     build_user_screen();
-    if (user_screen) lv_scr_load(user_screen);
+    if (user_screen) load_screen(user_screen, mark);
 }
 
 // ----------------------
@@ -1901,6 +2255,9 @@ static void event_btn_user_manager(lv_event_t* e) {
 // ----------------------
 
 void ui_init(void) {
+    ui_theme_init();
+    ContainerModel::instance().addObserver(ui_on_model_events, nullptr);
+    const NavMark mark = nav_mark();
     build_home_screen();
-    lv_scr_load(home_screen);
+    load_screen(home_screen, mark);
 }
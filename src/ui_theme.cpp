@@ -0,0 +1,69 @@
+#include "ui_theme.h"
+
+static lv_style_t style_screen;
+static lv_style_t style_panel;
+static lv_style_t style_tile;
+static lv_style_t style_tile_pressed;
+static lv_style_t style_bar;
+static lv_style_t style_title;
+
+static bool theme_ready = false;
+
+void ui_theme_init(void) {
+    if (theme_ready) return;
+    theme_ready = true;
+
+    lv_style_init(&style_screen);
+    lv_style_set_bg_color(&style_screen, lv_color_black());
+    lv_style_set_bg_opa(&style_screen, LV_OPA_COVER);
+
+    lv_style_init(&style_panel);
+    lv_style_set_bg_color(&style_panel, lv_color_hex(0x05121A));
+    lv_style_set_bg_opa(&style_panel, LV_OPA_COVER);
+    lv_style_set_border_color(&style_panel, lv_color_hex(0x00C0FF));
+    lv_style_set_border_width(&style_panel, 1);
+    lv_style_set_radius(&style_panel, 4);
+    lv_style_set_pad_all(&style_panel, 6);
+
+    lv_style_init(&style_tile);
+    lv_style_set_bg_color(&style_tile, lv_color_hex(0x10202A));
+    lv_style_set_bg_opa(&style_tile, LV_OPA_COVER);
+    lv_style_set_border_color(&style_tile, lv_color_hex(0x00C0FF));
+    lv_style_set_border_width(&style_tile, 2);
+    lv_style_set_radius(&style_tile, 4);
+    lv_style_set_shadow_width(&style_tile, 0);
+
+    lv_style_init(&style_tile_pressed);
+    lv_style_set_bg_color(&style_tile_pressed, lv_color_hex(0x1C3A4A));
+
+    lv_style_init(&style_bar);
+    lv_style_set_bg_color(&style_bar, lv_color_hex(0x001522));
+    lv_style_set_bg_opa(&style_bar, LV_OPA_COVER);
+    lv_style_set_border_width(&style_bar, 0);
+
+    lv_style_init(&style_title);
+    lv_style_set_text_color(&style_title, lv_color_hex(0x00C0FF));
+    lv_style_set_text_font(&style_title, &lv_font_montserrat_20);
+}
+
+void ui_theme_screen(lv_obj_t* scr) {
+    lv_obj_remove_style_all(scr);
+    lv_obj_add_style(scr, &style_screen, 0);
+}
+
+void ui_theme_panel(lv_obj_t* obj) {
+    lv_obj_add_style(obj, &style_panel, 0);
+}
+
+void ui_theme_tile_button(lv_obj_t* btn) {
+    lv_obj_add_style(btn, &style_tile, LV_PART_MAIN);
+    lv_obj_add_style(btn, &style_tile_pressed, LV_PART_MAIN | LV_STATE_PRESSED);
+}
+
+void ui_theme_bar(lv_obj_t* bar) {
+    lv_obj_add_style(bar, &style_bar, 0);
+}
+
+void ui_theme_title(lv_obj_t* label) {
+    lv_obj_add_style(label, &style_title, 0);
+}
@@ -0,0 +1,223 @@
+#include "ui_vlist.h"
+
+#include <stdint.h>
+
+// lv_coord_t is 16 bits here (LV_USE_LARGE_COORD 0) and LVGL keeps
+// coordinates below 8191, so the scrollable height cannot simply be
+// count * pitch. The list scrolls over a window of items at most
+// VLIST_SPAN pixels tall; when the view nears either end of the window,
+// the window slides by half its length and the scroll offset is moved by
+// the same amount, so nothing visible jumps. A drag or throw in progress
+// carries on: LVGL applies those as relative scroll steps.
+static constexpr lv_coord_t VLIST_SPAN = 6000;
+
+static constexpr size_t VLIST_UNBOUND = SIZE_MAX;
+
+struct VList {
+    lv_obj_t*  spacer   = nullptr;  // sets the scrollable height
+    lv_obj_t** rows     = nullptr;
+    size_t*    bound    = nullptr;  // item shown by each row, or VLIST_UNBOUND
+    size_t     pool     = 0;
+    size_t     count    = 0;
+    size_t     base     = 0;        // first item of the scroll window
+    size_t     window   = 0;        // items in the scroll window
+    lv_coord_t row_h    = 0;
+    lv_coord_t pitch    = 0;
+    bool       shifting = false;
+
+    ui_vlist_text_cb_t  text_cb  = nullptr;
+    ui_vlist_click_cb_t click_cb = nullptr;
+};
+
+static VList* vlist_of(lv_obj_t* list) {
+    return list ? static_cast<VList*>(lv_obj_get_user_data(list)) : nullptr;
+}
+
+static void vlist_draw_row(VList* vl, size_t r, size_t item) {
+    lv_obj_t* row = vl->rows[r];
+    char buf[UI_VLIST_TEXT_MAX];
+    buf[0] = '\0';
+    vl->text_cb(item, buf, sizeof(buf));
+    lv_label_set_text(lv_obj_get_child(row, -1), buf);
+    lv_obj_set_y(row, (lv_coord_t)((item - vl->base) * vl->pitch));
+    lv_obj_clear_flag(row, LV_OBJ_FLAG_HIDDEN);
+    vl->bound[r] = item;
+}
+
+// Item i always lives in row i % pool. Any pool consecutive items map to
+// distinct rows, so scrolling only redraws the rows that came into view.
+static void vlist_bind(lv_obj_t* list, VList* vl, bool redraw) {
+    lv_coord_t sy = lv_obj_get_scroll_y(list);
+    if (sy < 0) sy = 0;
+    const size_t first = vl->base + (size_t)(sy / vl->pitch);
+
+    for (size_t item = first; item < first + vl->pool; ++item) {
+        const size_t r = item % vl->pool;
+        if (item >= vl->base + vl->window) {
+            if (vl->bound[r] != VLIST_UNBOUND) {
+                lv_obj_add_flag(vl->rows[r], LV_OBJ_FLAG_HIDDEN);
+                vl->bound[r] = VLIST_UNBOUND;
+            }
+            continue;
+        }
+        if (redraw || vl->bound[r] != item) vlist_draw_row(vl, r, item);
+    }
+}
+
+static void vlist_set_window(VList* vl) {
+    const size_t span_items = (size_t)(VLIST_SPAN / vl->pitch);
+    vl->window = vl->count < span_items ? vl->count : span_items;
+    if (vl->base + vl->window > vl->count) vl->base = vl->count - vl->window;
+    lv_obj_set_height(vl->spacer, (lv_coord_t)(vl->window * vl->pitch));
+}
+
+// Slide the window when the view is within a pool's height of its edge.
+static void vlist_slide(lv_obj_t* list, VList* vl) {
+    if (vl->window == vl->count) return;
+
+    const lv_coord_t sy     = lv_obj_get_scroll_y(list);
+    const lv_coord_t margin = (lv_coord_t)(vl->pool * vl->pitch);
+    const lv_coord_t span   = (lv_coord_t)(vl->window * vl->pitch);
+    const size_t     half   = vl->window / 2;
+
+    ptrdiff_t delta = 0;
+    if (sy < margin && vl->base > 0) {
+        delta = -(ptrdiff_t)(vl->base < half ? vl->base : half);
+    } else if (sy + lv_obj_get_height(list) > span - margin && vl->base + vl->window < vl->count) {
+        const size_t left = vl->count - (vl->base + vl->window);
+        delta = (ptrdiff_t)(left < half ? left : half);
+    }
+    if (delta == 0) return;
+
+    vl->base = (size_t)((ptrdiff_t)vl->base + delta);
+    vl->shifting = true;
+    lv_obj_scroll_to_y(list, (lv_coord_t)(sy - delta * vl->pitch), LV_ANIM_OFF);
+    vl->shifting = false;
+
+    // Row offsets are relative to the window base.
+    for (size_t r = 0; r < vl->pool; ++r) {
+        if (vl->bound[r] != VLIST_UNBOUND)
+            lv_obj_set_y(vl->rows[r], (lv_coord_t)((vl->bound[r] - vl->base) * vl->pitch));
+    }
+}
+
+static void vlist_event(lv_event_t* e) {
+    lv_obj_t* list = lv_event_get_current_target(e);
+    VList*    vl   = vlist_of(list);
+    if (!vl) return;
+
+    if (lv_event_get_code(e) == LV_EVENT_SCROLL) {
+        if (vl->shifting) return;
+        vlist_slide(list, vl);
+        vlist_bind(list, vl, false);
+        return;
+    }
+
+    // LV_EVENT_DELETE
+    lv_obj_set_user_data(list, nullptr);
+    delete[] vl->rows;
+    delete[] vl->bound;
+    delete vl;
+}
+
+static void vlist_row_clicked(lv_event_t* e) {
+    lv_obj_t* row = lv_event_get_current_target(e);
+    VList*    vl  = vlist_of(lv_obj_get_parent(row));
+    if (!vl || !vl->click_cb) return;
+
+    for (size_t r = 0; r < vl->pool; ++r) {
+        if (vl->rows[r] == row) {
+            if (vl->bound[r] != VLIST_UNBOUND) vl->click_cb(vl->bound[r]);
+            return;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Public API
+// -----------------------------------------------------------------------------
+
+lv_obj_t* ui_vlist_create(lv_obj_t* parent, lv_coord_t w, lv_coord_t h,
+                          lv_coord_t row_h, lv_coord_t row_gap, const char* icon,
+                          ui_vlist_style_cb_t style_cb,
+                          ui_vlist_text_cb_t text_cb, ui_vlist_click_cb_t click_cb) {
+    VList* vl    = new VList();
+    vl->row_h    = row_h;
+    vl->pitch    = row_h + row_gap;
+    vl->pool     = (size_t)(h / vl->pitch) + 2;
+    vl->rows     = new lv_obj_t*[vl->pool];
+    vl->bound    = new size_t[vl->pool];
+    vl->text_cb  = text_cb;
+    vl->click_cb = click_cb;
+
+    // A plain object: no flex layout, rows are placed by hand.
+    lv_obj_t* list = lv_obj_create(parent);
+    lv_obj_set_size(list, w, h);
+    lv_obj_set_scroll_dir(list, LV_DIR_VER);
+    lv_obj_set_user_data(list, vl);
+    lv_obj_add_event_cb(list, vlist_event, LV_EVENT_SCROLL, nullptr);
+    lv_obj_add_event_cb(list, vlist_event, LV_EVENT_DELETE, nullptr);
+    if (style_cb) style_cb(list);
+
+    vl->spacer = lv_obj_create(list);
+    lv_obj_remove_style_all(vl->spacer);
+    lv_obj_set_size(vl->spacer, 1, 0);
+    lv_obj_clear_flag(vl->spacer, LV_OBJ_FLAG_CLICKABLE);
+
+    for (size_t r = 0; r < vl->pool; ++r) {
+        lv_obj_t* row = lv_list_add_btn(list, icon, "");
+        lv_obj_set_size(row, lv_pct(100), row_h);
+        lv_obj_add_flag(row, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_add_event_cb(row, vlist_row_clicked, LV_EVENT_CLICKED, nullptr);
+
+        // No marquee: a scrolling label would keep the display refreshing.
+        lv_label_set_long_mode(lv_obj_get_child(row, -1), LV_LABEL_LONG_DOT);
+
+        vl->rows[r]  = row;
+        vl->bound[r] = VLIST_UNBOUND;
+    }
+
+    vlist_set_window(vl);
+    return list;
+}
+
+void ui_vlist_set_count(lv_obj_t* list, size_t count) {
+    VList* vl = vlist_of(list);
+    if (!vl) return;
+
+    vl->count = count;
+    vlist_set_window(vl);
+    for (size_t r = 0; r < vl->pool; ++r) {
+        lv_obj_add_flag(vl->rows[r], LV_OBJ_FLAG_HIDDEN);
+        vl->bound[r] = VLIST_UNBOUND;
+    }
+
+    // Pull the view back if the list got shorter than the scroll offset.
+    lv_obj_update_layout(list);
+    const lv_coord_t past_end = lv_obj_get_scroll_bottom(list);
+    if (past_end < 0) {
+        vl->shifting = true;
+        lv_obj_scroll_by(list, 0, -past_end, LV_ANIM_OFF);
+        vl->shifting = false;
+    }
+
+    vlist_bind(list, vl, true);
+}
+
+size_t ui_vlist_get_count(lv_obj_t* list) {
+    VList* vl = vlist_of(list);
+    return vl ? vl->count : 0;
+}
+
+void ui_vlist_refresh_item(lv_obj_t* list, size_t index) {
+    VList* vl = vlist_of(list);
+    if (!vl || index >= vl->count) return;
+
+    const size_t r = index % vl->pool;
+    if (vl->bound[r] == index) vlist_draw_row(vl, r, index);
+}
+
+size_t ui_vlist_pool_size(lv_obj_t* list) {
+    VList* vl = vlist_of(list);
+    return vl ? vl->pool : 0;
+}
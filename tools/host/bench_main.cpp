@@ -0,0 +1,56 @@
+// Host driver for the kfd_bench.cpp suites. With no arguments every suite
+// runs; otherwise only the named ones, e.g. `kfd_bench hex frame`.
+
+#include <string.h>
+
+#include "kfd_bench.h"
+
+static bool wanted(int argc, char** argv, const char* suite) {
+    if (argc < 2) return true;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], suite) == 0) return true;
+    }
+    return false;
+}
+
+int main(int argc, char** argv) {
+    if (wanted(argc, argv, "frame")) kfdRunFrameBench(20000);
+    if (wanted(argc, argv, "hex")) kfdRunHexBench(200000);
+
+    if (wanted(argc, argv, "keyload")) {
+        const KeyContainer kc = kfdBenchContainer(150, 0x1234);
+        KfdBenchResult     r;
+
+        KfdEmulatorConfig clean;
+        if (kfdRunBench(kc, clean, 5, 3, r)) kfdPrintBench("clean", r);
+
+        KfdEmulatorConfig nak;
+        nak.nakPerMille = 5;
+        if (kfdRunBench(kc, nak, 5, 3, r)) kfdPrintBench("nak 0.5%", r);
+
+        KfdEmulatorConfig ber;
+        ber.bitErrorsPerMillion = 20;
+        if (kfdRunBench(kc, ber, 5, 3, r)) kfdPrintBench("ber 20 ppm", r);
+    }
+
+    KfdEmulatorConfig slow;
+    slow.responseLatencyUs = 2000;
+
+    if (wanted(argc, argv, "parallel")) {
+        const KeyContainer kc = kfdBenchContainer(150, 0x1234);
+        kfdPrintParallelBench(kc, 1, kfdRunParallelBench(kc, slow, 1));
+        kfdPrintParallelBench(kc, 4, kfdRunParallelBench(kc, slow, 4));
+    }
+
+    if (wanted(argc, argv, "delta")) {
+        kfdRunDeltaBench(kfdBenchContainer(40, 0x77), slow, 3);
+        KfdEmulatorConfig no_inventory = slow;
+        no_inventory.inventorySupported = false;
+        kfdRunDeltaBench(kfdBenchContainer(40, 0x77), no_inventory, 3);
+    }
+
+    if (wanted(argc, argv, "clock")) kfdRunClockBench(kfdBenchContainer(40, 0x99));
+    if (wanted(argc, argv, "trace")) kfdRunTraceBench(kfdBenchContainer(20, 0x55), 20);
+    if (wanted(argc, argv, "dli")) kfdRunDliBench(kfdBenchContainer(40, 0x3C), 2000, 20);
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Host loopback check for KfdDliTransport: a datagram answering a pending
+// seq must only be taken from the configured peer. A raw socket plays the
+// radio; a second socket on the same host forges the answer first.
+
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "kfd_dli.h"
+#include "kfd_frame.h"
+
+static const uint16_t PORT = KFD_DLI_DEFAULT_PORT + 1;
+
+static int udpSocket(uint16_t port) {
+    const int s = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in a;
+    memset(&a, 0, sizeof(a));
+    a.sin_family      = AF_INET;
+    a.sin_port        = htons(port);
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (s < 0 || bind(s, (const sockaddr*)&a, sizeof(a)) != 0) return -1;
+    timeval tv = { 1, 0 };
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    return s;
+}
+
+// [version][seq BE16][frame] answering seq with a one-byte payload.
+static size_t answer(uint16_t seq, uint8_t value, uint8_t* d) {
+    d[0] = KFD_DLI_VERSION;
+    d[1] = (uint8_t)(seq >> 8);
+    d[2] = (uint8_t)seq;
+    return KFD_DLI_HEADER + kfdFrameEncode(&value, 1, d + KFD_DLI_HEADER, KFD_DLI_MAX_DATAGRAM - KFD_DLI_HEADER);
+}
+
+static KfdTransport::RxStatus poll(KfdDliTransport& dli, uint8_t* buf, size_t& len, uint16_t& tag) {
+    KfdTransport::RxStatus st = KfdTransport::RX_NONE;
+    for (int i = 0; i < 100 && st == KfdTransport::RX_NONE; ++i) {
+        st = dli.receive(buf, 16, len, tag);
+        if (st == KfdTransport::RX_NONE) usleep(1000);
+    }
+    return st;
+}
+
+int main() {
+    const int radio    = udpSocket(PORT);
+    const int intruder = udpSocket(0);
+    if (radio < 0 || intruder < 0) {
+        printf("dli_check: cannot bind loopback sockets\n");
+        return 1;
+    }
+
+    KfdDliConfig cfg;
+    cfg.port  = PORT;
+    cfg.rtoUs = 10000000;  // no retransmits during the check
+    KfdDliTransport dli(cfg);
+    dli.open();
+
+    const uint8_t key = 0x42;
+    dli.send(&key, 1, 7);
+
+    uint8_t     d[KFD_DLI_MAX_DATAGRAM];
+    sockaddr_in from;
+    socklen_t   fromLen = sizeof(from);
+    if (recvfrom(radio, d, sizeof(d), 0, (sockaddr*)&from, &fromLen) <= (ssize_t)KFD_DLI_HEADER) {
+        printf("dli_check: the radio saw no datagram\n");
+        return 1;
+    }
+    const uint16_t seq = (uint16_t)((d[1] << 8) | d[2]);
+
+    int     failures = 0;
+    uint8_t buf[16];
+    size_t  len = 0;
+    uint16_t tag = 0;
+
+    size_t n = answer(seq, 0xEE, d);
+    sendto(intruder, d, n, 0, (const sockaddr*)&from, sizeof(from));
+    const KfdTransport::RxStatus forged = poll(dli, buf, len, tag);
+    printf("  forged answer from another port   %s\n", forged == KfdTransport::RX_NONE ? "ignored" : "ACCEPTED");
+    if (forged != KfdTransport::RX_NONE) failures++;
+
+    n = answer(seq, 0x5A, d);
+    sendto(radio, d, n, 0, (const sockaddr*)&from, sizeof(from));
+    const KfdTransport::RxStatus real = poll(dli, buf, len, tag);
+    const bool ok = real == KfdTransport::RX_FRAME && tag == 7 && len == 1 && buf[0] == 0x5A;
+    printf("  answer from the peer              %s\n", ok ? "accepted" : "MISSED");
+    if (!ok) failures++;
+
+    dli.close();
+    close(radio);
+    close(intruder);
+    printf("dli_check: %s\n", failures ? "FAIL" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+// Host driver for ContainerSearch over the real ContainerModel (RAM-only:
+// LittleFS never mounts on the host). Times the index build and a typical
+// query over a large library, then makes edits through the model and
+// checks after each dispatch that every container is still found by its
+// own label.
+
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+
+#include "container_model.h"
+#include "container_search.h"
+
+static const size_t CONTAINERS = 1000;
+
+static uint32_t elapsedUs(std::chrono::steady_clock::time_point t0) {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - t0).count();
+}
+
+static KeyContainer makeContainer(size_t i) {
+    static const char* const AGENCIES[] = { "Plantation FD", "Broward SO", "Miami PD", "Coral Springs PD" };
+
+    char         buf[32];
+    KeyContainer kc;
+    snprintf(buf, sizeof(buf), "Zone %u Tac", (unsigned)i);
+    kc.label  = buf;
+    kc.agency = AGENCIES[i % 4];
+    kc.band   = i % 2 ? "700/800" : "VHF";
+    kc.algo   = "AES256";
+    kc.locked = false;
+
+    KeySlot ks;
+    snprintf(buf, sizeof(buf), "TG %u Patrol", (unsigned)(i * 7));
+    ks.label    = buf;
+    ks.algo     = "AES256";
+    ks.selected = true;
+    kc.keys.push_back(ks);
+    return kc;
+}
+
+static void show(const char* query) {
+    const ContainerModel& model = ContainerModel::instance();
+    std::vector<uint16_t> hits;
+    const size_t          n = ContainerSearch::instance().find(query, hits, 4);
+    printf("  %-12s %4u:", query, (unsigned)n);
+    for (uint16_t i : hits) printf(" \"%s\"", model.get(i).label.c_str());
+    printf("\n");
+}
+
+// Every container must come back for its own label, and nothing else
+// may be indexed.
+static bool consistent(const char* step) {
+    ContainerModel&       model = ContainerModel::instance();
+    std::vector<uint16_t> hits;
+    model.dispatchEvents();
+    if (ContainerSearch::instance().find("", hits) != model.getCount()) {
+        printf("  %-28s FAIL: %u indexed, %u in the model\n", step, (unsigned)hits.size(),
+               (unsigned)model.getCount());
+        return false;
+    }
+    for (size_t i = 0; i < model.getCount(); ++i) {
+        ContainerSearch::instance().find(model.get(i).label.c_str(), hits);
+        if (!std::binary_search(hits.begin(), hits.end(), (uint16_t)i)) {
+            printf("  %-28s FAIL: \"%s\" (%u) not found\n", step, model.get(i).label.c_str(), (unsigned)i);
+            return false;
+        }
+    }
+    printf("  %-28s ok\n", step);
+    return true;
+}
+
+int main() {
+    ContainerModel& model = ContainerModel::instance();
+    model.loadDefaults();
+    for (size_t i = model.getCount(); i < CONTAINERS; ++i) model.addContainer(makeContainer(i));
+    model.dispatchEvents();
+
+    auto t0 = std::chrono::steady_clock::now();
+    ContainerSearch::instance().begin();
+    printf("search: %u containers, index build %u us, %u postings\n", (unsigned)model.getCount(),
+           (unsigned)elapsedUs(t0), (unsigned)ContainerSearch::instance().postingCount());
+
+    std::vector<uint16_t> hits;
+    const int             QUERIES = 1000;
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < QUERIES; ++i) ContainerSearch::instance().find("pd zone 1", hits, 50);
+    printf("  query \"pd zone 1\": %u us\n", (unsigned)(elapsedUs(t0) / QUERIES));
+
+    show("");
+    show("zone 12");
+    show("fd 99");
+    show("patrol 70");
+    show("700/");
+    show("miami vhf");
+    show("xyz");
+
+    int failures = 0;
+    KeyContainer kc = model.get(5);
+    kc.label        = "Alpha Bravo";
+    model.updateContainer(5, kc);
+    failures += !consistent("update container 5");
+
+    model.deleteContainer(2);
+    model.deleteContainer(2);
+    failures += !consistent("delete 2 twice");
+
+    model.moveContainer(3, 0);
+    model.moveContainer(3, 0);
+    failures += !consistent("move 3 -> 0 twice");
+
+    kc          = makeContainer(CONTAINERS);
+    kc.label    = "Delta";
+    model.addContainer(kc);
+    KeySlot ks  = model.get(10).keys[0];
+    ks.label    = "Fire Ops";
+    model.updateKey(10, 0, ks);
+    failures += !consistent("add, then rename a key");
+
+    for (int i = 0; i < 40; ++i) model.moveContainer(0, model.getCount() - 1);
+    failures += !consistent("40 moves (collapse to reload)");
+
+    show("alpha");
+    show("delta");
+    show("fire");
+
+    printf("search: %s\n", failures ? "FAIL" : "ok");
+    return failures ? 1 : 0;
+}
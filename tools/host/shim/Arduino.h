@@ -0,0 +1,89 @@
+#pragma once
+
+// Just enough of the Arduino core for the portable firmware modules to
+// build and run on Linux. Timing comes from std::chrono; GPIO is inert.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "WString.h"
+
+#define HIGH 1
+#define LOW  0
+
+#define INPUT        0
+#define OUTPUT       1
+#define INPUT_PULLUP 2
+
+// Print.h defines these too; keeping them here catches name clashes.
+#define DEC 10
+#define HEX 16
+
+#define IRAM_ATTR
+
+struct Print {
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+
+    size_t write(const uint8_t* b, size_t n) {
+        for (size_t i = 0; i < n; ++i) write(b[i]);
+        return n;
+    }
+    size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t println(const char* s = "") { return print(s) + write((uint8_t)'\n'); }
+    size_t printf(const char* fmt, ...) {
+        char    buf[512];
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+        va_end(ap);
+        if (n < 0) return 0;
+        return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+    }
+};
+
+struct Stream : Print {
+    virtual int available() = 0;
+    virtual int read() = 0;
+
+    size_t readBytes(uint8_t* b, size_t n) {
+        size_t i = 0;
+        while (i < n) {
+            int c = read();
+            if (c < 0) break;
+            b[i++] = (uint8_t)c;
+        }
+        return i;
+    }
+};
+
+// Serial is stdout; nothing is ever received.
+struct HostSerial : Stream {
+    using Print::write;
+    void   begin(unsigned long) {}
+    size_t write(uint8_t b) override { return fwrite(&b, 1, 1, stdout); }
+    int    available() override { return 0; }
+    int    read() override { return -1; }
+    void   flush() { fflush(stdout); }
+    operator bool() const { return true; }
+};
+extern HostSerial Serial;
+
+struct EspClass {
+    uint32_t getCycleCount();  // scaled to a 240 MHz core
+    uint64_t getEfuseMac() { return 0x24DCC3A1B2C3ull; }
+};
+extern EspClass ESP;
+
+uint32_t getCpuFrequencyMhz();
+uint32_t millis();
+uint32_t micros();
+void     delay(uint32_t ms);
+void     delayMicroseconds(uint32_t us);
+void     pinMode(int pin, int mode);
+void     digitalWrite(int pin, int value);
+int      digitalRead(int pin);
@@ -0,0 +1,18 @@
+#pragma once
+
+// No filesystem on the host: every File is closed and reads nothing.
+
+#include "Arduino.h"
+
+#define FILE_READ  "r"
+#define FILE_WRITE "w"
+
+class File : public Print {
+public:
+    using Print::write;
+    size_t write(uint8_t) override { return 0; }
+    int    available() { return 0; }
+    String readStringUntil(char) { return String(); }
+    void   close() {}
+    explicit operator bool() const { return false; }
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+// LittleFS never mounts on the host, so ContainerModel stays RAM-only.
+
+#include "FS.h"
+
+class LittleFSFS {
+public:
+    bool begin(bool = false) { return false; }
+    bool exists(const char*) { return false; }
+    File open(const char*, const char*) { return File(); }
+    bool format() { return false; }
+};
+extern LittleFSFS LittleFS;
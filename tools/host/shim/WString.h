@@ -0,0 +1,37 @@
+#pragma once
+
+// The parts of Arduino's String that container_model.cpp uses.
+
+#include <stdlib.h>
+#include <string>
+
+class String {
+public:
+    String() {}
+    String(const char* s) : s_(s ? s : "") {}
+    String(const std::string& s) : s_(s) {}
+
+    const char*  c_str() const { return s_.c_str(); }
+    unsigned int length() const { return (unsigned int)s_.size(); }
+    char         charAt(unsigned int i) const { return i < s_.size() ? s_[i] : 0; }
+    long         toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+    bool         startsWith(const char* p) const { return s_.compare(0, strlen(p), p) == 0; }
+
+    int indexOf(char c, unsigned int from = 0) const {
+        const size_t i = s_.find(c, from);
+        return i == std::string::npos ? -1 : (int)i;
+    }
+    String substring(unsigned int from) const { return from < s_.size() ? String(s_.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        return from < to && from < s_.size() ? String(s_.substr(from, to - from)) : String();
+    }
+
+    void trim() {
+        const size_t b = s_.find_first_not_of(" \t\r\n");
+        const size_t e = s_.find_last_not_of(" \t\r\n");
+        s_ = b == std::string::npos ? std::string() : s_.substr(b, e - b + 1);
+    }
+
+private:
+    std::string s_;
+};
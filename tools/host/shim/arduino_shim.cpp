@@ -0,0 +1,34 @@
+#include "Arduino.h"
+#include "LittleFS.h"
+
+#include <chrono>
+#include <thread>
+
+HostSerial Serial;
+EspClass   ESP;
+LittleFSFS LittleFS;
+
+static const auto start = std::chrono::steady_clock::now();
+
+static uint64_t elapsedNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start).count();
+}
+
+uint32_t micros() { return (uint32_t)(elapsedNs() / 1000); }
+uint32_t millis() { return (uint32_t)(elapsedNs() / 1000000); }
+
+void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+void delayMicroseconds(uint32_t us) {
+    const uint32_t t0 = micros();
+    while (micros() - t0 < us) {
+    }
+}
+
+void pinMode(int, int) {}
+void digitalWrite(int, int) {}
+int  digitalRead(int) { return 0; }
+
+uint32_t EspClass::getCycleCount() { return (uint32_t)(elapsedNs() * 240 / 1000); }
+uint32_t getCpuFrequencyMhz() { return 240; }
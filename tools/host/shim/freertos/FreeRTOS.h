@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int      BaseType_t;
+typedef void*    TaskHandle_t;
+
+#define pdPASS 1
+#define pdTRUE 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+// No scheduler on the host: tasks are never created and waits return at
+// once. Drivers call the code a task would run directly.
+
+typedef void (*TaskFunction_t)(void*);
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*, int,
+                                          TaskHandle_t*, int) {
+    return pdPASS;
+}
+inline void     xTaskNotifyGive(TaskHandle_t) {}
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+inline void     vTaskDelay(TickType_t) {}
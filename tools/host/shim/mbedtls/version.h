@@ -0,0 +1,4 @@
+#pragma once
+
+// The host stand-in follows the mbedTLS 3 API (ESP-IDF 5).
+#define MBEDTLS_VERSION_NUMBER 0x03000000
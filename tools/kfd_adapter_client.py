@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""Talk to the keyloader in KFDtool adapter mode (-DKFD_ADAPTER_MODE=1).
+
+Usage:
+    kfd_adapter_client.py PORT info          # versions, model, IDs, self test
+    kfd_adapter_client.py PORT ready         # key signature + READY_REQ exchange
+    kfd_adapter_client.py PORT bench [N]     # N key frames, per byte vs bulk
+
+PORT is the USB CDC device (/dev/ttyACM0) or, on the host, the pty printed
+by the adapter harness. Only the standard library is used; the port is put
+in raw mode and the line rate is ignored by USB CDC.
+
+Packets are 0x61 body 0x61, with 0x61/0x63 escaped as 0x63 0x62/0x63 0x64
+(src/kfd_adapter.cpp). Line bytes use the keyloader's own frame format:
+SOF 0x7E, LEN (big-endian 16), payload, CRC-16/CCITT-FALSE over LEN +
+payload, as in kfd_vcd_decode.py.
+"""
+
+import os
+import select
+import sys
+import termios
+import time
+import tty
+
+SOM_EOM, SOM_EOM_PH, ESC, ESC_PH = 0x61, 0x62, 0x63, 0x64
+
+CMD_READ, CMD_RESET, CMD_SELF_TEST = 0x11, 0x14, 0x15
+CMD_SEND_KEY_SIG, CMD_SEND_BYTE = 0x16, 0x17
+RSP_ERROR, BCST_RECEIVE_BYTE = 0x20, 0x31
+
+READ_ITEMS = {0x01: "adapter protocol", 0x02: "firmware", 0x03: "unique id",
+              0x04: "model", 0x05: "hardware rev", 0x06: "serial"}
+
+SOF = 0x7E
+READY_REQ, READY_GENERAL_MODE, KMM = 0xC0, 0xD0, 0xC2
+
+
+def crc16(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def encode_frame(payload):
+    body = bytes([len(payload) >> 8, len(payload) & 0xFF]) + bytes(payload)
+    crc = crc16(body)
+    return bytes([SOF]) + body + bytes([crc >> 8, crc & 0xFF])
+
+
+class Adapter:
+    def __init__(self, path):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        tty.setraw(self.fd)
+        attrs = termios.tcgetattr(self.fd)
+        attrs[4] = attrs[5] = termios.B921600
+        termios.tcsetattr(self.fd, termios.TCSANOW, attrs)
+        self.buf = bytearray()
+        self.line = bytearray()  # bytes broadcast from the radio
+
+    def send(self, body):
+        out = bytearray([SOM_EOM])
+        for b in body:
+            if b == SOM_EOM:
+                out += bytes([ESC, SOM_EOM_PH])
+            elif b == ESC:
+                out += bytes([ESC, ESC_PH])
+            else:
+                out.append(b)
+        out.append(SOM_EOM)
+        os.write(self.fd, bytes(out))
+
+    def _packet(self, timeout):
+        """Next packet body, or None on timeout."""
+        end = time.monotonic() + timeout
+        while True:
+            while self.buf.count(SOM_EOM) >= 2:
+                start = self.buf.index(SOM_EOM)
+                stop = self.buf.index(SOM_EOM, start + 1)
+                raw = self.buf[start + 1:stop]
+                del self.buf[:stop + 1]
+                if not raw:
+                    self.buf.insert(0, SOM_EOM)  # back-to-back: EOM was a SOM
+                    continue
+                body = bytearray()
+                it = iter(raw)
+                for b in it:
+                    if b == ESC:
+                        b = SOM_EOM if next(it, None) == SOM_EOM_PH else ESC
+                    body.append(b)
+                return bytes(body)
+            left = end - time.monotonic()
+            if left <= 0 or not select.select([self.fd], [], [], left)[0]:
+                return None
+            self.buf += os.read(self.fd, 4096)
+
+    def response(self, timeout=1.0):
+        """Response to the last command; radio bytes go to self.line."""
+        while True:
+            p = self._packet(timeout)
+            if p is None:
+                raise TimeoutError("no response from adapter")
+            if p[0] == BCST_RECEIVE_BYTE and len(p) == 3:
+                self.line.append(p[2])
+                continue
+            if p[0] == RSP_ERROR:
+                raise RuntimeError("adapter error %02X" % p[1])
+            return p
+
+    def command(self, body, timeout=1.0):
+        self.send(body)
+        return self.response(timeout)
+
+    def line_frame(self, timeout=1.0):
+        """Next frame the radio sent, as a payload (None on timeout)."""
+        end = time.monotonic() + timeout
+        while True:
+            if SOF in self.line:
+                del self.line[:self.line.index(SOF)]
+                if len(self.line) >= 3:
+                    n = (self.line[1] << 8) | self.line[2]
+                    if len(self.line) >= n + 5:
+                        frame = bytes(self.line[:n + 5])
+                        del self.line[:n + 5]
+                        if crc16(frame[1:n + 3]) != (frame[n + 3] << 8 | frame[n + 4]):
+                            raise RuntimeError("radio frame failed CRC")
+                        return frame[3:n + 3]
+            left = end - time.monotonic()
+            if left <= 0:
+                return None
+            p = self._packet(left)
+            if p and p[0] == BCST_RECEIVE_BYTE and len(p) == 3:
+                self.line.append(p[2])
+
+    def write_line(self, data, bulk):
+        if bulk:
+            self.command(bytes([CMD_SEND_BYTE, 0]) + data)
+        else:
+            for b in data:
+                self.command(bytes([CMD_SEND_BYTE, 0, b]))
+
+
+def cmd_info(ad):
+    for item, name in READ_ITEMS.items():
+        rsp = ad.command(bytes([CMD_READ, item]))
+        data = rsp[2:]
+        text = data.decode() if item == 0x06 else " ".join("%02X" % b for b in data)
+        print("%-17s %s" % (name, text))
+    rsp = ad.command(bytes([CMD_SELF_TEST]))
+    print("%-17s %s" % ("self test", "pass" if rsp[1] == 0 else "FAIL %02X" % rsp[1]))
+
+
+def cmd_ready(ad):
+    ad.command(bytes([CMD_SEND_KEY_SIG, 0]))
+    t0 = time.monotonic()
+    ad.write_line(encode_frame([READY_REQ]), bulk=False)
+    rsp = ad.line_frame()
+    us = (time.monotonic() - t0) * 1e6
+    ad.command(bytes([CMD_RESET]))
+    if not rsp or rsp[0] != READY_GENERAL_MODE:
+        print("READY_REQ: no READY_GENERAL_MODE answer")
+        return 1
+    radio_id = int.from_bytes(rsp[1:5], "big") if len(rsp) >= 5 else 0
+    print("READY_REQ answered in %.0f us, radio id %08X" % (us, radio_id))
+    return 0
+
+
+def cmd_bench(ad, count):
+    frames = [encode_frame([KMM, 0, i + 1, 0x84, 32] + [(i * 7 + j) & 0xFF for j in range(32)])
+              for i in range(count)]
+    for bulk in (False, True):
+        ad.command(bytes([CMD_SEND_KEY_SIG, 0]))
+        t0 = time.monotonic()
+        for f in frames:
+            ad.write_line(f, bulk)
+            rsp = ad.line_frame()
+            if not rsp or rsp[0] != KMM:
+                print("key frame not acknowledged")
+                return 1
+        s = time.monotonic() - t0
+        ad.command(bytes([CMD_RESET]))
+        nbytes = sum(len(f) for f in frames)
+        print("%-8s %3d key frames  %7.1f ms  %6.1f keys/s  %7.0f line B/s"
+              % ("bulk" if bulk else "per byte", count, s * 1e3, count / s, nbytes / s))
+    return 0
+
+
+def main(argv):
+    if len(argv) < 3:
+        print(__doc__.strip())
+        return 2
+    ad = Adapter(argv[1])
+    if argv[2] == "info":
+        cmd_info(ad)
+        return 0
+    if argv[2] == "ready":
+        return cmd_ready(ad)
+    if argv[2] == "bench":
+        return cmd_bench(ad, int(argv[3]) if len(argv) > 3 else 20)
+    print(__doc__.strip())
+    return 2
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
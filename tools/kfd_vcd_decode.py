@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+"""Decode a KFD 3WI line trace (VCD) back into frames.
+
+Usage:
+    kfd_vcd_decode.py trace.vcd
+
+The VCD comes from KfdLineTrace::writeVcd() ("trace dump" on the console,
+or /kfd_trace.vcd on SD via "trace save"). DATA is sampled on every rising
+CLK edge while EN is high, MSB first, and the byte stream is split into
+frames: SOF 0x7E, LEN (big-endian 16), payload, CRC-16/CCITT-FALSE over
+LEN + payload. Each frame is printed with its timestamp and CRC verdict.
+A serial capture with other text around the VCD is fine.
+"""
+
+import sys
+
+SOF = 0x7E
+MAX_PAYLOAD = 64
+
+
+def crc16(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def read_bits(lines):
+    """Yield (time_ns, bit) for each DATA sample on a rising CLK with EN high."""
+    ids = {}
+    level = {"DATA": 0, "CLK": 0, "EN": 0}
+    t = 0
+    in_defs = True
+    for raw in lines:
+        line = raw.strip()
+        if not line:
+            continue
+        if in_defs:
+            parts = line.split()
+            if parts[0] == "$var" and len(parts) >= 5:
+                ids[parts[3]] = parts[4]
+            elif parts[0] == "$enddefinitions":
+                in_defs = False
+            continue
+        if line[0] == "#":
+            try:
+                t = int(line[1:])
+            except ValueError:
+                pass
+            continue
+        if line[0] in "01" and line[1:] in ids:
+            name = ids[line[1:]]
+            value = int(line[0])
+            if name == "CLK" and value == 1 and level["CLK"] == 0 and level["EN"]:
+                yield t, level["DATA"]
+            level[name] = value
+
+
+def read_bytes(bits):
+    acc = 0
+    n = 0
+    start = 0
+    for t, b in bits:
+        if n == 0:
+            start = t
+        acc = (acc << 1) | b
+        n += 1
+        if n == 8:
+            yield start, acc
+            acc = 0
+            n = 0
+
+
+def decode(lines):
+    buf = []
+    frames = 0
+    bad = 0
+    for t, byte in read_bytes(read_bits(lines)):
+        if not buf and byte != SOF:
+            print("%12.3f us  stray byte %02X" % (t / 1000.0, byte))
+            continue
+        buf.append((t, byte))
+        if len(buf) < 3:
+            continue
+        length = (buf[1][1] << 8) | buf[2][1]
+        if length > MAX_PAYLOAD:
+            print("%12.3f us  bad length %u" % (buf[0][0] / 1000.0, length))
+            bad += 1
+            buf = []
+            continue
+        if len(buf) < 3 + length + 2:
+            continue
+
+        raw = bytes(b for _, b in buf)
+        payload = raw[3:3 + length]
+        rx_crc = (raw[3 + length] << 8) | raw[4 + length]
+        ok = crc16(raw[1:3 + length]) == rx_crc
+        frames += 1
+        bad += 0 if ok else 1
+        print("%12.3f us  len %2u  %s  %s" % (buf[0][0] / 1000.0, length,
+                                              "CRC OK " if ok else "CRC BAD",
+                                              payload.hex().upper()))
+        buf = []
+
+    if buf:
+        print("incomplete frame at end of capture (%u bytes)" % len(buf))
+    print("# %u frames, %u bad" % (frames, bad))
+
+
+def main():
+    if len(sys.argv) > 1:
+        with open(sys.argv[1], "r", errors="replace") as f:
+            decode(f)
+    else:
+        decode(sys.stdin)
+
+
+if __name__ == "__main__":
+    main()
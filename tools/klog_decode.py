@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""Decode a "klog dump" capture into text.
+
+Usage:
+    klog_decode.py capture.txt        # serial log containing a klog dump
+    pio device monitor | klog_decode.py
+
+Reads the KLOG BEGIN .. KLOG END block written by klogDump() (src/klog.cpp)
+and prints one line per entry in the same layout klogService() uses on the
+device. Everything outside the block is ignored.
+"""
+
+import re
+import struct
+import sys
+
+MODULES = ["KFD", "MODEL", "UI", "TOUCH"]
+LEVELS = "-EWIDV"
+
+# printf conversions klog allows: integer only, optional flags/width.
+SPEC = re.compile(r"%([-+ 0#]*)(\d*)(?:\.(\d+))?(?:hh|h|l|ll|z)?([diuxXc%])")
+
+
+def c_format(fmt, args):
+    out = []
+    pos = 0
+    argi = 0
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        value = args[argi] if argi < len(args) else 0
+        argi += 1
+        if conv in "di":
+            value = struct.unpack("<i", struct.pack("<I", value))[0]
+            conv = "d"
+        elif conv == "u":
+            conv = "d"
+        elif conv == "c":
+            value = chr(value & 0xFF)
+        spec = "%" + flags + width + ("." + prec if prec else "") + conv
+        out.append(spec % value)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def decode(lines):
+    fmts = {}
+    in_dump = False
+    for line in lines:
+        line = line.strip()
+        if line.startswith("KLOG BEGIN"):
+            in_dump = True
+            fmts.clear()
+            parts = line.split()
+            print("# %s entries, %s dropped" % (parts[2], parts[3]))
+            continue
+        if not in_dump:
+            continue
+        if line == "KLOG END":
+            in_dump = False
+            continue
+        if line.startswith("KLOGS "):
+            _, addr, text = line.split(" ", 2)
+            fmts[int(addr, 16)] = bytes.fromhex(text).decode("latin-1")
+        elif line.startswith("KLOGE "):
+            rec = bytes.fromhex(line.split(" ", 1)[1])
+            t_us, fmt_addr, module, level, argc, _pad = struct.unpack_from("<IIBBBB", rec, 0)
+            args = struct.unpack_from("<4I", rec, 12)[:argc]
+            fmt = fmts.get(fmt_addr, "<unknown format %08X>" % fmt_addr)
+            mod = MODULES[module] if module < len(MODULES) else "?"
+            lvl = LEVELS[level] if level < len(LEVELS) else "?"
+            print("%u.%06u %s [%s] %s" % (t_us // 1000000, t_us % 1000000, lvl, mod,
+                                          c_format(fmt, list(args))))
+
+
+def main():
+    if len(sys.argv) > 1:
+        with open(sys.argv[1], "r", errors="replace") as f:
+            decode(f)
+    else:
+        decode(sys.stdin)
+
+
+if __name__ == "__main__":
+    main()